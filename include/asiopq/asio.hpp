@@ -9,6 +9,38 @@
 #include "configure.hpp"
 
 
+//	io_uring is selected by ASIO configuration macros which the
+//	build exports to everything linking against the library so
+//	that every translation unit sees the same reactor.  They are
+//	only defined here for code which does not use those settings,
+//	in which case ASIO must not have been included already
+#ifdef ASIOPQ_USE_IO_URING
+#ifdef ASIOPQ_USE_BOOST_ASIO
+#if !(defined(BOOST_ASIO_HAS_IO_URING) && defined(BOOST_ASIO_DISABLE_EPOLL))
+#ifdef BOOST_ASIO_VERSION
+#error "asiopq was built with io_uring: Define BOOST_ASIO_HAS_IO_URING and BOOST_ASIO_DISABLE_EPOLL for every translation unit"
+#endif
+#define BOOST_ASIO_HAS_IO_URING
+#define BOOST_ASIO_DISABLE_EPOLL
+#endif
+#else
+#if !(defined(ASIO_HAS_IO_URING) && defined(ASIO_DISABLE_EPOLL))
+#ifdef ASIO_VERSION
+#error "asiopq was built with io_uring: Define ASIO_HAS_IO_URING and ASIO_DISABLE_EPOLL for every translation unit"
+#endif
+#define ASIO_HAS_IO_URING
+#define ASIO_DISABLE_EPOLL
+#endif
+#endif
+#endif
+
+
+//	When coroutines are enabled ASIO 1.18 (Boost 1.74)
+//	includes awaitable.hpp, which uses std::exchange without
+//	including <utility>
+#include <utility>
+
+
 #ifdef ASIOPQ_USE_BOOST_ASIO
 #ifndef BOOST_ASIO_HAS_STD_CHRONO
 #define BOOST_ASIO_HAS_STD_CHRONO
@@ -39,6 +71,15 @@
 #endif
 
 
+#ifdef ASIOPQ_USE_IO_URING
+#ifdef ASIOPQ_USE_BOOST_ASIO
+static_assert(BOOST_ASIO_VERSION>=102200,"io_uring requires Boost 1.78 or later");
+#else
+static_assert(ASIO_VERSION>=102200,"io_uring requires ASIO 1.22 or later");
+#endif
+#endif
+
+
 namespace asiopq {
 
 
@@ -0,0 +1,532 @@
+/**
+ *	\file
+ *
+ *	Initiating functions which follow the asio completion
+ *	token model, so that callers may choose to be notified
+ *	by callback, future (asio::use_future), coroutine, or
+ *	any other mechanism asio supports without the cost of
+ *	shared state they do not use.
+ */
+
+
+#pragma once
+
+
+#include "asio.hpp"
+#include "connect.hpp"
+#include "connection.hpp"
+#include "operation.hpp"
+#include "optional.hpp"
+#include "priority.hpp"
+#include "reset.hpp"
+#include <exception>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+
+namespace asiopq {
+
+
+	/**
+	 *	Binds a completion handler to the function which
+	 *	invokes it so that the pair may be submitted to an
+	 *	executor using the handler's associated allocator.
+	 *
+	 *	\tparam Handler
+	 *		The type of the completion handler.
+	 *	\tparam Function
+	 *		The type of a function object which accepts an
+	 *		rvalue of type \em Handler and invokes it.
+	 */
+	template <typename Handler, typename Function>
+	class handler_binder {
+
+
+		private:
+
+
+			Handler handler_;
+			Function function_;
+
+
+		public:
+
+
+			using allocator_type=asio::associated_allocator_t<Handler>;
+
+
+			handler_binder (Handler handler, Function function)
+				:	handler_(std::move(handler)),
+					function_(std::move(function))
+			{	}
+
+
+			allocator_type get_allocator () const noexcept {
+
+				return asio::get_associated_allocator(handler_);
+
+			}
+
+
+			void operator () () {
+
+				function_(std::move(handler_));
+
+			}
+
+
+	};
+
+
+	/**
+	 *	Submits a completion handler to its associated executor.
+	 *
+	 *	The handler is never invoked within this function.
+	 *	\ref operation::complete is invoked once the
+	 *	\ref connection has finished with the operation, either
+	 *	on a thread running the connection's asio::io_service or
+	 *	through its \ref connection::completion_executor, but it
+	 *	is also invoked from within the connection's destructor
+	 *	when the operation is aborted.  Posting ensures that the
+	 *	handler runs on its own associated executor and never
+	 *	within that destructor.
+	 *
+	 *	\param [in] executor
+	 *		The executor associated with \em handler.
+	 *	\param [in] handler
+	 *		The completion handler.
+	 *	\param [in] function
+	 *		A function object which accepts \em handler as an
+	 *		rvalue and invokes it.
+	 */
+	template <typename Executor, typename Handler, typename Function>
+	void post_handler (const Executor & executor, Handler handler, Function function) {
+
+		asio::post(
+			executor,
+			handler_binder<Handler,Function>(std::move(handler),std::move(function))
+		);
+
+	}
+
+
+	/**
+	 *	Allocates an operation using the allocator associated
+	 *	with a completion handler.
+	 *
+	 *	\tparam Operation
+	 *		The type of operation to allocate.
+	 *
+	 *	\param [in] handler
+	 *		The completion handler.
+	 *	\param [in] args
+	 *		Arguments to forward to the constructor of
+	 *		\em Operation.
+	 *
+	 *	\return
+	 *		A std::shared_ptr which owns the operation.
+	 */
+	template <typename Operation, typename Handler, typename... Args>
+	std::shared_ptr<Operation> allocate_operation (const Handler & handler, Args &&... args) {
+
+		using allocator_type=typename std::allocator_traits<
+			asio::associated_allocator_t<Handler>
+		>::template rebind_alloc<Operation>;
+
+		return std::allocate_shared<Operation>(
+			allocator_type(asio::get_associated_allocator(handler)),
+			std::forward<Args>(args)...
+		);
+
+	}
+
+
+	/**
+	 *	A \ref basic_connect which invokes a completion handler
+	 *	with the signature \em void(std::exception_ptr,connection).
+	 *
+	 *	The \ref connection is passed to the handler whether or
+	 *	not the attempt succeeds.
+	 *
+	 *	\tparam Handler
+	 *		The type of the completion handler.
+	 */
+	template <typename Handler>
+	class handler_connect : public basic_connect {
+
+
+		private:
+
+
+			using executor_type=asio::associated_executor_t<Handler,asio::io_service::executor_type>;
+
+
+			Handler handler_;
+			asio::executor_work_guard<executor_type> work_;
+			optional<asiopq::connection> conn_;
+
+
+		public:
+
+
+			handler_connect (Handler handler, asio::io_service & ios, const char * conninfo, timeout_type timeout)
+				:	basic_connect(conninfo,timeout),
+					handler_(std::move(handler)),
+					work_(asio::get_associated_executor(handler_,ios.get_executor()))
+			{	}
+
+
+			/**
+			 *	Creates the \ref connection and dispatches this
+			 *	operation thereupon.
+			 *
+			 *	\param [in] ios
+			 *		The asio::io_service the \ref connection shall
+			 *		use.
+			 */
+			void start (asio::io_service & ios) {
+
+				conn_.emplace(release(ios));
+				conn_->add(shared_from_this());
+
+			}
+
+
+			virtual void complete (std::exception_ptr ex) override {
+
+				//	This may be invoked from within the destructor
+				//	of the connection, which the handler must not
+				//	observe
+				auto executor=work_.get_executor();
+				work_.reset();
+				post_handler(
+					executor,
+					std::move(handler_),
+					[self=std::static_pointer_cast<handler_connect>(shared_from_this()),ex=std::move(ex)] (Handler handler) mutable {
+
+						asiopq::connection conn(std::move(*self->conn_));
+						self.reset();
+						std::move(handler)(std::move(ex),std::move(conn));
+
+					}
+				);
+
+			}
+
+
+	};
+
+
+	/**
+	 *	A \ref basic_reset which invokes a completion handler
+	 *	with the signature \em void(std::exception_ptr).
+	 *
+	 *	\tparam Handler
+	 *		The type of the completion handler.
+	 */
+	template <typename Handler>
+	class handler_reset : public basic_reset {
+
+
+		private:
+
+
+			using executor_type=asio::associated_executor_t<Handler,asio::io_service::executor_type>;
+
+
+			Handler handler_;
+			asio::executor_work_guard<executor_type> work_;
+
+
+		public:
+
+
+			handler_reset (Handler handler, asio::io_service & ios, timeout_type timeout)
+				:	basic_reset(timeout),
+					handler_(std::move(handler)),
+					work_(asio::get_associated_executor(handler_,ios.get_executor()))
+			{	}
+
+
+			virtual void complete (std::exception_ptr ex) override {
+
+				auto executor=work_.get_executor();
+				work_.reset();
+				post_handler(
+					executor,
+					std::move(handler_),
+					[ex=std::move(ex)] (Handler handler) mutable {	std::move(handler)(std::move(ex));	}
+				);
+
+			}
+
+
+	};
+
+
+	/**
+	 *	Invokes a completion handler with the signature
+	 *	\em void(std::exception_ptr) when an \ref operation
+	 *	is admitted by \ref connection::admit.
+	 *
+	 *	\tparam Handler
+	 *		The type of the completion handler.
+	 */
+	template <typename Handler>
+	class handler_admission {
+
+
+		private:
+
+
+			using executor_type=asio::associated_executor_t<Handler,asio::io_service::executor_type>;
+
+
+			Handler handler_;
+			asio::executor_work_guard<executor_type> work_;
+
+
+		public:
+
+
+			handler_admission (Handler handler, asio::io_service & ios)
+				:	handler_(std::move(handler)),
+					work_(asio::get_associated_executor(handler_,ios.get_executor()))
+			{	}
+
+
+			/**
+			 *	Submits the completion handler to its associated
+			 *	executor.  Must be invoked exactly once.
+			 *
+			 *	\param [in] ex
+			 *		The exception to pass to the completion handler.
+			 */
+			void complete (std::exception_ptr ex) {
+
+				auto executor=work_.get_executor();
+				work_.reset();
+				post_handler(
+					executor,
+					std::move(handler_),
+					[ex=std::move(ex)] (Handler handler) mutable {	std::move(handler)(std::move(ex));	}
+				);
+
+			}
+
+
+	};
+
+
+	/**
+	 *	Determines whether a type may be used as a completion
+	 *	token, i.e. whether it cannot be mistaken for an
+	 *	\ref operation::timeout_type.
+	 */
+	template <typename Token>
+	using enable_if_completion_token_t=std::enable_if_t<!std::is_convertible<std::decay_t<Token>,operation::timeout_type>::value>;
+
+
+	/**
+	 *	Connects to a Postgres database by calling PQconnectStart.
+	 *
+	 *	If PQconnectStart fails an exception is thrown and the
+	 *	completion handler is not invoked.
+	 *
+	 *	\param [in] conninfo
+	 *		See libpq documentation for PQconnectStart.
+	 *	\param [in] ios
+	 *		The asio::io_service which the created \ref connection
+	 *		shall use to dispatch asynchronous operations.  The
+	 *		completion handler is invoked using its associated
+	 *		executor, or this object if it has none.
+	 *	\param [in] timeout
+	 *		A \ref operation::timeout_type object giving the
+	 *		amount of time the attempt is permitted to take at
+	 *		maximum.
+	 *	\param [in] token
+	 *		A completion token whose signature is
+	 *		\em void(std::exception_ptr,connection).
+	 *
+	 *	\return
+	 *		As determined by \em token.
+	 */
+	template <typename CompletionToken>
+	auto async_connect (const char * conninfo, asio::io_service & ios, operation::timeout_type timeout, CompletionToken && token) {
+
+		return asio::async_initiate<CompletionToken,void (std::exception_ptr, connection)>(
+			[conninfo,&ios,timeout] (auto && handler) {
+
+				using handler_type=std::decay_t<decltype(handler)>;
+				auto op=allocate_operation<handler_connect<handler_type>>(
+					handler,
+					std::forward<decltype(handler)>(handler),
+					ios,
+					conninfo,
+					timeout
+				);
+				op->start(ios);
+
+			},
+			token
+		);
+
+	}
+	/**
+	 *	Connects to a Postgres database by calling PQconnectStart
+	 *	with no timeout.
+	 *
+	 *	\param [in] conninfo
+	 *		See libpq documentation for PQconnectStart.
+	 *	\param [in] ios
+	 *		The asio::io_service which the created \ref connection
+	 *		shall use.
+	 *	\param [in] token
+	 *		A completion token whose signature is
+	 *		\em void(std::exception_ptr,connection).
+	 *
+	 *	\return
+	 *		As determined by \em token.
+	 */
+	template <typename CompletionToken, typename=enable_if_completion_token_t<CompletionToken>>
+	auto async_connect (const char * conninfo, asio::io_service & ios, CompletionToken && token) {
+
+		return async_connect(conninfo,ios,operation::timeout_type{},std::forward<CompletionToken>(token));
+
+	}
+
+
+	/**
+	 *	Resets a connection by calling PQresetStart.
+	 *
+	 *	\param [in] conn
+	 *		The connection.  The completion handler is invoked
+	 *		using its associated executor, or the connection's
+	 *		asio::io_service if it has none.
+	 *	\param [in] timeout
+	 *		A \ref operation::timeout_type object giving the
+	 *		amount of time the reset is permitted to take at
+	 *		maximum.
+	 *	\param [in] token
+	 *		A completion token whose signature is
+	 *		\em void(std::exception_ptr).
+	 *
+	 *	\return
+	 *		As determined by \em token.
+	 */
+	template <typename CompletionToken>
+	auto async_reset (connection & conn, operation::timeout_type timeout, CompletionToken && token) {
+
+		return asio::async_initiate<CompletionToken,void (std::exception_ptr)>(
+			[&conn,timeout] (auto && handler) {
+
+				using handler_type=std::decay_t<decltype(handler)>;
+				conn.add(allocate_operation<handler_reset<handler_type>>(
+					handler,
+					std::forward<decltype(handler)>(handler),
+					conn.get_io_service(),
+					timeout
+				));
+
+			},
+			token
+		);
+
+	}
+	/**
+	 *	Resets a connection by calling PQresetStart with no
+	 *	timeout.
+	 *
+	 *	\param [in] conn
+	 *		The connection.
+	 *	\param [in] token
+	 *		A completion token whose signature is
+	 *		\em void(std::exception_ptr).
+	 *
+	 *	\return
+	 *		As determined by \em token.
+	 */
+	template <typename CompletionToken, typename=enable_if_completion_token_t<CompletionToken>>
+	auto async_reset (connection & conn, CompletionToken && token) {
+
+		return async_reset(conn,operation::timeout_type{},std::forward<CompletionToken>(token));
+
+	}
+
+
+	/**
+	 *	Enqueues an \ref operation on a connection once fewer
+	 *	than the limit (see \ref connection::limit) of operations
+	 *	are waiting to begin.
+	 *
+	 *	Completing when the operation has been enqueued rather
+	 *	than when it has completed allows callers to apply
+	 *	backpressure: A caller which does not accept more work
+	 *	until this completes cannot overrun the connection.
+	 *
+	 *	\param [in] conn
+	 *		The connection.  The completion handler is invoked
+	 *		using its associated executor, or the connection's
+	 *		asio::io_service if it has none.
+	 *	\param [in] op
+	 *		The \ref operation to execute on \em conn.
+	 *	\param [in] cls
+	 *		The class of priority of \em op.
+	 *	\param [in] token
+	 *		A completion token whose signature is
+	 *		\em void(std::exception_ptr).  The exception is
+	 *		\ref aborted if \em conn is destroyed before \em op
+	 *		is admitted.
+	 *
+	 *	\return
+	 *		As determined by \em token.
+	 */
+	template <typename CompletionToken>
+	auto async_add (connection & conn, connection::operation_type op, priority cls, CompletionToken && token) {
+
+		return asio::async_initiate<CompletionToken,void (std::exception_ptr)>(
+			[&conn,op=std::move(op),cls] (auto && handler) mutable {
+
+				using handler_type=std::decay_t<decltype(handler)>;
+				auto admission=allocate_operation<handler_admission<handler_type>>(
+					handler,
+					std::forward<decltype(handler)>(handler),
+					conn.get_io_service()
+				);
+				conn.admit(
+					std::move(op),
+					cls,
+					[admission=std::move(admission)] (std::exception_ptr ex) {	admission->complete(std::move(ex));	}
+				);
+
+			},
+			token
+		);
+
+	}
+	/**
+	 *	Enqueues an \ref operation with \ref priority::normal
+	 *	on a connection once fewer than the limit of operations
+	 *	are waiting to begin.
+	 *
+	 *	\param [in] conn
+	 *		The connection.
+	 *	\param [in] op
+	 *		The \ref operation to execute on \em conn.
+	 *	\param [in] token
+	 *		A completion token whose signature is
+	 *		\em void(std::exception_ptr).
+	 *
+	 *	\return
+	 *		As determined by \em token.
+	 */
+	template <typename CompletionToken>
+	auto async_add (connection & conn, connection::operation_type op, CompletionToken && token) {
+
+		return async_add(conn,std::move(op),priority::normal,std::forward<CompletionToken>(token));
+
+	}
+
+
+}
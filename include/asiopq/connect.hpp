@@ -18,27 +18,52 @@ namespace asiopq {
 
 
 	/**
-	 *	Represents the operation of connecting to a
-	 *	Postgres database.
+	 *	An abstract base class for the operation of
+	 *	connecting to a Postgres database.
+	 *
+	 *	Derived classes implement \ref operation::complete.
+	 *
+	 *	Objects of this type must be managed by a std::shared_ptr.
 	 */
-	class connect : public operation, public std::enable_shared_from_this<connect> {
+	class basic_connect : public operation, public std::enable_shared_from_this<basic_connect> {
 
 
 		private:
 
 
 			native_handle_type handle_;
-			promise<void> promise_;
 			timeout_type timeout_;
 
 
 			void init ();
 
 
+		protected:
+
+
+			/**
+			 *	Fetches a \ref asiopq::connection object without
+			 *	dispatching this operation thereupon.
+			 *
+			 *	The caller must add this operation to the returned
+			 *	object before adding any other.
+			 *
+			 *	\param [in] ios
+			 *		The asio::io_service which the created
+			 *		\ref asiopq::connection shall use to dispatch
+			 *		asynchronous operations.
+			 *
+			 *	\return
+			 *		An \ref asiopq::connection object with no pending
+			 *		operations.
+			 */
+			asiopq::connection release (asio::io_service & ios);
+
+
 		public:
 
 
-			connect () = delete;
+			basic_connect () = delete;
 
 
 			/**
@@ -57,7 +82,7 @@ namespace asiopq {
 			 *		take at maximum.  Defaults to no timeout which
 			 *		means this operation may take infinitely long.
 			 */
-			connect (const char * const * keywords, const char * const * values, int expand_dbname, timeout_type timeout=timeout_type{});
+			basic_connect (const char * const * keywords, const char * const * values, int expand_dbname, timeout_type timeout=timeout_type{});
 			/**
 			 *	Connects to a Postgres database by calling
 			 *	PQconnectStart.
@@ -70,13 +95,13 @@ namespace asiopq {
 			 *		take at maximum.  Defaults to no timeout which
 			 *		means this operation may take infinitely long.
 			 */
-			explicit connect (const char * conninfo, timeout_type timeout=timeout_type{});
+			explicit basic_connect (const char * conninfo, timeout_type timeout=timeout_type{});
 
 
 			/**
 			 *	Cleans up this operation.
 			 */
-			~connect () noexcept;
+			~basic_connect () noexcept;
 
 
 			/**
@@ -95,12 +120,36 @@ namespace asiopq {
 			asiopq::connection connection (asio::io_service & ios);
 
 
-			virtual void complete (std::exception_ptr) override;
 			virtual operation_status begin (native_handle_type) override;
 			virtual operation_status perform (native_handle_type, socket_status) override;
 			virtual timeout_type timeout () override;
 
 
+	};
+
+
+	/**
+	 *	Represents the operation of connecting to a
+	 *	Postgres database.
+	 */
+	class connect : public basic_connect {
+
+
+		private:
+
+
+			promise<void> promise_;
+
+
+		public:
+
+
+			using basic_connect::basic_connect;
+
+
+			virtual void complete (std::exception_ptr) override;
+
+
 			/**
 			 *	Retrieves a future which shall complete when this
 			 *	operation completes.
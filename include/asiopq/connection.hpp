@@ -7,19 +7,18 @@
 
 
 #include "asio.hpp"
+#include "errc.hpp"
+#include "notifier.hpp"
 #include "operation.hpp"
-#include <cstdint>
-#include <deque>
+#include "priority.hpp"
+#include "statistics.hpp"
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <functional>
 #include <memory>
-#include <mutex>
-#include <type_traits>
-
-
-#ifdef _WIN32
-#include <Winsock2.h>
-#else
-#include <sys/socket.h>
-#endif
+#include <string>
+#include <system_error>
 
 
 namespace asiopq {
@@ -29,6 +28,24 @@ namespace asiopq {
 	 *	Represents a libpq connection and allows
 	 *	\ref operation objects to be asynchronously
 	 *	run thereupon.
+	 *
+	 *	The state of the connection is only ever accessed
+	 *	from handlers running on an asio::io_service::strand,
+	 *	so the methods of \ref operation objects are never
+	 *	invoked concurrently (except as described by
+	 *	\ref completion_executor).  Member functions which may be
+	 *	called from other threads (e.g. \ref add) submit their
+	 *	work to that strand through a lock-free queue rather
+	 *	than acquiring a lock, and therefore they may be
+	 *	called from within the methods of \ref operation
+	 *	objects.
+	 *
+	 *	The connection waits on libpq's socket itself rather
+	 *	than on a duplicate and only checks whether libpq has
+	 *	replaced that socket while a \ref basic_connect or
+	 *	\ref basic_reset is running.  Operations which
+	 *	otherwise cause libpq to replace its socket (e.g. by
+	 *	calling PQresetStart) are not supported.
 	 */
 	class connection {
 
@@ -45,61 +62,34 @@ namespace asiopq {
 			 *	A smart pointer to an \ref operation.
 			 */
 			using operation_type=std::shared_ptr<operation>;
+			/**
+			 *	The type of the statistics gathered by a connection.
+			 */
+			using statistics_type=asiopq::statistics;
+			/**
+			 *	The type of a function which is invoked for each
+			 *	notification on a channel.
+			 */
+			using notification_handler=notifier::handler_type;
+			/**
+			 *	The type of a value which identifies a subscription
+			 *	to a channel.
+			 */
+			using subscription_type=notifier::subscription_type;
+			/**
+			 *	The type of a function which is invoked when an
+			 *	\ref operation passed to \ref admit is enqueued.
+			 */
+			using admission_handler=std::function<void (std::exception_ptr)>;
 
 
 		private:
 
 
-			class control {
-
-
-				private:
-
-
-					using mutex_type=std::mutex;
-					mutable std::mutex m_;
-					bool stop_;
-					connection * self_;
-
-
-				public:
+			class state;
 
 
-					asio::steady_timer timer;
-
-
-					control (connection &, asio::io_service &);
-
-
-					using guard_type=std::unique_lock<mutex_type>;
-					guard_type lock () const noexcept;
-					void stop () noexcept;
-					explicit operator bool () const noexcept;
-					void move (connection &) noexcept;
-					connection & self () const noexcept;
-
-
-			};
-
-
-			native_handle_type handle_;
-			asio::io_service & ios_;
-			operation_type op_;
-			std::deque<operation_type> pending_;
-			asio::ip::tcp::socket socket_;
-			std::shared_ptr<control> control_;
-			bool read_;
-			bool write_;
-			struct sockaddr_storage local_;
-
-
-			void update_socket ();
-			template <typename F>
-			auto wrap (F &&) noexcept(std::is_nothrow_move_constructible<F>::value);
-			void next ();
-			void begin ();
-			void dispatch (operation::operation_status);
-			void perform (operation::socket_status);
+			std::shared_ptr<state> state_;
 
 
 		public:
@@ -146,6 +136,11 @@ namespace asiopq {
 			/**
 			 *	Aborts all pending operations and cleans up the
 			 *	managed libpq handle.
+			 *
+			 *	If a handler of this connection is running on
+			 *	another thread this waits for it to return.  Must
+			 *	not be invoked from within the methods of an
+			 *	\ref operation object running on this connection.
 			 */
 			~connection () noexcept;
 
@@ -153,17 +148,343 @@ namespace asiopq {
 			/**
 			 *	Enqueues an \ref operation to execute on the connection.
 			 *
-			 *	\ref operation object's enqueued to a connection execute in
-			 *	FIFO order.
+			 *	\ref operation object's enqueued to a connection with the
+			 *	same \ref priority execute in FIFO order.  An operation of
+			 *	a higher class begins before operations of lower classes
+			 *	which are waiting, except that each waiting operation is
+			 *	treated as one class higher for each aging interval (see
+			 *	\ref aging) it has waited so that lower classes are not
+			 *	starved.  The time operations of each class spend waiting
+			 *	is reported by \ref statistics.
 			 *
 			 *	None of the \ref operation object's methods shall be invoked
 			 *	within this function.  All shall be invoked on threads running
 			 *	the connection object's associated asio::io_service.
 			 *
+			 *	If a limit has been set (see \ref limit) and that many
+			 *	operations are already waiting to begin \ref queue_full
+			 *	is thrown and \em op is not enqueued.
+			 *
+			 *	Enqueuing allocates nothing: \em op is linked into the
+			 *	connection's queues through members of \ref operation
+			 *	and keeps itself alive until it has been informed of
+			 *	its completion.  Therefore an operation must not be
+			 *	added again (to any connection) before then.
+			 *
+			 *	If \em op throws as it is enqueued (e.g. from
+			 *	\ref operation::timeout) it is informed of its
+			 *	completion with that exception and releases its
+			 *	place in the queue.
+			 *
 			 *	\param [in] op
 			 *		The \ref operation to execute on the connection.
+			 *	\param [in] cls
+			 *		The class of priority of \em op.  Defaults to
+			 *		\ref priority::normal.
+			 */
+			void add (operation_type op, priority cls=priority::normal);
+			/**
+			 *	Enqueues an \ref operation to execute on the connection,
+			 *	reporting rejection through a std::error_code rather
+			 *	than by throwing.
+			 *
+			 *	Identical to the overload which does not accept a
+			 *	std::error_code except that where that overload throws
+			 *	\ref queue_full \em ec is set to \ref errc::queue_full.
+			 *
+			 *	\param [in] op
+			 *		The \ref operation to execute on the connection.
+			 *	\param [in] cls
+			 *		The class of priority of \em op.
+			 *	\param [out] ec
+			 *		Set to indicate whether \em op was enqueued.
+			 */
+			void add (operation_type op, priority cls, std::error_code & ec);
+			/**
+			 *	Enqueues an \ref operation to execute on the connection
+			 *	once fewer than the limit (see \ref limit) of operations
+			 *	are waiting to begin.
+			 *
+			 *	Operations awaiting admission are admitted in the order
+			 *	they were passed to this function and their timeouts
+			 *	run from that moment.  If the connection is destroyed
+			 *	first \em handler is invoked with \ref aborted within
+			 *	the destructor and none of \em op's methods are
+			 *	invoked.
+			 *
+			 *	\param [in] op
+			 *		The \ref operation to execute on the connection.
+			 *	\param [in] cls
+			 *		The class of priority of \em op.
+			 *	\param [in] handler
+			 *		Invoked on a thread running the connection
+			 *		object's associated asio::io_service once \em op
+			 *		has been enqueued, by which time \em op may
+			 *		already have begun.
+			 */
+			void admit (operation_type op, priority cls, admission_handler handler);
+
+
+			/**
+			 *	Resumes an \ref operation which returned
+			 *	\ref operation::operation_status::suspend.
+			 *
+			 *	If \em op is not the current operation, or is not
+			 *	suspended, when the request to resume it is handled
+			 *	nothing happens.  Therefore a request made on behalf
+			 *	of an operation which has since finished never wakes
+			 *	another operation.
+			 *
+			 *	The operation's \ref operation::perform method is not
+			 *	invoked within this function, it is invoked (with
+			 *	\ref operation::socket_status::readable) on a thread
+			 *	running the connection object's associated
+			 *	asio::io_service.
+			 *
+			 *	\param [in] op
+			 *		The \ref operation to resume.
+			 */
+			void resume (operation_type op);
+
+
+			/**
+			 *	Enables or disables pipeline mode.
+			 *
+			 *	When pipeline mode is enabled consecutive \ref query
+			 *	objects at the head of the queue are sent to the server
+			 *	back-to-back using libpq's pipeline mode rather than
+			 *	each waiting for the previous to complete.  Each query
+			 *	is followed by its own synchronization point so that the
+			 *	failure of one query does not affect any other.
+			 *
+			 *	While pipelined only \ref query::send, \ref query::result,
+			 *	and \ref operation::complete are invoked and \ref query::send
+			 *	must only use libpq functions which are permitted in pipeline
+			 *	mode (e.g. PQsendQueryParams but not PQsendQuery).
+			 *	Operations which do not derive from \ref query wait for all
+			 *	pipelined queries to complete and then run exclusively
+			 *	as normal.
+			 *
+			 *	As with other operations timeouts of pipelined queries are
+			 *	measured from the moment they are enqueued.  When a pipelined
+			 *	query times out its results are discarded as they arrive and
+			 *	the connection remains usable.
+			 *
+			 *	Changes take effect for queries which have not yet been
+			 *	sent.  Pipeline mode is disabled by default.
+			 *
+			 *	This function does not acquire any locks.
+			 *
+			 *	\param [in] enable
+			 *		\em true to enable pipeline mode, \em false to
+			 *		disable it.
+			 */
+			void pipeline (bool enable);
+			/**
+			 *	Determines whether pipeline mode is enabled.
+			 *
+			 *	\return
+			 *		\em true if pipeline mode is enabled, \em false
+			 *		otherwise.
+			 */
+			bool pipeline () const noexcept;
+
+
+			/**
+			 *	Configures the cache of statements prepared by
+			 *	\ref prepared_query objects.
+			 *
+			 *	Statements are evicted (and deallocated on the server)
+			 *	in least recently used order.  The cache is emptied
+			 *	whenever a \ref reset operation completes.
+			 *
+			 *	By default at most 128 statements are prepared and
+			 *	each is prepared on first use.
+			 *
+			 *	The change is made asynchronously but takes effect
+			 *	before any operation subsequently passed to \ref add
+			 *	begins.
+			 *
+			 *	\param [in] capacity
+			 *		The maximum number of statements.  Zero disables
+			 *		preparation.
+			 *	\param [in] threshold
+			 *		The number of times a statement must be executed
+			 *		before it is prepared.  Defaults to one.
+			 */
+			void cache (std::size_t capacity, std::size_t threshold=1);
+
+
+			/**
+			 *	Sets the interval for which an operation must wait
+			 *	to be treated as one \ref priority higher than the
+			 *	class with which it was enqueued.
+			 *
+			 *	Defaults to 100 milliseconds.  As with \ref cache the
+			 *	change is made asynchronously but takes effect before
+			 *	any operation subsequently passed to \ref add begins.
+			 *
+			 *	\param [in] interval
+			 *		The interval.  Zero disables aging, in which case
+			 *		operations of a lower class only begin when no
+			 *		operation of a higher class is waiting.
+			 */
+			void aging (std::chrono::milliseconds interval);
+			/**
+			 *	Enables or disables earliest deadline first ordering
+			 *	of waiting operations.
+			 *
+			 *	When enabled operations of the same \ref priority begin
+			 *	in order of their deadlines (the time at which they were
+			 *	passed to \ref add plus their \ref operation::timeout)
+			 *	rather than in FIFO order, operations without a timeout
+			 *	beginning after those with one.  Disabled by default.
+			 *	As with \ref cache the change is made asynchronously.
+			 *
+			 *	\param [in] enable
+			 *		\em true to order by deadline, \em false to order
+			 *		by time of enqueuing.
+			 */
+			void earliest_deadline_first (bool enable);
+			/**
+			 *	Limits the number of operations which may wait to
+			 *	begin.
+			 *
+			 *	Once the limit is reached \ref add throws \ref queue_full
+			 *	and operations passed to \ref admit wait to be admitted
+			 *	until an operation begins (or times out while waiting).
+			 *	Operations which are already waiting are unaffected by
+			 *	lowering the limit.
+			 *
+			 *	This function does not acquire any locks.
+			 *
+			 *	\param [in] max
+			 *		The maximum number of operations.  Zero, the
+			 *		default, removes the limit.
+			 */
+			void limit (std::size_t max);
+			/**
+			 *	Sets the executor on which \ref operation::complete
+			 *	is invoked.
+			 *
+			 *	Operations are never informed of their completion
+			 *	while the connection is working on their behalf: The
+			 *	operations which complete during a single handler of
+			 *	the connection are informed, in the order in which
+			 *	they completed, after that handler has begun the
+			 *	next operation and no longer prevents the connection
+			 *	from being destroyed.  By default they are informed
+			 *	on the thread which ran that handler.  If an executor
+			 *	is set they are instead informed by a single function
+			 *	submitted to it, and so are informed in the order in
+			 *	which they completed so long as the executor does not
+			 *	run functions concurrently (e.g. an
+			 *	asio::io_service::strand), in which case
+			 *	\ref operation::complete may also run concurrently
+			 *	with the methods of other operations.
+			 *
+			 *	Operations which are aborted by the destruction of
+			 *	the connection are informed within the destructor,
+			 *	possibly before operations which completed earlier
+			 *	but whose completions are waiting on the executor.
+			 *
+			 *	As with \ref cache the change is made asynchronously.
+			 *
+			 *	\param [in] executor
+			 *		The executor, or an empty asio::executor to inform
+			 *		operations on the connection's own threads.
+			 */
+			void completion_executor (asio::executor executor);
+
+
+			/**
+			 *	Subscribes to notifications on a channel.
+			 *
+			 *	The first subscription to a channel enqueues an
+			 *	operation which executes LISTEN, and channels are
+			 *	listened to again whenever a \ref reset operation
+			 *	completes.  Failures of these operations are not
+			 *	reported.
+			 *
+			 *	Notifications are retrieved whenever the connection
+			 *	receives input, including while other operations are
+			 *	running, and while the connection is idle it waits
+			 *	for input so long as there is at least one
+			 *	subscription.
+			 *
+			 *	Handlers are invoked on threads running the
+			 *	connection object's associated asio::io_service.  An
+			 *	exception thrown by a handler is thrown from
+			 *	asio::io_service::run.  As with
+			 *	\ref operation::complete handlers are invoked only
+			 *	once the connection has finished handling the input
+			 *	which contained the notification, so a handler may
+			 *	destroy the connection, in which case notifications
+			 *	received alongside are not delivered.
+			 *
+			 *	\param [in] channel
+			 *		The name of the channel.
+			 *	\param [in] handler
+			 *		The function to invoke for each notification on
+			 *		\em channel.
+			 *
+			 *	\return
+			 *		A value which identifies the subscription.
+			 */
+			subscription_type subscribe (std::string channel, notification_handler handler);
+			/**
+			 *	Ends a subscription.
+			 *
+			 *	Ending the last subscription to a channel enqueues
+			 *	an operation which executes UNLISTEN.
+			 *
+			 *	\param [in] id
+			 *		A value returned by \ref subscribe.  If the
+			 *		subscription has already ended nothing happens.
+			 */
+			void unsubscribe (subscription_type id);
+
+
+			/**
+			 *	Retrieves the number of operations which have been
+			 *	enqueued on this connection but which have not yet
+			 *	completed.
+			 *
+			 *	This function does not acquire any locks and may
+			 *	be called from any thread.  The value returned is a
+			 *	snapshot which may be stale by the time it is
+			 *	examined.
+			 *
+			 *	\return
+			 *		A count of operations.
+			 */
+			std::size_t size () const noexcept;
+			/**
+			 *	Retrieves the number of operations which have been
+			 *	enqueued on this connection but which have not yet
+			 *	begun.
+			 *
+			 *	As with \ref size the value returned is a lock-free
+			 *	snapshot.  It is the quantity bounded by \ref limit,
+			 *	the greatest value it has taken is reported by
+			 *	\ref statistics.
+			 *
+			 *	\return
+			 *		A count of operations.
+			 */
+			std::size_t waiting () const noexcept;
+
+
+			/**
+			 *	Retrieves the statistics gathered by this connection.
+			 *
+			 *	The statistics are guarded by a lock which is only
+			 *	acquired when an operation is recovered from.
+			 *
+			 *	\return
+			 *		A snapshot of the statistics.
 			 */
-			void add (operation_type op);
+			statistics_type statistics () const;
 
 
 			/**
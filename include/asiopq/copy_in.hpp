@@ -0,0 +1,167 @@
+/**
+ *	\file
+ */
+
+
+#pragma once
+
+
+#include "asio.hpp"
+#include "query.hpp"
+#include <libpq-fe.h>
+#include <cstddef>
+#include <exception>
+#include <string>
+#include <vector>
+
+
+namespace asiopq {
+
+
+	/**
+	 *	An abstract base class for COPY FROM STDIN
+	 *	operations.
+	 *
+	 *	Derived classes send the COPY command by implementing
+	 *	\ref query::send and supply the data to be copied by
+	 *	implementing \ref produce.  Data is passed to libpq
+	 *	directly from the buffers returned by \ref produce
+	 *	without being copied elsewhere first.
+	 *
+	 *	COPY may not be used in pipeline mode.
+	 */
+	class copy_in : public query {
+
+
+		public:
+
+
+			/**
+			 *	The type of a sequence of buffers containing data to
+			 *	be copied.
+			 *
+			 *	This type models ConstBufferSequence.
+			 */
+			using buffers_type=std::vector<asio::const_buffer>;
+
+
+		private:
+
+
+			enum class state {
+
+				command,
+				copying,
+				ending,
+				flushing,
+				finishing
+
+			};
+
+
+			state state_;
+			buffers_type buffers_;
+			buffers_type::size_type pos_;
+			std::size_t offset_;
+			bool more_;
+			bool starved_;
+			std::exception_ptr ex_;
+			std::string rows_;
+
+
+			void next ();
+			operation_status put (native_handle_type);
+			operation_status end (native_handle_type);
+			operation_status finish (native_handle_type);
+			operation_status results (native_handle_type);
+
+
+		public:
+
+
+			/**
+			 *	Creates a new copy_in object.
+			 *
+			 *	\param [in] timeout
+			 *		A \ref operation::timeout_type object giving the
+			 *		amount of time this operation is permitted to
+			 *		take at maximum.  Defaults to no timeout which
+			 *		means this operation may take infinitely long.
+			 */
+			explicit copy_in (timeout_type timeout=timeout_type{});
+
+
+			/**
+			 *	Invoked to obtain data to copy whenever all data
+			 *	previously obtained has been passed to libpq.
+			 *
+			 *	The memory referred to by \em buffers must remain
+			 *	valid until this method is next invoked or until
+			 *	\ref operation::complete is invoked.
+			 *
+			 *	If this method throws the copy is aborted and
+			 *	\ref operation::complete is invoked with the thrown
+			 *	exception once the server acknowledges that.
+			 *
+			 *	\param [out] buffers
+			 *		An empty sequence of buffers to which buffers
+			 *		containing the data to copy shall be appended.
+			 *
+			 *	If this method returns \em true without supplying any
+			 *	data the operation suspends (see
+			 *	\ref operation::operation_status::suspend) and this
+			 *	method is next invoked once it is passed to
+			 *	\ref connection::resume.
+			 *
+			 *	\return
+			 *		\em false if there is no data other than that
+			 *		appended to \em buffers, \em true otherwise.
+			 */
+			virtual bool produce (buffers_type & buffers) = 0;
+
+
+			/**
+			 *	Appends the buffers in a ConstBufferSequence to
+			 *	a \ref buffers_type object.
+			 *
+			 *	The underlying memory is not copied.
+			 *
+			 *	\tparam ConstBufferSequence
+			 *		A type which models ConstBufferSequence.
+			 *
+			 *	\param [in] buffers
+			 *		The \ref buffers_type object.
+			 *	\param [in] sequence
+			 *		The buffers to append.
+			 */
+			template <typename ConstBufferSequence>
+			static void append (buffers_type & buffers, const ConstBufferSequence & sequence) {
+
+				for (auto && buffer : sequence) buffers.push_back(asio::const_buffer(buffer));
+
+			}
+
+
+			/**
+			 *	Retrieves the number of rows copied as reported by
+			 *	the server.
+			 *
+			 *	Only meaningful once the operation has completed
+			 *	successfully.
+			 *
+			 *	\return
+			 *		The number of rows as a string, see the libpq
+			 *		documentation for PQcmdTuples.
+			 */
+			const std::string & rows () const noexcept;
+
+
+			virtual void result (native_result_type) override;
+			virtual bool pipelinable () const noexcept override;
+			virtual operation_status perform (native_handle_type, socket_status) override;
+
+
+	};
+
+
+}
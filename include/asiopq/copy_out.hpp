@@ -0,0 +1,302 @@
+/**
+ *	\file
+ */
+
+
+#pragma once
+
+
+#include "asio.hpp"
+#include "connection.hpp"
+#include "query.hpp"
+#include <libpq-fe.h>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <utility>
+
+
+namespace asiopq {
+
+
+	/**
+	 *	An abstract base class for COPY TO STDOUT
+	 *	operations.
+	 *
+	 *	Derived classes send the COPY command by implementing
+	 *	\ref query::send and receive the copied data by
+	 *	implementing \ref consume.  Each chunk of data is
+	 *	handed over exactly as libpq returns it, without being
+	 *	copied.
+	 *
+	 *	If \ref consume indicates that it cannot accept more data
+	 *	the operation suspends (see
+	 *	\ref operation::operation_status::suspend) until
+	 *	\ref connection::resume is called with it.
+	 *
+	 *	COPY may not be used in pipeline mode.
+	 */
+	class copy_out : public query {
+
+
+		public:
+
+
+			/**
+			 *	A chunk of data received from the server.
+			 *
+			 *	The memory is owned by this object and is released
+			 *	(using PQfreemem) when this object is destroyed.
+			 */
+			class chunk {
+
+
+				private:
+
+
+					char * ptr_;
+					std::size_t size_;
+
+
+				public:
+
+
+					chunk () = delete;
+					chunk (const chunk &) = delete;
+					chunk & operator = (const chunk &) = delete;
+
+
+					/**
+					 *	Creates a chunk which assumes ownership of
+					 *	memory allocated by libpq.
+					 *
+					 *	\param [in] ptr
+					 *		A pointer to the memory.
+					 *	\param [in] size
+					 *		The number of bytes.
+					 */
+					chunk (char * ptr, std::size_t size) noexcept;
+					chunk (chunk && rhs) noexcept;
+					chunk & operator = (chunk && rhs) noexcept;
+
+
+					/**
+					 *	Releases the memory.
+					 */
+					~chunk () noexcept;
+
+
+					/**
+					 *	Retrieves a pointer to the data.
+					 *
+					 *	\return
+					 *		A pointer.
+					 */
+					const char * data () const noexcept;
+					/**
+					 *	Retrieves the number of bytes of data.
+					 *
+					 *	\return
+					 *		A count of bytes.
+					 */
+					std::size_t size () const noexcept;
+					/**
+					 *	Retrieves a buffer which refers to the data.
+					 *
+					 *	The buffer is valid only so long as this object
+					 *	is.
+					 *
+					 *	\return
+					 *		A buffer.
+					 */
+					asio::const_buffers_1 buffer () const noexcept;
+
+
+			};
+
+
+		private:
+
+
+			enum class state {
+
+				command,
+				copying,
+				finishing
+
+			};
+
+
+			state state_;
+			std::exception_ptr ex_;
+			std::string rows_;
+
+
+			operation_status copy (native_handle_type);
+			operation_status results (native_handle_type);
+
+
+		protected:
+
+
+			/**
+			 *	Causes the operation to fail once the copy has finished,
+			 *	all further data being discarded.
+			 *
+			 *	Intended for use by sinks which learn of a failure
+			 *	asynchronously.  Must only be invoked while the
+			 *	operation is suspended or from within \ref consume.
+			 *
+			 *	\param [in] ex
+			 *		The exception with which the operation shall
+			 *		fail.
+			 */
+			void fail (std::exception_ptr ex) noexcept;
+
+
+		public:
+
+
+			/**
+			 *	Creates a new copy_out object.
+			 *
+			 *	\param [in] timeout
+			 *		A \ref operation::timeout_type object giving the
+			 *		amount of time this operation is permitted to
+			 *		take at maximum.  Defaults to no timeout which
+			 *		means this operation may take infinitely long.
+			 */
+			explicit copy_out (timeout_type timeout=timeout_type{});
+
+
+			/**
+			 *	Invoked with each chunk of data received from the
+			 *	server.
+			 *
+			 *	If this method throws all further data is discarded
+			 *	and \ref operation::complete is invoked with the thrown
+			 *	exception once the copy finishes.
+			 *
+			 *	\param [in] c
+			 *		The chunk of data.  The memory therein may be
+			 *		retained for as long as required.
+			 *
+			 *	\return
+			 *		\em true if more data may be delivered immediately,
+			 *		\em false if the operation should be suspended until
+			 *		\ref connection::resume is called with it.
+			 */
+			virtual bool consume (chunk c) = 0;
+
+
+			/**
+			 *	Retrieves the number of rows copied as reported by
+			 *	the server.
+			 *
+			 *	Only meaningful once the operation has completed
+			 *	successfully.
+			 *
+			 *	\return
+			 *		The number of rows as a string, see the libpq
+			 *		documentation for PQcmdTuples.
+			 */
+			const std::string & rows () const noexcept;
+
+
+			virtual void result (native_result_type) override;
+			virtual bool pipelinable () const noexcept override;
+			virtual operation_status perform (native_handle_type, socket_status) override;
+
+
+	};
+
+
+	/**
+	 *	An abstract base class for COPY TO STDOUT operations
+	 *	which write the copied data to a stream.
+	 *
+	 *	Each chunk is written asynchronously and the operation
+	 *	is suspended until that write completes so that no more
+	 *	than one chunk is held in memory at a time.
+	 *
+	 *	To write to a file descriptor use a stream descriptor.
+	 *
+	 *	Objects of this type must be managed by a std::shared_ptr.
+	 *
+	 *	\tparam AsyncWriteStream
+	 *		A type which models AsyncWriteStream.
+	 */
+	template <typename AsyncWriteStream>
+	class copy_out_stream : public copy_out, public std::enable_shared_from_this<copy_out_stream<AsyncWriteStream>> {
+
+
+		private:
+
+
+			AsyncWriteStream & stream_;
+			asiopq::connection & conn_;
+
+
+			static std::exception_ptr make_exception (const std::error_code & ec) {
+
+				return std::make_exception_ptr(std::system_error(ec));
+
+			}
+			#ifdef ASIOPQ_USE_BOOST_ASIO
+			static std::exception_ptr make_exception (const boost::system::error_code & ec) {
+
+				return std::make_exception_ptr(boost::system::system_error(ec));
+
+			}
+			#endif
+
+
+		public:
+
+
+			/**
+			 *	Creates a new copy_out_stream object.
+			 *
+			 *	\param [in] stream
+			 *		The stream to which data shall be written.  Must
+			 *		remain valid until the operation completes.
+			 *	\param [in] conn
+			 *		The connection on which the operation shall be
+			 *		performed.  Must remain valid until the operation
+			 *		completes.
+			 *	\param [in] timeout
+			 *		A \ref operation::timeout_type object giving the
+			 *		amount of time this operation is permitted to
+			 *		take at maximum.  Defaults to no timeout which
+			 *		means this operation may take infinitely long.
+			 */
+			copy_out_stream (AsyncWriteStream & stream, asiopq::connection & conn, timeout_type timeout=timeout_type{})
+				:	copy_out(timeout),
+					stream_(stream),
+					conn_(conn)
+			{	}
+
+
+			virtual bool consume (chunk c) override {
+
+				auto ptr=std::make_shared<chunk>(std::move(c));
+				auto self=this->shared_from_this();
+				asio::async_write(stream_,ptr->buffer(),[self,ptr] (const auto & ec, std::size_t) {
+
+					if (ec) self->fail(make_exception(ec));
+
+					self->conn_.resume(self);
+
+				});
+
+				return false;
+
+			}
+
+
+	};
+
+
+}
@@ -0,0 +1,805 @@
+/**
+ *	\file
+ *
+ *	Requires C++20 coroutines.  The library itself need
+ *	not be built as C++20 to use this header.
+ */
+
+
+#pragma once
+
+
+#if !(defined(__cpp_impl_coroutine) && __has_include(<coroutine>))
+#error "asiopq/coroutine.hpp requires C++20 coroutines"
+#endif
+
+
+#include "asio.hpp"
+#include "connect.hpp"
+#include "connection.hpp"
+#include "exception.hpp"
+#include "optional.hpp"
+#include "params.hpp"
+#include "prepared_query.hpp"
+#include "reset.hpp"
+#include "result.hpp"
+#include <libpq-fe.h>
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+
+namespace asiopq {
+
+
+	/**
+	 *	A base class for operations which resume a suspended
+	 *	coroutine when they complete.
+	 *
+	 *	The coroutine is resumed by posting to an
+	 *	asio::io_service rather than from within
+	 *	\ref operation::complete, since the \ref connection
+	 *	is not finished with the operation at that point.
+	 */
+	class coroutine_completion {
+
+
+		private:
+
+
+			asio::io_service * ios_;
+			std::coroutine_handle<> handle_;
+			std::exception_ptr ex_;
+
+
+		protected:
+
+
+			/**
+			 *	Resumes the suspended coroutine.
+			 *
+			 *	\param [in] ex
+			 *		The exception with which the operation completed,
+			 *		if any.
+			 */
+			void resume (std::exception_ptr ex) {
+
+				ex_=std::move(ex);
+				ios_->post([h=handle_] () {	h.resume();	});
+
+			}
+
+
+		public:
+
+
+			coroutine_completion () noexcept : ios_(nullptr) {	}
+
+
+			/**
+			 *	Records the coroutine to resume.
+			 *
+			 *	Must be called before the operation is dispatched.
+			 *
+			 *	\param [in] ios
+			 *		The asio::io_service on which the coroutine shall
+			 *		be resumed.
+			 *	\param [in] handle
+			 *		The coroutine.
+			 */
+			void suspend (asio::io_service & ios, std::coroutine_handle<> handle) noexcept {
+
+				ios_=&ios;
+				handle_=handle;
+
+			}
+
+
+			/**
+			 *	Throws the exception with which the operation
+			 *	completed, if any.
+			 */
+			void rethrow () const {
+
+				if (ex_) std::rethrow_exception(ex_);
+
+			}
+
+
+	};
+
+
+	/**
+	 *	A \ref basic_connect which resumes a coroutine.
+	 */
+	class coroutine_connect : public basic_connect, public coroutine_completion {
+
+
+		public:
+
+
+			using basic_connect::basic_connect;
+			using basic_connect::release;
+
+
+			virtual void complete (std::exception_ptr ex) override {
+
+				resume(std::move(ex));
+
+			}
+
+
+	};
+
+
+	/**
+	 *	A \ref basic_reset which resumes a coroutine.
+	 */
+	class coroutine_reset : public basic_reset, public coroutine_completion {
+
+
+		public:
+
+
+			using basic_reset::basic_reset;
+
+
+			virtual void complete (std::exception_ptr ex) override {
+
+				resume(std::move(ex));
+
+			}
+
+
+	};
+
+
+	/**
+	 *	A \ref prepared_query which encodes its parameters
+	 *	using \ref params, requests its result in binary format,
+	 *	and resumes a coroutine.
+	 *
+	 *	\tparam Ts
+	 *		The types of the parameters.
+	 */
+	template <typename... Ts>
+	class coroutine_query : public prepared_query, public coroutine_completion {
+
+
+		private:
+
+
+			params<Ts...> params_;
+			optional<asiopq::result> result_;
+
+
+		protected:
+
+
+			virtual parameters bind () override {
+
+				return params_.describe(1);
+
+			}
+
+
+		public:
+
+
+			coroutine_query (std::string sql, timeout_type timeout, const Ts &... args)
+				:	prepared_query(std::move(sql),timeout),
+					params_(args...)
+			{	}
+
+
+			virtual void result (native_result_type result) override {
+
+				asiopq::result r(result);
+
+				switch (PQresultStatus(result)) {
+
+					case PGRES_TUPLES_OK:
+					case PGRES_COMMAND_OK:
+						break;
+					default:
+						throw result_error(result);
+
+				}
+
+				if (!result_) result_.emplace(std::move(r));
+
+			}
+
+
+			virtual void complete (std::exception_ptr ex) override {
+
+				resume(std::move(ex));
+
+			}
+
+
+			/**
+			 *	Retrieves the result.
+			 *
+			 *	\return
+			 *		The result.
+			 */
+			asiopq::result get () {
+
+				rethrow();
+
+				if (!result_) throw std::logic_error("Query returned no result");
+
+				return std::move(*result_);
+
+			}
+
+
+	};
+
+
+	/**
+	 *	Awaits the completion of an operation.
+	 *
+	 *	\tparam Operation
+	 *		A type derived from both \ref operation and
+	 *		\ref coroutine_completion.
+	 */
+	template <typename Operation>
+	class operation_awaiter {
+
+
+		private:
+
+
+			connection & conn_;
+			std::shared_ptr<Operation> op_;
+
+
+		public:
+
+
+			operation_awaiter (connection & conn, std::shared_ptr<Operation> op) noexcept : conn_(conn), op_(std::move(op)) {	}
+
+
+			bool await_ready () const noexcept {
+
+				return false;
+
+			}
+
+
+			void await_suspend (std::coroutine_handle<> handle) {
+
+				op_->suspend(conn_.get_io_service(),handle);
+				conn_.add(op_);
+
+			}
+
+
+			/**
+			 *	Retrieves the operation once it has completed.
+			 *
+			 *	\return
+			 *		The operation.
+			 */
+			Operation & await_resume () const noexcept {
+
+				return *op_;
+
+			}
+
+
+	};
+
+
+	/**
+	 *	Awaits the completion of a \ref coroutine_connect
+	 *	operation.
+	 */
+	class connect_awaiter {
+
+
+		private:
+
+
+			asio::io_service & ios_;
+			std::shared_ptr<coroutine_connect> op_;
+			optional<connection> conn_;
+
+
+		public:
+
+
+			connect_awaiter (asio::io_service & ios, std::shared_ptr<coroutine_connect> op) noexcept : ios_(ios), op_(std::move(op)) {	}
+
+
+			bool await_ready () const noexcept {
+
+				return false;
+
+			}
+
+
+			void await_suspend (std::coroutine_handle<> handle) {
+
+				//	The connection must be in place before the
+				//	operation is dispatched since the coroutine
+				//	may resume on another thread
+				conn_.emplace(op_->release(ios_));
+				op_->suspend(ios_,handle);
+				conn_->add(op_);
+
+			}
+
+
+			connection await_resume () {
+
+				op_->rethrow();
+
+				return std::move(*conn_);
+
+			}
+
+
+	};
+
+
+	/**
+	 *	Connects to a Postgres database by calling
+	 *	PQconnectStart, suspending the calling coroutine
+	 *	until the connection is established.
+	 *
+	 *	\param [in] conninfo
+	 *		See libpq documentation for PQconnectStart.
+	 *	\param [in] ios
+	 *		The asio::io_service which the created
+	 *		\ref connection shall use and on which the coroutine
+	 *		shall be resumed.
+	 *	\param [in] timeout
+	 *		A \ref operation::timeout_type object giving the
+	 *		amount of time the operation is permitted to take at
+	 *		maximum.  Defaults to no timeout.
+	 *
+	 *	\return
+	 *		An awaitable whose result is a \ref connection.
+	 */
+	inline connect_awaiter async_connect (const char * conninfo, asio::io_service & ios, operation::timeout_type timeout=operation::timeout_type{}) {
+
+		return connect_awaiter(ios,std::make_shared<coroutine_connect>(conninfo,timeout));
+
+	}
+
+
+	/**
+	 *	Resets a connection, suspending the calling coroutine
+	 *	until the reset completes.
+	 *
+	 *	\param [in] conn
+	 *		The connection.  The coroutine is resumed on its
+	 *		asio::io_service.
+	 *	\param [in] timeout
+	 *		A \ref operation::timeout_type object giving the
+	 *		amount of time the operation is permitted to take at
+	 *		maximum.  Defaults to no timeout.
+	 *
+	 *	\return
+	 *		An awaitable.
+	 */
+	inline auto async_reset (connection & conn, operation::timeout_type timeout=operation::timeout_type{}) {
+
+		class awaiter : public operation_awaiter<coroutine_reset> {
+
+
+			public:
+
+
+				using operation_awaiter<coroutine_reset>::operation_awaiter;
+
+
+				void await_resume () const {
+
+					operation_awaiter<coroutine_reset>::await_resume().rethrow();
+
+				}
+
+
+		};
+
+		return awaiter(conn,std::make_shared<coroutine_reset>(timeout));
+
+	}
+
+
+	/**
+	 *	Executes a query, suspending the calling coroutine
+	 *	until its result is available.
+	 *
+	 *	The query is prepared automatically (see
+	 *	\ref prepared_query) and its parameters are sent in
+	 *	binary format (see \ref params).
+	 *
+	 *	\param [in] conn
+	 *		The connection.  The coroutine is resumed on its
+	 *		asio::io_service.
+	 *	\param [in] timeout
+	 *		A \ref operation::timeout_type object giving the
+	 *		amount of time the operation is permitted to take at
+	 *		maximum.
+	 *	\param [in] sql
+	 *		The SQL text of the query.
+	 *	\param [in] args
+	 *		The values of the parameters.
+	 *
+	 *	\return
+	 *		An awaitable whose result is an \ref asiopq::result in
+	 *		binary format.
+	 */
+	template <typename... Ts>
+	auto async_query (connection & conn, operation::timeout_type timeout, std::string sql, const Ts &... args) {
+
+		using query_type=coroutine_query<std::decay_t<const Ts>...>;
+
+		class awaiter : public operation_awaiter<query_type> {
+
+
+			public:
+
+
+				using operation_awaiter<query_type>::operation_awaiter;
+
+
+				asiopq::result await_resume () const {
+
+					return operation_awaiter<query_type>::await_resume().get();
+
+				}
+
+
+		};
+
+		return awaiter(conn,std::make_shared<query_type>(std::move(sql),timeout,args...));
+
+	}
+	/**
+	 *	Executes a query with no timeout, suspending the calling
+	 *	coroutine until its result is available.
+	 *
+	 *	\param [in] conn
+	 *		The connection.
+	 *	\param [in] sql
+	 *		The SQL text of the query.
+	 *	\param [in] args
+	 *		The values of the parameters.
+	 *
+	 *	\return
+	 *		An awaitable whose result is an \ref asiopq::result in
+	 *		binary format.
+	 */
+	template <typename... Ts>
+	auto async_query (connection & conn, std::string sql, const Ts &... args) {
+
+		return async_query(conn,operation::timeout_type{},std::move(sql),args...);
+
+	}
+
+
+	template <typename T>
+	class task;
+
+
+	/**
+	 *	The state of a \ref task.
+	 */
+	class task_promise_base {
+
+
+		private:
+
+
+			class final_awaiter {
+
+
+				public:
+
+
+					bool await_ready () const noexcept {
+
+						return false;
+
+					}
+
+
+					template <typename Promise>
+					std::coroutine_handle<> await_suspend (std::coroutine_handle<Promise> handle) noexcept {
+
+						auto & p=handle.promise();
+						if (p.continuation_) return p.continuation_;
+
+						//	Exceptions which escape spawned tasks escape
+						//	asio::io_service::run as those which escape
+						//	handlers would
+						if (auto ios=p.ios_) {
+
+							auto ex=std::move(p.ex_);
+							handle.destroy();
+							if (ex) ios->post([ex=std::move(ex)] () {	std::rethrow_exception(ex);	});
+
+						}
+
+						return std::noop_coroutine();
+
+					}
+
+
+					void await_resume () const noexcept {	}
+
+
+			};
+
+
+			template <typename>
+			friend class task;
+			template <typename>
+			friend class task_promise;
+			friend void spawn (asio::io_service &, task<void>);
+
+
+			std::coroutine_handle<> continuation_;
+			asio::io_service * ios_=nullptr;
+			std::exception_ptr ex_;
+
+
+		public:
+
+
+			std::suspend_always initial_suspend () const noexcept {
+
+				return {};
+
+			}
+
+
+			final_awaiter final_suspend () const noexcept {
+
+				return {};
+
+			}
+
+
+			void unhandled_exception () noexcept {
+
+				ex_=std::current_exception();
+
+			}
+
+
+	};
+
+
+	template <typename T>
+	class task_promise : public task_promise_base {
+
+
+		private:
+
+
+			optional<T> value_;
+
+
+		public:
+
+
+			task<T> get_return_object () noexcept;
+
+
+			template <typename U>
+			void return_value (U && value) {
+
+				value_.emplace(std::forward<U>(value));
+
+			}
+
+
+			T get () {
+
+				if (ex_) std::rethrow_exception(ex_);
+
+				return std::move(*value_);
+
+			}
+
+
+	};
+
+
+	template <>
+	class task_promise<void> : public task_promise_base {
+
+
+		public:
+
+
+			task<void> get_return_object () noexcept;
+
+
+			void return_void () const noexcept {	}
+
+
+			void get () const {
+
+				if (ex_) std::rethrow_exception(ex_);
+
+			}
+
+
+	};
+
+
+	/**
+	 *	A lazily started coroutine which may be awaited by
+	 *	other coroutines or spawned (see \ref spawn).
+	 *
+	 *	\tparam T
+	 *		The type of the value the coroutine returns.
+	 */
+	template <typename T=void>
+	class task {
+
+
+		public:
+
+
+			using promise_type=task_promise<T>;
+
+
+		private:
+
+
+			using handle_type=std::coroutine_handle<promise_type>;
+
+
+			handle_type handle_;
+
+
+			friend void spawn (asio::io_service &, task<void>);
+
+
+		public:
+
+
+			task (const task &) = delete;
+			task & operator = (const task &) = delete;
+
+
+			explicit task (handle_type handle) noexcept : handle_(handle) {	}
+			task (task && rhs) noexcept : handle_(std::exchange(rhs.handle_,handle_type{})) {	}
+			task & operator = (task && rhs) noexcept {
+
+				std::swap(handle_,rhs.handle_);
+
+				return *this;
+
+			}
+
+
+			~task () noexcept {
+
+				if (handle_) handle_.destroy();
+
+			}
+
+
+			/**
+			 *	Starts the coroutine and suspends the awaiting
+			 *	coroutine until it completes.
+			 *
+			 *	\return
+			 *		An awaitable whose result is that of the coroutine.
+			 */
+			auto operator co_await () && noexcept {
+
+				class awaiter {
+
+
+					private:
+
+
+						handle_type handle_;
+
+
+					public:
+
+
+						explicit awaiter (handle_type handle) noexcept : handle_(handle) {	}
+
+
+						bool await_ready () const noexcept {
+
+							return false;
+
+						}
+
+
+						std::coroutine_handle<> await_suspend (std::coroutine_handle<> continuation) noexcept {
+
+							handle_.promise().continuation_=continuation;
+
+							return handle_;
+
+						}
+
+
+						T await_resume () {
+
+							return handle_.promise().get();
+
+						}
+
+
+				};
+
+				return awaiter(handle_);
+
+			}
+
+
+	};
+
+
+	template <typename T>
+	task<T> task_promise<T>::get_return_object () noexcept {
+
+		return task<T>(std::coroutine_handle<task_promise>::from_promise(*this));
+
+	}
+
+
+	inline task<void> task_promise<void>::get_return_object () noexcept {
+
+		return task<void>(std::coroutine_handle<task_promise>::from_promise(*this));
+
+	}
+
+
+	/**
+	 *	Starts a \ref task on an asio::io_service without
+	 *	awaiting it.
+	 *
+	 *	The task destroys itself once it completes.  If it
+	 *	exits via an exception that exception is thrown from
+	 *	asio::io_service::run.  If the asio::io_service is
+	 *	destroyed before the task starts the task is destroyed
+	 *	with it.
+	 *
+	 *	\param [in] ios
+	 *		The asio::io_service.
+	 *	\param [in] t
+	 *		The task.
+	 */
+	inline void spawn (asio::io_service & ios, task<void> t) {
+
+		using handle_type=std::coroutine_handle<task_promise<void>>;
+
+		t.handle_.promise().ios_=&ios;
+
+		//	The handler owns the task until it starts, since
+		//	asio requires that handlers be copyable that
+		//	ownership is shared
+		auto ptr=new handle_type(t.handle_);
+		t.handle_=nullptr;
+		std::shared_ptr<handle_type> handle(ptr,[] (handle_type * ptr) noexcept {
+
+			if (*ptr) ptr->destroy();
+			delete ptr;
+
+		});
+		ios.post([handle=std::move(handle)] () {	std::exchange(*handle,handle_type{}).resume();	});
+
+	}
+
+
+}
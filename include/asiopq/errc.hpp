@@ -0,0 +1,85 @@
+/**
+ *	\file
+ */
+
+
+#pragma once
+
+
+#include <system_error>
+#include <type_traits>
+
+
+namespace asiopq {
+
+
+	/**
+	 *	An enumeration of the errors with which an
+	 *	\ref operation may complete without an exception
+	 *	being created (see \ref operation::complete).
+	 *
+	 *	Convertible to std::error_code.  Each member is
+	 *	equivalent to the std::errc member with the same
+	 *	meaning so that errors from this library and from
+	 *	asio may be tested alike.
+	 */
+	enum class errc {
+
+		/**
+		 *	The operation was aborted.  Corresponds to
+		 *	\ref aborted.
+		 */
+		aborted=1,
+		/**
+		 *	The operation took longer than allowed.  Corresponds
+		 *	to \ref timed_out.
+		 */
+		timed_out,
+		/**
+		 *	The operation was not enqueued because too many were
+		 *	already waiting.  Corresponds to \ref queue_full.
+		 */
+		queue_full,
+		/**
+		 *	libpq failed to send to or receive from the server.
+		 *	Corresponds to \ref connection_error.
+		 */
+		connection_failed
+
+	};
+
+
+	/**
+	 *	Retrieves the category of the error codes which
+	 *	represent \ref errc.
+	 *
+	 *	\return
+	 *		A reference to a std::error_category which is the
+	 *		same object on every invocation.
+	 */
+	const std::error_category & error_category () noexcept;
+
+
+	/**
+	 *	Creates a std::error_code which represents an \ref errc.
+	 *
+	 *	\param [in] e
+	 *		The \ref errc.
+	 *
+	 *	\return
+	 *		A std::error_code.
+	 */
+	std::error_code make_error_code (errc e) noexcept;
+
+
+}
+
+
+namespace std {
+
+
+	template <>
+	struct is_error_code_enum<asiopq::errc> : public true_type {	};
+
+
+}
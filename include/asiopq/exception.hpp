@@ -8,7 +8,9 @@
 
 #include "operation.hpp"
 #include <libpq-fe.h>
+#include <cstddef>
 #include <stdexcept>
+#include <string>
 
 
 namespace asiopq {
@@ -54,6 +56,14 @@ namespace asiopq {
 			 *		The handle from which to draw error information.
 			 */
 			explicit connection_error (native_handle_type handle);
+			/**
+			 *	Creates a connection_error object from an error
+			 *	message previously drawn from a libpq connection.
+			 *
+			 *	\param [in] message
+			 *		The error message.
+			 */
+			explicit connection_error (const std::string & message);
 
 
 	};
@@ -111,6 +121,44 @@ namespace asiopq {
 	};
 
 
+	/**
+	 *	Indicates that an \ref operation could not be enqueued
+	 *	because the maximum number of operations were already
+	 *	waiting to begin (see \ref connection::limit).
+	 */
+	class queue_full : public error {
+
+
+		private:
+
+
+			std::size_t limit_;
+
+
+		public:
+
+
+			/**
+			 *	Creates a new queue_full object.
+			 *
+			 *	\param [in] limit
+			 *		The number of operations which may wait.
+			 */
+			explicit queue_full (std::size_t limit);
+
+
+			/**
+			 *	Retrieves the number of operations which may wait.
+			 *
+			 *	\return
+			 *		A count of operations.
+			 */
+			std::size_t limit () const noexcept;
+
+
+	};
+
+
 	/**
 	 *	Represents an exception thrown by a libpq result.
 	 */
@@ -140,4 +188,20 @@ namespace asiopq {
 	};
 
 
+	/**
+	 *	Indicates that a field of a result could not be
+	 *	decoded as the requested type.
+	 */
+	class decode_error : public error {
+
+
+		public:
+
+
+			using error::error;
+
+
+	};
+
+
 }
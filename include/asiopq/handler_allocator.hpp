@@ -0,0 +1,255 @@
+/**
+ *	\file
+ */
+
+
+#pragma once
+
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+
+namespace asiopq {
+
+
+	/**
+	 *	A small fixed set of blocks from which the handlers of
+	 *	asynchronous operations are allocated so that, once
+	 *	running, an object which repeatedly waits on a socket
+	 *	does not allocate from the heap.
+	 *
+	 *	Allocations which are too large or which are made
+	 *	while every block is in use are satisfied from the
+	 *	heap.  Allocations which require more than fundamental
+	 *	alignment are not supported.
+	 *
+	 *	Thread safe.
+	 */
+	class handler_arena {
+
+
+		public:
+
+
+			/**
+			 *	The size in bytes of each block.
+			 */
+			static constexpr std::size_t size=256;
+			/**
+			 *	The number of blocks.
+			 */
+			static constexpr std::size_t blocks=6;
+
+
+		private:
+
+
+			class block {
+
+
+				public:
+
+
+					std::atomic<bool> used;
+					std::aligned_storage_t<size> storage;
+
+
+			};
+
+
+			std::array<block,blocks> blocks_;
+
+
+		public:
+
+
+			handler_arena (const handler_arena &) = delete;
+			handler_arena (handler_arena &&) = delete;
+			handler_arena & operator = (const handler_arena &) = delete;
+			handler_arena & operator = (handler_arena &&) = delete;
+
+
+			handler_arena () noexcept;
+
+
+			/**
+			 *	Allocates memory.
+			 *
+			 *	\param [in] n
+			 *		The number of bytes.
+			 *	\param [in] alignment
+			 *		The alignment required.
+			 *
+			 *	\return
+			 *		A pointer to the memory.
+			 */
+			void * allocate (std::size_t n, std::size_t alignment);
+			/**
+			 *	Deallocates memory obtained from \ref allocate.
+			 *
+			 *	\param [in] ptr
+			 *		The pointer returned by \ref allocate.
+			 */
+			void deallocate (void * ptr) noexcept;
+
+
+			/**
+			 *	Retrieves the number of blocks which are in use.
+			 *
+			 *	\return
+			 *		A count of blocks.
+			 */
+			std::size_t used () const noexcept;
+
+
+	};
+
+
+	/**
+	 *	An allocator which obtains memory from a
+	 *	\ref handler_arena.
+	 *
+	 *	\tparam T
+	 *		The type of object to allocate.
+	 */
+	template <typename T>
+	class handler_allocator {
+
+
+		template <typename>
+		friend class handler_allocator;
+
+
+		private:
+
+
+			handler_arena * arena_;
+
+
+		public:
+
+
+			using value_type=T;
+
+
+			/**
+			 *	Creates an allocator.
+			 *
+			 *	\param [in] arena
+			 *		The arena from which to allocate, which must
+			 *		outlive every allocation.
+			 */
+			explicit handler_allocator (handler_arena & arena) noexcept : arena_(&arena) {	}
+
+
+			template <typename U>
+			handler_allocator (const handler_allocator<U> & other) noexcept : arena_(other.arena_) {	}
+
+
+			T * allocate (std::size_t n) {
+
+				return static_cast<T *>(arena_->allocate(sizeof(T)*n,alignof(T)));
+
+			}
+
+
+			void deallocate (T * ptr, std::size_t) noexcept {
+
+				arena_->deallocate(ptr);
+
+			}
+
+
+			template <typename U>
+			bool operator == (const handler_allocator<U> & rhs) const noexcept {
+
+				return arena_==rhs.arena_;
+
+			}
+
+
+			template <typename U>
+			bool operator != (const handler_allocator<U> & rhs) const noexcept {
+
+				return arena_!=rhs.arena_;
+
+			}
+
+
+	};
+
+
+	/**
+	 *	Associates a \ref handler_allocator with a completion
+	 *	handler.
+	 *
+	 *	\tparam Handler
+	 *		The type of the completion handler.
+	 */
+	template <typename Handler>
+	class arena_handler {
+
+
+		private:
+
+
+			Handler handler_;
+			handler_arena & arena_;
+
+
+		public:
+
+
+			using allocator_type=handler_allocator<void>;
+
+
+			arena_handler (handler_arena & arena, Handler handler)
+				:	handler_(std::move(handler)),
+					arena_(arena)
+			{	}
+
+
+			allocator_type get_allocator () const noexcept {
+
+				return allocator_type(arena_);
+
+			}
+
+
+			template <typename... Args>
+			void operator () (Args &&... args) {
+
+				handler_(std::forward<Args>(args)...);
+
+			}
+
+
+	};
+
+
+	/**
+	 *	Associates a \ref handler_allocator with a completion
+	 *	handler.
+	 *
+	 *	\param [in] arena
+	 *		The arena from which operations which invoke the
+	 *		handler shall allocate.
+	 *	\param [in] handler
+	 *		The completion handler.
+	 *
+	 *	\return
+	 *		An \ref arena_handler.
+	 */
+	template <typename Handler>
+	arena_handler<std::decay_t<Handler>> bind_arena (handler_arena & arena, Handler && handler) {
+
+		return arena_handler<std::decay_t<Handler>>(arena,std::forward<Handler>(handler));
+
+	}
+
+
+}
@@ -0,0 +1,309 @@
+/**
+ *	\file
+ */
+
+
+#pragma once
+
+
+#include "scope.hpp"
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+
+namespace asiopq {
+
+
+	/**
+	 *	A lock-free queue which any number of threads may
+	 *	push onto and one thread at a time may consume.
+	 *
+	 *	Pushing never blocks and never waits for a consumer.
+	 *	A consumer takes every element present at once so
+	 *	consumers do not contend with producers element by
+	 *	element.
+	 *
+	 *	\tparam T
+	 *		The type of the elements.
+	 */
+	template <typename T>
+	class mpsc_queue {
+
+
+		private:
+
+
+			class node {
+
+
+				public:
+
+
+					T value;
+					node * next;
+
+
+			};
+
+
+			std::atomic<node *> head_;
+
+
+			static void destroy (node * n) noexcept {
+
+				while (n) {
+
+					auto next=n->next;
+					delete n;
+					n=next;
+
+				}
+
+			}
+
+
+		public:
+
+
+			mpsc_queue (const mpsc_queue &) = delete;
+			mpsc_queue (mpsc_queue &&) = delete;
+			mpsc_queue & operator = (const mpsc_queue &) = delete;
+			mpsc_queue & operator = (mpsc_queue &&) = delete;
+
+
+			mpsc_queue () noexcept : head_(nullptr) {	}
+
+
+			/**
+			 *	Destroys every element which has not been consumed.
+			 */
+			~mpsc_queue () noexcept {
+
+				destroy(head_.load(std::memory_order_acquire));
+
+			}
+
+
+			/**
+			 *	Adds an element to the back of the queue.
+			 *
+			 *	May be called from any thread.
+			 *
+			 *	\param [in] value
+			 *		The element.
+			 */
+			void push (T value) {
+
+				auto n=new node{std::move(value),head_.load(std::memory_order_relaxed)};
+				while (!head_.compare_exchange_weak(n->next,n,std::memory_order_release,std::memory_order_relaxed));
+
+			}
+
+
+			/**
+			 *	Removes every element from the queue and passes each
+			 *	to a function in the order in which they were pushed.
+			 *
+			 *	Must not be called by more than one thread at a time.
+			 *	If the function throws the elements which it has not
+			 *	been passed are destroyed.
+			 *
+			 *	\param [in] func
+			 *		A function which accepts an rvalue of type \em T.
+			 *
+			 *	\return
+			 *		The number of elements removed.
+			 */
+			template <typename F>
+			std::size_t consume (F && func) {
+
+				auto n=head_.exchange(nullptr,std::memory_order_acquire);
+
+				//	Elements are pushed onto the front so the list
+				//	is in reverse order
+				node * list=nullptr;
+				while (n) {
+
+					auto next=n->next;
+					n->next=list;
+					list=n;
+					n=next;
+
+				}
+
+				auto g=make_scope_exit([&] () noexcept {	destroy(list);	});
+				std::size_t retr=0;
+				while (list) {
+
+					auto curr=list;
+					list=list->next;
+					auto h=make_scope_exit([&] () noexcept {	delete curr;	});
+					func(std::move(curr->value));
+					++retr;
+
+				}
+
+				return retr;
+
+			}
+
+
+			/**
+			 *	Determines whether the queue is empty.
+			 *
+			 *	The value returned is a snapshot which may be stale
+			 *	by the time it is examined.
+			 *
+			 *	\return
+			 *		\em true if the queue is empty, \em false
+			 *		otherwise.
+			 */
+			bool empty () const noexcept {
+
+				return head_.load(std::memory_order_relaxed)==nullptr;
+
+			}
+
+
+	};
+
+
+	/**
+	 *	A lock-free queue like \ref mpsc_queue except that
+	 *	elements are linked through a member rather than
+	 *	copied into nodes, so pushing never allocates.
+	 *
+	 *	The queue does not own its elements: An element must
+	 *	remain alive and must not be pushed again until it
+	 *	has been consumed, and elements which have not been
+	 *	consumed when the queue is destroyed are forgotten.
+	 *
+	 *	\tparam T
+	 *		The type of the elements.
+	 *	\tparam Next
+	 *		A pointer to the member of \em T through which
+	 *		elements are linked.
+	 */
+	template <typename T, T * T::* Next>
+	class intrusive_mpsc_queue {
+
+
+		private:
+
+
+			std::atomic<T *> head_;
+			//	Elements which a consumer removed but did not pass
+			//	to its function, in order, only ever accessed by
+			//	consumers
+			T * backlog_;
+
+
+		public:
+
+
+			intrusive_mpsc_queue (const intrusive_mpsc_queue &) = delete;
+			intrusive_mpsc_queue (intrusive_mpsc_queue &&) = delete;
+			intrusive_mpsc_queue & operator = (const intrusive_mpsc_queue &) = delete;
+			intrusive_mpsc_queue & operator = (intrusive_mpsc_queue &&) = delete;
+
+
+			intrusive_mpsc_queue () noexcept : head_(nullptr), backlog_(nullptr) {	}
+
+
+			/**
+			 *	Adds an element to the back of the queue.
+			 *
+			 *	May be called from any thread.
+			 *
+			 *	\param [in] value
+			 *		The element.
+			 */
+			void push (T & value) noexcept {
+
+				value.*Next=head_.load(std::memory_order_relaxed);
+				while (!head_.compare_exchange_weak(value.*Next,&value,std::memory_order_release,std::memory_order_relaxed));
+
+			}
+
+
+			/**
+			 *	Removes every element from the queue and passes each
+			 *	to a function in the order in which they were pushed.
+			 *
+			 *	Must not be called by more than one thread at a time.
+			 *	If the function throws the elements which it has not
+			 *	been passed remain at the front of the queue.
+			 *
+			 *	\param [in] func
+			 *		A function which accepts an lvalue of type \em T.
+			 *
+			 *	\return
+			 *		The number of elements removed.
+			 */
+			template <typename F>
+			std::size_t consume (F && func) {
+
+				auto n=head_.exchange(nullptr,std::memory_order_acquire);
+
+				//	Elements are pushed onto the front so the list
+				//	is in reverse order, those pushed since the
+				//	backlog was formed follow it
+				T * list=nullptr;
+				while (n) {
+
+					auto next=n->*Next;
+					n->*Next=list;
+					list=n;
+					n=next;
+
+				}
+				if (backlog_) {
+
+					auto tail=backlog_;
+					while (tail->*Next) tail=tail->*Next;
+					tail->*Next=list;
+					list=backlog_;
+					backlog_=nullptr;
+
+				}
+
+				auto g=make_scope_exit([&] () noexcept {	backlog_=list;	});
+				std::size_t retr=0;
+				while (list) {
+
+					auto & curr=*list;
+					list=curr.*Next;
+					curr.*Next=nullptr;
+					func(curr);
+					++retr;
+
+				}
+
+				return retr;
+
+			}
+
+
+			/**
+			 *	Determines whether the queue is empty.
+			 *
+			 *	Must not be called concurrently with \ref consume.
+			 *	The value returned is a snapshot which may be stale
+			 *	by the time it is examined.
+			 *
+			 *	\return
+			 *		\em true if the queue is empty, \em false
+			 *		otherwise.
+			 */
+			bool empty () const noexcept {
+
+				return (head_.load(std::memory_order_relaxed)==nullptr) && (backlog_==nullptr);
+
+			}
+
+
+	};
+
+
+}
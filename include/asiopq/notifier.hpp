@@ -0,0 +1,156 @@
+/**
+ *	\file
+ */
+
+
+#pragma once
+
+
+#include "optional.hpp"
+#include <libpq-fe.h>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+namespace asiopq {
+
+
+	/**
+	 *	Tracks the subscribers to each channel on which
+	 *	a single connection is listening and fans
+	 *	notifications out to them.
+	 *
+	 *	Not thread safe, each \ref connection uses its own
+	 *	instance on its own strand.
+	 */
+	class notifier {
+
+
+		public:
+
+
+			/**
+			 *	The type of a function which is invoked for each
+			 *	notification on a channel.
+			 */
+			using handler_type=std::function<void (const PGnotify &)>;
+			/**
+			 *	The type of a value which identifies a subscription.
+			 */
+			using subscription_type=std::size_t;
+
+
+		private:
+
+
+			class entry {
+
+
+				public:
+
+
+					subscription_type id;
+					handler_type handler;
+
+
+			};
+
+
+			using map_type=std::unordered_map<std::string,std::vector<entry>>;
+
+
+			map_type channels_;
+			//	Elements of an std::unordered_map are not moved
+			//	by rehashing
+			std::unordered_map<subscription_type,map_type::value_type *> ids_;
+
+
+		public:
+
+
+			/**
+			 *	Determines whether a channel has any subscribers.
+			 *
+			 *	\param [in] channel
+			 *		The name of the channel.
+			 *
+			 *	\return
+			 *		\em true if the channel has at least one
+			 *		subscriber, \em false otherwise.
+			 */
+			bool listening (const std::string & channel) const;
+			/**
+			 *	Subscribes to a channel.
+			 *
+			 *	\param [in] id
+			 *		A value which identifies the subscription.  Must
+			 *		not identify any other subscription.  Allocating
+			 *		these is left to the caller so that they may be
+			 *		allocated on a different thread.
+			 *	\param [in] channel
+			 *		The name of the channel.
+			 *	\param [in] handler
+			 *		The function to invoke for each notification on
+			 *		\em channel.
+			 */
+			void subscribe (subscription_type id, const std::string & channel, handler_type handler);
+			/**
+			 *	Ends a subscription.
+			 *
+			 *	\param [in] id
+			 *		A value passed to \ref subscribe.  If the
+			 *		subscription has already ended nothing happens.
+			 *
+			 *	\return
+			 *		The name of the channel if this was its last
+			 *		subscriber, otherwise nothing.
+			 */
+			optional<std::string> unsubscribe (subscription_type id);
+			/**
+			 *	Invokes the handler of each subscriber to the
+			 *	channel on which a notification was received.
+			 *
+			 *	Every handler is invoked even if some throw.  If
+			 *	any throws the first exception is rethrown after
+			 *	the last handler returns.
+			 *
+			 *	\param [in] notify
+			 *		The notification.
+			 */
+			void dispatch (const PGnotify & notify) const;
+
+
+			/**
+			 *	Retrieves the name of every channel which has at
+			 *	least one subscriber.
+			 *
+			 *	\return
+			 *		The names.
+			 */
+			std::vector<std::string> channels () const;
+			/**
+			 *	Determines whether there are no subscribers.
+			 *
+			 *	\return
+			 *		\em true if no channel has a subscriber, \em false
+			 *		otherwise.
+			 */
+			bool empty () const noexcept;
+			/**
+			 *	Retrieves the number of channels which have at
+			 *	least one subscriber.
+			 *
+			 *	\return
+			 *		A count of channels.
+			 */
+			std::size_t size () const noexcept;
+
+
+	};
+
+
+}
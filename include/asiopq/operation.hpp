@@ -7,9 +7,14 @@
 
 
 #include "optional.hpp"
+#include "priority.hpp"
 #include <libpq-fe.h>
 #include <chrono>
+#include <cstddef>
 #include <exception>
+#include <memory>
+#include <string>
+#include <system_error>
 
 
 namespace asiopq {
@@ -21,6 +26,51 @@ namespace asiopq {
 	class operation {
 
 
+		private:
+
+
+			friend class connection;
+			friend class pending_queue;
+
+
+			//	Links the operation into the queues of the connection
+			//	to which it was added so that adding it, waiting
+			//	for it to begin, and informing it of its completion
+			//	allocate nothing, the reference to itself keeps it
+			//	alive while it is linked
+			operation * next_=nullptr;
+			std::shared_ptr<operation> self_;
+			priority cls_=priority::normal;
+			std::chrono::steady_clock::time_point enqueued_;
+			optional<std::chrono::steady_clock::time_point> deadline_;
+			std::size_t sequence_=0;
+			std::exception_ptr ex_;
+			std::error_code ec_;
+			//	Shared by every operation which failed with the
+			//	same libpq error message
+			std::shared_ptr<const std::string> message_;
+
+
+		protected:
+
+
+			/**
+			 *	Causes the operation to complete with an error
+			 *	rather than successfully once \ref begin or
+			 *	\ref perform next returns \ref operation_status::done.
+			 *
+			 *	Allows derived classes to fail without throwing
+			 *	(see \ref complete).  If either then throws the
+			 *	exception takes precedence.
+			 *
+			 *	\param [in] ec
+			 *		The error.  If this is \ref errc::connection_failed
+			 *		the libpq error message is passed to \ref complete
+			 *		as well.
+			 */
+			void set_error (std::error_code ec) noexcept;
+
+
 		public:
 
 
@@ -103,7 +153,15 @@ namespace asiopq {
 				 *	The operation can only continue once the underlying libpq
 				 *	socket may be written or read without blocking.
 				 */
-				read_write
+				read_write,
+				/**
+				 *	The operation can only continue once it is explicitly
+				 *	resumed by passing it to \ref connection::resume.  Until then
+				 *	the connection does not wait on the underlying libpq
+				 *	socket at all (although the operation may still time
+				 *	out).
+				 */
+				suspend
 
 			};
 
@@ -117,13 +175,45 @@ namespace asiopq {
 			 *
 			 *	If any of this operation's handlers threw an exception
 			 *	this is passed through the \em ex parameter otherwise
-			 *	that parameter is a null std::exception_ptr.
+			 *	that parameter is a null std::exception_ptr.  Errors
+			 *	which arise without an exception being thrown are
+			 *	instead passed to the overload which accepts a
+			 *	std::error_code.
+			 *
+			 *	Unless the operation is aborted by the destruction of
+			 *	the \ref connection this is invoked only once the
+			 *	connection has finished with the operation (see
+			 *	\ref connection::completion_executor), by which time
+			 *	the next operation may already have begun.
 			 *
 			 *	\param [in] ex
 			 *		A std::exception_ptr representing an exception thrown
 			 *		in the execution of this operation, if any.
 			 */
 			virtual void complete (std::exception_ptr ex) = 0;
+			/**
+			 *	Invoked instead of the overload which accepts a
+			 *	std::exception_ptr when the operation fails without
+			 *	an exception having been thrown: When it is aborted
+			 *	or times out, when the connection fails in pipeline
+			 *	mode, or when \ref set_error was invoked.  Otherwise
+			 *	behaves identically.
+			 *
+			 *	Operations which override this overload fail without
+			 *	anything being thrown or allocated.  The default
+			 *	implementation creates the corresponding exception
+			 *	(\ref aborted, \ref timed_out, \ref connection_error
+			 *	or, for other errors, std::system_error) and passes
+			 *	it to the other overload.
+			 *
+			 *	\param [in] ec
+			 *		The error, usually of \ref errc.
+			 *	\param [in] message
+			 *		The libpq error message if \em ec is
+			 *		\ref errc::connection_failed, otherwise empty.
+			 *		Only valid for the duration of the call.
+			 */
+			virtual void complete (std::error_code ec, const std::string & message);
 
 
 			/**
@@ -159,9 +249,18 @@ namespace asiopq {
 			 *	Retrieves the timeout for this operation.
 			 *
 			 *	This is the total amount of time this operation
-			 *	is permitted to take.  Should the operation take
-			 *	longer than this then \ref complete will be invoked
-			 *	with an error.
+			 *	is permitted to take, measured from the moment it
+			 *	is passed to \ref connection::add.  Should the
+			 *	operation take longer than this then \ref complete
+			 *	will be invoked with an error.  If it runs out of
+			 *	time while waiting to begin it is completed without
+			 *	\ref begin being invoked.
+			 *
+			 *	If the server is still executing the operation when
+			 *	it times out the \ref connection cancels that execution
+			 *	and discards any remaining results before beginning the
+			 *	next operation.  If that does not finish within this
+			 *	timeout the connection is reset.
 			 *
 			 *	\return
 			 *		The timeout for this operation.
@@ -0,0 +1,654 @@
+/**
+ *	\file
+ */
+
+
+#pragma once
+
+
+#include "optional.hpp"
+#include "prepared_query.hpp"
+#include "types.hpp"
+#include <libpq-fe.h>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+
+namespace asiopq {
+
+
+	/**
+	 *	Writes an unsigned integer in network byte order.
+	 *
+	 *	\tparam T
+	 *		An unsigned integer type.
+	 *
+	 *	\param [in] value
+	 *		The integer.
+	 *	\param [out] ptr
+	 *		A pointer to \em sizeof(T) bytes.
+	 */
+	template <typename T>
+	void put_network (T value, char * ptr) noexcept {
+
+		static_assert(std::is_unsigned<T>::value,"Only unsigned integers may be written");
+
+		for (auto i=sizeof(T);i!=0;--i) {
+
+			ptr[i-1]=static_cast<char>(static_cast<unsigned char>(value&0xFFU));
+			value=static_cast<T>(value>>8);
+
+		}
+
+	}
+
+
+	/**
+	 *	Describes how values of a C++ type are sent to the server
+	 *	in binary format.
+	 *
+	 *	Each specialization has:
+	 *
+	 *	- A static constexpr member \em oid giving the OID of the
+	 *	  corresponding PostgreSQL type
+	 *	- A static constexpr member \em size giving the number of
+	 *	  bytes of every value, or zero if that varies
+	 *	- A static member function \em null which determines whether
+	 *	  a value is sent as NULL
+	 *	- A static member function \em length which returns the number
+	 *	  of bytes of a value
+	 *	- A static member function \em encode which writes that many
+	 *	  bytes
+	 *
+	 *	May be specialized for other types.
+	 *
+	 *	\tparam T
+	 *		The type.
+	 */
+	template <typename T, typename=void>
+	class param_traits;
+
+
+	template <typename T>
+	class param_traits<T,std::enable_if_t<
+		std::is_integral<T>::value &&
+		std::is_signed<T>::value &&
+		((sizeof(T)==2) || (sizeof(T)==4) || (sizeof(T)==8))
+	>> {
+
+
+		public:
+
+
+			//	int2, int4, or int8
+			static constexpr Oid oid=(sizeof(T)==2) ? 21 : ((sizeof(T)==4) ? 23 : 20);
+			static constexpr std::size_t size=sizeof(T);
+
+
+			static constexpr bool null (T) noexcept {
+
+				return false;
+
+			}
+
+
+			static constexpr std::size_t length (T) noexcept {
+
+				return size;
+
+			}
+
+
+			static void encode (T value, char * ptr) noexcept {
+
+				put_network(static_cast<std::make_unsigned_t<T>>(value),ptr);
+
+			}
+
+
+	};
+
+
+	template <>
+	class param_traits<bool> {
+
+
+		public:
+
+
+			static constexpr Oid oid=16;
+			static constexpr std::size_t size=1;
+
+
+			static constexpr bool null (bool) noexcept {
+
+				return false;
+
+			}
+
+
+			static constexpr std::size_t length (bool) noexcept {
+
+				return size;
+
+			}
+
+
+			static void encode (bool value, char * ptr) noexcept {
+
+				*ptr=value ? 1 : 0;
+
+			}
+
+
+	};
+
+
+	template <typename T>
+	class param_traits<T,std::enable_if_t<std::is_floating_point<T>::value && ((sizeof(T)==4) || (sizeof(T)==8))>> {
+
+
+		private:
+
+
+			static_assert(std::numeric_limits<T>::is_iec559,"PostgreSQL requires IEEE 754 floating point");
+
+
+			using integer_type=std::conditional_t<sizeof(T)==4,std::uint32_t,std::uint64_t>;
+
+
+		public:
+
+
+			//	float4 or float8
+			static constexpr Oid oid=(sizeof(T)==4) ? 700 : 701;
+			static constexpr std::size_t size=sizeof(T);
+
+
+			static constexpr bool null (T) noexcept {
+
+				return false;
+
+			}
+
+
+			static constexpr std::size_t length (T) noexcept {
+
+				return size;
+
+			}
+
+
+			static void encode (T value, char * ptr) noexcept {
+
+				integer_type i;
+				std::memcpy(&i,&value,sizeof(i));
+				put_network(i,ptr);
+
+			}
+
+
+	};
+
+
+	template <>
+	class param_traits<std::string> {
+
+
+		public:
+
+
+			static constexpr Oid oid=25;
+			static constexpr std::size_t size=0;
+
+
+			static bool null (const std::string &) noexcept {
+
+				return false;
+
+			}
+
+
+			static std::size_t length (const std::string & value) noexcept {
+
+				return value.size();
+
+			}
+
+
+			static void encode (const std::string & value, char * ptr) noexcept {
+
+				std::memcpy(ptr,value.data(),value.size());
+
+			}
+
+
+	};
+
+
+	template <>
+	class param_traits<const char *> {
+
+
+		public:
+
+
+			static constexpr Oid oid=25;
+			static constexpr std::size_t size=0;
+
+
+			//	A null pointer is sent as NULL
+			static bool null (const char * value) noexcept {
+
+				return value==nullptr;
+
+			}
+
+
+			static std::size_t length (const char * value) noexcept {
+
+				return value ? std::strlen(value) : 0;
+
+			}
+
+
+			static void encode (const char * value, char * ptr) noexcept {
+
+				std::memcpy(ptr,value,std::strlen(value));
+
+			}
+
+
+	};
+
+
+	template <>
+	class param_traits<bytea> {
+
+
+		public:
+
+
+			static constexpr Oid oid=17;
+			static constexpr std::size_t size=0;
+
+
+			static bool null (const bytea &) noexcept {
+
+				return false;
+
+			}
+
+
+			static std::size_t length (const bytea & value) noexcept {
+
+				return value.size;
+
+			}
+
+
+			static void encode (const bytea & value, char * ptr) noexcept {
+
+				if (value.size!=0) std::memcpy(ptr,value.data,value.size);
+
+			}
+
+
+	};
+
+
+	template <>
+	class param_traits<uuid> {
+
+
+		public:
+
+
+			static constexpr Oid oid=2950;
+			static constexpr std::size_t size=16;
+
+
+			static bool null (const uuid &) noexcept {
+
+				return false;
+
+			}
+
+
+			static constexpr std::size_t length (const uuid &) noexcept {
+
+				return size;
+
+			}
+
+
+			static void encode (const uuid & value, char * ptr) noexcept {
+
+				std::memcpy(ptr,value.bytes.data(),size);
+
+			}
+
+
+	};
+
+
+	template <typename Duration>
+	class param_traits<std::chrono::time_point<std::chrono::system_clock,Duration>> {
+
+
+		private:
+
+
+			using time_point=std::chrono::time_point<std::chrono::system_clock,Duration>;
+
+
+			//	Seconds from the UNIX epoch to the PostgreSQL
+			//	epoch (2000-01-01 00:00:00 UTC)
+			static constexpr std::int64_t epoch=946684800;
+
+
+		public:
+
+
+			//	timestamptz, sent as microseconds since the
+			//	PostgreSQL epoch
+			static constexpr Oid oid=1184;
+			static constexpr std::size_t size=8;
+
+
+			static constexpr bool null (const time_point &) noexcept {
+
+				return false;
+
+			}
+
+
+			static constexpr std::size_t length (const time_point &) noexcept {
+
+				return size;
+
+			}
+
+
+			static void encode (const time_point & value, char * ptr) noexcept {
+
+				auto us=std::chrono::duration_cast<std::chrono::microseconds>(value.time_since_epoch()).count();
+				param_traits<std::int64_t>::encode(static_cast<std::int64_t>(us)-(epoch*1000000),ptr);
+
+			}
+
+
+	};
+
+
+	template <typename T>
+	class param_traits<optional<T>> {
+
+
+		private:
+
+
+			using traits=param_traits<T>;
+
+
+		public:
+
+
+			static constexpr Oid oid=traits::oid;
+			static constexpr std::size_t size=traits::size;
+
+
+			static bool null (const optional<T> & value) noexcept {
+
+				return !value || traits::null(*value);
+
+			}
+
+
+			static std::size_t length (const optional<T> & value) noexcept {
+
+				return value ? traits::length(*value) : 0;
+
+			}
+
+
+			static void encode (const optional<T> & value, char * ptr) noexcept {
+
+				traits::encode(*value,ptr);
+
+			}
+
+
+	};
+
+
+	/**
+	 *	Encodes the parameters of a query in binary format.
+	 *
+	 *	The OIDs and formats of the parameters are determined at
+	 *	compile time.  The values are encoded into a single buffer
+	 *	which is stored inline unless the values are too large,
+	 *	in which case it is allocated once.
+	 *
+	 *	Since the pointers passed to libpq refer to the buffer
+	 *	objects of this type may be neither copied nor moved.
+	 *
+	 *	\tparam Ts
+	 *		The types of the parameters.  \ref param_traits must
+	 *		be specialized for each.
+	 */
+	template <typename... Ts>
+	class params {
+
+
+		public:
+
+
+			/**
+			 *	The number of bytes of variable length data which
+			 *	may be stored without allocating.
+			 */
+			static constexpr std::size_t small_size=128;
+
+
+		private:
+
+
+			static constexpr std::size_t count_=sizeof...(Ts);
+			static constexpr std::size_t fixed_=(std::size_t{0}+...+param_traits<Ts>::size);
+			//	Arrays may not have zero elements
+			static constexpr std::size_t extent_=(count_==0) ? 1 : count_;
+
+
+			static constexpr Oid types_ [extent_]={param_traits<Ts>::oid...};
+			static constexpr int formats_ [extent_]={(static_cast<void>(sizeof(Ts)),1)...};
+
+
+			const char * values_ [extent_];
+			int lengths_ [extent_];
+			char inline_ [fixed_+small_size];
+			std::unique_ptr<char []> heap_;
+
+
+			template <typename T>
+			static std::size_t variable (const T & value) noexcept {
+
+				//	Space for fixed size values is already
+				//	accounted for
+				if (param_traits<T>::size!=0) return 0;
+
+				return param_traits<T>::length(value);
+
+			}
+
+
+			template <typename T>
+			void bind (std::size_t i, char * & ptr, const T & value) {
+
+				using traits=param_traits<T>;
+
+				if (traits::null(value)) {
+
+					values_[i]=nullptr;
+					lengths_[i]=0;
+					return;
+
+				}
+
+				auto n=traits::length(value);
+				if (n>static_cast<std::size_t>(std::numeric_limits<int>::max())) throw std::length_error("Parameter too large");
+
+				traits::encode(value,ptr);
+				values_[i]=ptr;
+				lengths_[i]=static_cast<int>(n);
+				ptr+=n;
+
+			}
+
+
+		public:
+
+
+			params (const params &) = delete;
+			params (params &&) = delete;
+			params & operator = (const params &) = delete;
+			params & operator = (params &&) = delete;
+
+
+			/**
+			 *	Encodes parameters.
+			 *
+			 *	\param [in] args
+			 *		The values of the parameters.
+			 */
+			explicit params (const Ts &... args) {
+
+				std::size_t total=fixed_+(std::size_t{0}+...+variable(args));
+				char * ptr=inline_;
+				if (total>sizeof(inline_)) {
+
+					heap_.reset(new char [total]);
+					ptr=heap_.get();
+
+				}
+
+				std::size_t i=0;
+				(bind(i++,ptr,args),...);
+
+			}
+
+
+			/**
+			 *	Retrieves the number of parameters.
+			 *
+			 *	\return
+			 *		The number of parameters.
+			 */
+			static constexpr int count () noexcept {
+
+				return static_cast<int>(count_);
+
+			}
+			/**
+			 *	Retrieves the OIDs of the parameters.
+			 *
+			 *	\return
+			 *		An array of \ref count OIDs.
+			 */
+			static constexpr const Oid * types () noexcept {
+
+				return types_;
+
+			}
+			/**
+			 *	Retrieves the formats of the parameters.
+			 *
+			 *	\return
+			 *		An array of \ref count formats, each of which
+			 *		is one (binary).
+			 */
+			static constexpr const int * formats () noexcept {
+
+				return formats_;
+
+			}
+			/**
+			 *	Retrieves the encoded values of the parameters.
+			 *
+			 *	\return
+			 *		An array of \ref count pointers, each of which
+			 *		is null if the corresponding parameter is NULL.
+			 */
+			const char * const * values () const noexcept {
+
+				return values_;
+
+			}
+			/**
+			 *	Retrieves the lengths of the encoded values of the
+			 *	parameters.
+			 *
+			 *	\return
+			 *		An array of \ref count lengths.
+			 */
+			const int * lengths () const noexcept {
+
+				return lengths_;
+
+			}
+
+
+			/**
+			 *	Describes these parameters to a \ref prepared_query.
+			 *
+			 *	\param [in] result_format
+			 *		Zero to request results in text format, one to
+			 *		request them in binary format (see \ref typed_result).
+			 *
+			 *	\return
+			 *		A \ref prepared_query::parameters object which
+			 *		refers to this object.
+			 */
+			prepared_query::parameters describe (int result_format) const noexcept {
+
+				prepared_query::parameters retr;
+				retr.count=count();
+				retr.types=types();
+				retr.values=values();
+				retr.lengths=lengths();
+				retr.formats=formats();
+				retr.result_format=result_format;
+
+				return retr;
+
+			}
+			/**
+			 *	Describes these parameters to a \ref prepared_query,
+			 *	requesting results in text format.
+			 *
+			 *	\return
+			 *		A \ref prepared_query::parameters object which
+			 *		refers to this object.
+			 */
+			operator prepared_query::parameters () const noexcept {
+
+				return describe(0);
+
+			}
+
+
+	};
+
+
+	template <typename... Ts>
+	params (const Ts &...) -> params<std::decay_t<const Ts>...>;
+
+
+}
@@ -0,0 +1,273 @@
+/**
+ *	\file
+ */
+
+
+#pragma once
+
+
+#include "operation.hpp"
+#include "optional.hpp"
+#include "priority.hpp"
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+
+
+namespace asiopq {
+
+
+	/**
+	 *	Holds the operations which are waiting to begin on
+	 *	a single connection, one queue per \ref priority.
+	 *	Each queue is FIFO unless earliest deadline first
+	 *	ordering is enabled, in which case operations with
+	 *	earlier deadlines precede those with later (or no)
+	 *	deadlines.
+	 *
+	 *	The operation chosen next is the one at the head of
+	 *	the highest class after each head has been promoted
+	 *	by one class for each aging interval it has waited
+	 *	(between heads of equal class the one which has waited
+	 *	longest), so that no class is starved.  Operations pushed onto
+	 *	the front precede every class.
+	 *
+	 *	Operations are linked through hooks within them rather
+	 *	than copied into separately allocated storage, so an
+	 *	operation may be in at most one queue at a time.
+	 *
+	 *	Not thread safe, each \ref connection uses its own
+	 *	instance on its own strand.
+	 */
+	class pending_queue {
+
+
+		public:
+
+
+			/**
+			 *	The type of the operations held.
+			 */
+			using value_type=std::shared_ptr<operation>;
+			/**
+			 *	The clock against which waiting is measured.
+			 */
+			using clock_type=std::chrono::steady_clock;
+			/**
+			 *	The type of a point in time on \ref clock_type.
+			 */
+			using time_point=clock_type::time_point;
+			/**
+			 *	The type used to represent spans of time.
+			 */
+			using duration=clock_type::duration;
+
+
+			/**
+			 *	An operation which has been removed from the queue.
+			 */
+			class entry {
+
+
+				public:
+
+
+					/**
+					 *	The operation.
+					 */
+					value_type op;
+					/**
+					 *	The time at which it was enqueued.
+					 */
+					time_point enqueued;
+					/**
+					 *	The class with which it was enqueued, or nothing
+					 *	if it was pushed onto the front.
+					 */
+					optional<priority> cls;
+					/**
+					 *	The time by which it must complete, if any.
+					 */
+					optional<time_point> deadline;
+					/**
+					 *	The order in which it was enqueued.
+					 */
+					std::size_t sequence;
+
+
+			};
+
+
+		private:
+
+
+			static constexpr std::size_t none=~std::size_t(0);
+
+
+			//	A singly linked list of operations through their
+			//	hooks, each owned by its reference to itself
+			class list {
+
+
+				public:
+
+
+					operation * head=nullptr;
+					operation * tail=nullptr;
+
+
+			};
+
+
+			//	LIFO
+			list front_;
+			//	Ordered so that the head is the next to be
+			//	removed
+			std::array<list,priorities> classes_;
+			duration aging_;
+			bool edf_;
+			std::size_t size_;
+			std::size_t sequence_;
+			//	The class chosen by the last call to front,
+			//	priorities for front_, or none if it must be
+			//	chosen again
+			std::size_t selected_;
+
+
+			bool later (const operation &, const operation &) const noexcept;
+			void insert (list &, operation &) noexcept;
+			std::size_t select (time_point);
+
+
+		public:
+
+
+			/**
+			 *	Creates an empty queue.
+			 *
+			 *	\param [in] aging
+			 *		The aging interval.  Zero disables aging.
+			 */
+			explicit pending_queue (duration aging) noexcept;
+			pending_queue (const pending_queue &) = delete;
+			pending_queue (pending_queue &&) = delete;
+			pending_queue & operator = (const pending_queue &) = delete;
+			pending_queue & operator = (pending_queue &&) = delete;
+
+
+			/**
+			 *	Releases every operation in the queue.
+			 */
+			~pending_queue () noexcept;
+
+
+			/**
+			 *	Sets the aging interval.
+			 *
+			 *	\param [in] aging
+			 *		The aging interval.  Zero disables aging.
+			 */
+			void aging (duration aging) noexcept;
+			/**
+			 *	Enables or disables earliest deadline first ordering
+			 *	within each class.  Disabled by default.
+			 *
+			 *	\param [in] enable
+			 *		\em true to order by deadline, \em false to order
+			 *		by time of enqueuing.
+			 */
+			void earliest_deadline_first (bool enable);
+
+
+			/**
+			 *	Adds an operation to the back of the queue for its
+			 *	class.
+			 *
+			 *	\param [in] op
+			 *		The operation, which must not be in any queue.
+			 *	\param [in] cls
+			 *		The class.
+			 *	\param [in] when
+			 *		The time at which \em op was enqueued.
+			 *	\param [in] deadline
+			 *		The time by which \em op must complete, if any.
+			 */
+			void push_back (value_type op, priority cls, time_point when, optional<time_point> deadline=nullopt);
+			/**
+			 *	Adds an operation which precedes every other.
+			 *
+			 *	\param [in] op
+			 *		The operation, which must not be in any queue.
+			 */
+			void push_front (value_type op);
+
+
+			/**
+			 *	Retrieves the operation which would be removed next.
+			 *
+			 *	The choice is fixed until the queue is next modified.
+			 *
+			 *	\param [in] now
+			 *		The current time, against which waiting is
+			 *		measured.
+			 *
+			 *	\return
+			 *		A reference to the operation.
+			 */
+			const value_type & front (time_point now=clock_type::now());
+			/**
+			 *	Removes the operation which would be returned by
+			 *	\ref front.
+			 *
+			 *	\param [in] now
+			 *		The current time, used if \ref front has not
+			 *		been called since the queue was last modified.
+			 *
+			 *	\return
+			 *		The operation and the details of its enqueuing.
+			 */
+			entry pop_front (time_point now=clock_type::now());
+
+
+			/**
+			 *	Invokes a function for every operation in the queue.
+			 *
+			 *	\param [in] func
+			 *		A function which accepts a reference to a
+			 *		\ref value_type.
+			 */
+			template <typename F>
+			void for_each (F && func) {
+
+				for (auto o=front_.head;o;o=o->next_) func(o->self_);
+				for (auto && c : classes_) for (auto o=c.head;o;o=o->next_) func(o->self_);
+
+			}
+			/**
+			 *	Removes every operation.
+			 */
+			void clear () noexcept;
+
+
+			/**
+			 *	Determines whether the queue is empty.
+			 *
+			 *	\return
+			 *		\em true if the queue is empty, \em false
+			 *		otherwise.
+			 */
+			bool empty () const noexcept;
+			/**
+			 *	Retrieves the number of operations in the queue.
+			 *
+			 *	\return
+			 *		A count of operations.
+			 */
+			std::size_t size () const noexcept;
+
+
+	};
+
+
+}
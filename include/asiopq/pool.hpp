@@ -0,0 +1,291 @@
+/**
+ *	\file
+ */
+
+
+#pragma once
+
+
+#include "asio.hpp"
+#include "connection.hpp"
+#include "operation.hpp"
+#include "priority.hpp"
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+
+namespace asiopq {
+
+
+	/**
+	 *	Maintains a fixed number of \ref connection objects
+	 *	divided into shards, one per asio::io_service, and
+	 *	dispatches \ref operation objects thereto.
+	 *
+	 *	Neither dispatching an operation nor pinning a connection
+	 *	acquires a lock which is shared between connections:
+	 *	Connections are selected using only atomic operations.
+	 */
+	class pool {
+
+
+		public:
+
+
+			/**
+			 *	A smart pointer to an \ref operation.
+			 */
+			using operation_type=connection::operation_type;
+			/**
+			 *	A collection of asio::io_service objects, one for
+			 *	each shard of the pool.
+			 */
+			using io_services_type=std::vector<std::reference_wrapper<asio::io_service>>;
+
+
+		private:
+
+
+			class member {
+
+
+				public:
+
+
+					member (asiopq::connection conn, std::shared_ptr<std::atomic<unsigned>> health);
+
+
+					asiopq::connection connection;
+					//	The low bits count threads currently dispatching
+					//	to this connection, the high bit indicates that
+					//	the connection is pinned
+					std::atomic<std::size_t> state;
+					//	Whether the connection was established, shared
+					//	with the operations which establish it since they
+					//	may complete after this object is destroyed
+					std::shared_ptr<std::atomic<unsigned>> health;
+
+
+			};
+
+
+			std::vector<std::unique_ptr<member>> members_;
+			std::size_t size_;
+			std::string conninfo_;
+			asio::io_service * ios_;
+			operation::timeout_type timeout_;
+			std::once_flag once_;
+			std::unique_ptr<asiopq::connection> listener_;
+
+
+			void init (const char *, const io_services_type &, operation::timeout_type);
+			std::size_t shards () const noexcept;
+			std::size_t home () const noexcept;
+			member * select (std::size_t) const noexcept;
+			member * acquire () const noexcept;
+			member * pin_member () const noexcept;
+			void reconnect (member &);
+
+
+		public:
+
+
+			/**
+			 *	Allows a connection to be used exclusively for a period
+			 *	of time (e.g. the duration of a transaction).
+			 *
+			 *	While a connection is pinned \ref pool::add will not
+			 *	dispatch operations thereto.  The connection is unpinned
+			 *	when this object is destroyed.
+			 *
+			 *	The \ref pool from which this object was obtained must
+			 *	outlive it.
+			 */
+			class pinned {
+
+
+				private:
+
+
+					member * m_;
+
+
+				public:
+
+
+					pinned () = delete;
+					pinned (const pinned &) = delete;
+					pinned & operator = (const pinned &) = delete;
+					pinned & operator = (pinned &&) = delete;
+
+
+					explicit pinned (member &) noexcept;
+					pinned (pinned && rhs) noexcept;
+
+
+					/**
+					 *	Unpins the connection.
+					 */
+					~pinned () noexcept;
+
+
+					/**
+					 *	Enqueues an \ref operation to execute on the pinned
+					 *	connection.
+					 *
+					 *	\param [in] op
+					 *		The \ref operation to execute.
+					 *	\param [in] cls
+					 *		The class of priority of \em op.
+					 */
+					void add (operation_type op, priority cls=priority::normal);
+
+
+					/**
+					 *	Retrieves the pinned connection.
+					 *
+					 *	\return
+					 *		A reference to a \ref asiopq::connection.
+					 */
+					asiopq::connection & connection () const noexcept;
+
+
+			};
+
+
+			pool () = delete;
+			pool (const pool &) = delete;
+			pool (pool &&) = delete;
+			pool & operator = (const pool &) = delete;
+			pool & operator = (pool &&) = delete;
+
+
+			/**
+			 *	Creates a pool with a single shard.
+			 *
+			 *	\param [in] conninfo
+			 *		See libpq documentation for PQconnectStart.
+			 *	\param [in] size
+			 *		The number of connections to create.
+			 *	\param [in] ios
+			 *		The asio::io_service which the connections shall
+			 *		use to dispatch asynchronous operations.
+			 *	\param [in] timeout
+			 *		A \ref operation::timeout_type object giving the
+			 *		amount of time each connection attempt is permitted
+			 *		to take at maximum.  Defaults to no timeout.
+			 */
+			pool (const char * conninfo, std::size_t size, asio::io_service & ios, operation::timeout_type timeout=operation::timeout_type{});
+			/**
+			 *	Creates a pool with one shard for each of a collection
+			 *	of asio::io_service objects.
+			 *
+			 *	It is intended that each asio::io_service be run by a
+			 *	different thread (or group of threads).
+			 *
+			 *	\param [in] conninfo
+			 *		See libpq documentation for PQconnectStart.
+			 *	\param [in] size
+			 *		The number of connections to create for each
+			 *		shard.
+			 *	\param [in] ios
+			 *		The asio::io_service objects, one for each shard.
+			 *	\param [in] timeout
+			 *		A \ref operation::timeout_type object giving the
+			 *		amount of time each connection attempt is permitted
+			 *		to take at maximum.  Defaults to no timeout.
+			 */
+			pool (const char * conninfo, std::size_t size, const io_services_type & ios, operation::timeout_type timeout=operation::timeout_type{});
+
+
+			/**
+			 *	Enqueues an \ref operation to execute on the least
+			 *	loaded connection which is not pinned.
+			 *
+			 *	A thread running the asio::io_service of a shard searches
+			 *	that shard first, other threads are associated with a
+			 *	shard round robin.  Other shards are searched only if
+			 *	every connection in that shard is pinned.
+			 *
+			 *	Connections which failed to connect are only chosen if
+			 *	no connection in the shard connected.  Choosing such a
+			 *	connection first enqueues a \ref reset thereupon, so
+			 *	connections are re-established as they are needed.
+			 *
+			 *	If every connection is pinned std::runtime_error is
+			 *	thrown.
+			 *
+			 *	\param [in] op
+			 *		The \ref operation to execute.
+			 *	\param [in] cls
+			 *		The class of priority of \em op.
+			 */
+			void add (operation_type op, priority cls=priority::normal);
+
+
+			/**
+			 *	Pins the least loaded connection which is not
+			 *	already pinned.
+			 *
+			 *	Operations already enqueued on the connection run before
+			 *	those enqueued through the returned object.
+			 *
+			 *	If every connection is pinned std::runtime_error is
+			 *	thrown.
+			 *
+			 *	\return
+			 *		A \ref pinned object.
+			 */
+			pinned pin ();
+
+
+			/**
+			 *	Retrieves a connection dedicated to receiving
+			 *	notifications (see \ref connection::subscribe).
+			 *
+			 *	The connection is created (using the asio::io_service
+			 *	of the first shard) the first time this function is
+			 *	called.  It is not counted by \ref pool::size and
+			 *	operations are never dispatched to it by \ref pool::add
+			 *	nor is it ever pinned, so its subscribers are not
+			 *	delayed by other operations.
+			 *
+			 *	\return
+			 *		A reference to a \ref asiopq::connection.
+			 */
+			asiopq::connection & listener ();
+
+
+			/**
+			 *	Retrieves the number of connections in the pool which
+			 *	failed to connect (or whose most recent reset failed)
+			 *	and which have not since been re-established.
+			 *
+			 *	As with \ref connection::size the value returned is a
+			 *	lock-free snapshot.
+			 *
+			 *	\return
+			 *		A count of connections.
+			 */
+			std::size_t failed () const noexcept;
+
+
+			/**
+			 *	Retrieves the total number of connections in the
+			 *	pool.
+			 *
+			 *	\return
+			 *		A count of connections.
+			 */
+			std::size_t size () const noexcept;
+
+
+	};
+
+
+}
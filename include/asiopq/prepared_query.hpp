@@ -0,0 +1,157 @@
+/**
+ *	\file
+ */
+
+
+#pragma once
+
+
+#include "query.hpp"
+#include "statement_cache.hpp"
+#include <libpq-fe.h>
+#include <cstddef>
+#include <exception>
+#include <string>
+#include <vector>
+
+
+namespace asiopq {
+
+
+	class connection;
+
+
+	/**
+	 *	An abstract base class for queries which are
+	 *	prepared automatically.
+	 *
+	 *	The first time (or, depending on the connection's
+	 *	configuration, the Nth time) a given SQL text is
+	 *	executed on a \ref connection it is prepared with
+	 *	PQsendPrepare.  Thereafter it is executed with
+	 *	PQsendQueryPrepared so that the server need not parse
+	 *	and plan it again.  See \ref connection::cache.
+	 *
+	 *	A query which must be prepared runs exclusively even
+	 *	in pipeline mode, once prepared it may be pipelined.
+	 *
+	 *	The SQL text must consist of a single statement and
+	 *	must not depend on the search path or other session
+	 *	state changing between executions.
+	 */
+	class prepared_query : public query {
+
+
+		public:
+
+
+			/**
+			 *	Describes the parameters of a query.
+			 *
+			 *	The members have the same meaning as the
+			 *	corresponding arguments of PQsendQueryParams.
+			 */
+			class parameters {
+
+
+				public:
+
+
+					int count=0;
+					const Oid * types=nullptr;
+					const char * const * values=nullptr;
+					const int * lengths=nullptr;
+					const int * formats=nullptr;
+					int result_format=0;
+
+
+			};
+
+
+		private:
+
+
+			friend class connection;
+
+
+			enum class state {
+
+				fresh,
+				deallocating,
+				preparing,
+				executing
+
+			};
+
+
+			std::string sql_;
+			state state_;
+			statement_cache * cache_;
+			std::string name_;
+			std::exception_ptr ex_;
+			//	Names of statements being deallocated and how many
+			//	of them the server has dealt with
+			std::vector<std::string> garbage_;
+			std::size_t deallocated_;
+
+
+			void deallocate (native_handle_type);
+			void prepare (native_handle_type);
+			void execute (native_handle_type);
+			operation_status step (native_handle_type);
+
+
+		protected:
+
+
+			/**
+			 *	Retrieves the parameters with which the query
+			 *	shall be executed.
+			 *
+			 *	The memory referred to thereby must remain valid
+			 *	until \ref operation::complete is invoked.  The
+			 *	types (if any) are only used when preparing the query.
+			 *
+			 *	The default implementation returns no parameters.
+			 *
+			 *	\return
+			 *		A \ref parameters object.
+			 */
+			virtual parameters bind ();
+
+
+		public:
+
+
+			/**
+			 *	Creates a new prepared_query object.
+			 *
+			 *	\param [in] sql
+			 *		The SQL text of the query.
+			 *	\param [in] timeout
+			 *		A \ref operation::timeout_type object giving the
+			 *		amount of time this operation is permitted to
+			 *		take at maximum.  Defaults to no timeout which
+			 *		means this operation may take infinitely long.
+			 */
+			explicit prepared_query (std::string sql, timeout_type timeout=timeout_type{});
+
+
+			/**
+			 *	Retrieves the SQL text of the query.
+			 *
+			 *	\return
+			 *		The SQL text.
+			 */
+			const std::string & sql () const noexcept;
+
+
+			virtual void send (native_handle_type) override final;
+			virtual bool pipelinable () const noexcept override;
+			virtual operation_status perform (native_handle_type, socket_status) override;
+
+
+	};
+
+
+}
@@ -0,0 +1,48 @@
+/**
+ *	\file
+ */
+
+
+#pragma once
+
+
+#include <cstddef>
+
+
+namespace asiopq {
+
+
+	/**
+	 *	An enumeration of the classes of priority with which
+	 *	an \ref operation may be enqueued on a \ref connection.
+	 *
+	 *	Operations of a higher class begin before those of a
+	 *	lower class which were enqueued earlier, subject to
+	 *	aging (see \ref connection::aging).
+	 */
+	enum class priority {
+
+		/**
+		 *	Latency sensitive operations.
+		 */
+		interactive,
+		/**
+		 *	The class of operations enqueued without specifying
+		 *	one.
+		 */
+		normal,
+		/**
+		 *	Operations which may wait behind any other.
+		 */
+		batch
+
+	};
+
+
+	/**
+	 *	The number of members of \ref priority.
+	 */
+	constexpr std::size_t priorities=3;
+
+
+}
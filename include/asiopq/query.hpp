@@ -37,8 +37,105 @@ namespace asiopq {
 			bool flushed_;
 
 
-			void flush (native_handle_type);
+			//	Instead of throwing these set the error with which
+			//	the query completes and return false
+			bool flush (native_handle_type) noexcept;
 			operation_status get_status () const noexcept;
+			bool consume_input (native_handle_type) noexcept;
+
+
+		protected:
+
+
+			/**
+			 *	Determines whether the query, command, et cetera has
+			 *	been completely sent to the server.
+			 *
+			 *	\return
+			 *		\em true if everything has been sent, \em false
+			 *		otherwise.
+			 */
+			bool flushed () const noexcept;
+			/**
+			 *	Sends a further command by invoking \ref send again.
+			 *
+			 *	Only permitted once every result of the previous
+			 *	command has been retrieved (i.e. PQgetResult has
+			 *	returned a null pointer).  Not permitted in pipeline
+			 *	mode.
+			 *
+			 *	\param [in] handle
+			 *		A handle to the current libpq connection.
+			 *
+			 *	\return
+			 *		The status to return from \ref operation::perform.
+			 */
+			operation_status restart (native_handle_type handle);
+			/**
+			 *	Flushes what has been sent to the server.
+			 *
+			 *	\ref begin invokes this after \ref send, and derived
+			 *	classes which override \ref begin should likewise.
+			 *
+			 *	\param [in] handle
+			 *		A handle to the current libpq connection.
+			 *
+			 *	\return
+			 *		The status to return from \ref operation::begin.
+			 */
+			operation_status sent (native_handle_type handle);
+			/**
+			 *	Does what \ref perform does except that results are
+			 *	passed to a function rather than to \ref result, so
+			 *	that derived classes which override \ref perform may
+			 *	have each result handled without a virtual call.
+			 *
+			 *	\param [in] handle
+			 *		A handle to the current libpq connection.
+			 *	\param [in] status
+			 *		The current socket status.
+			 *	\param [in] func
+			 *		A function which accepts a \ref native_result_type
+			 *		with the same contract as \ref result.
+			 *
+			 *	\return
+			 *		The status to return from \ref operation::perform.
+			 */
+			template <typename F>
+			operation_status receive (native_handle_type handle, socket_status status, F && func) {
+
+				if (!flushed_) {
+
+					//	If it becomes read-ready, call PQconsumeInput...
+					if ((status==socket_status::readable) && !consume_input(handle)) return operation_status::done;
+					//	...then call PQflush again.
+					//
+					//	If it becomes write-ready, call PQflush again.
+					if (!flush(handle)) return operation_status::done;
+
+					return get_status();
+
+				}
+
+				//	When the main loop detects input ready, it should call PQconsumeInput to read
+				//	the input.
+				if (!consume_input(handle)) return operation_status::done;
+
+				//	It can then call PQisBusy, followed by PQgetResult if PQisBusy returns false (0).
+				while (PQisBusy(handle)==0) {
+
+					auto res=PQgetResult(handle);
+					//	PQgetResult must be called repeatedly until it returns a null pointer,
+					//	indicating that the command is done.
+					if (!res) return operation_status::done;
+
+					func(res);
+
+				}
+
+				return operation_status::read;
+
+			}
 
 
 		public:
@@ -85,6 +182,21 @@ namespace asiopq {
 			 *		A libpq handle to the result.
 			 */
 			virtual void result (native_result_type result);
+			/**
+			 *	Determines whether this query may be sent while the
+			 *	connection is in pipeline mode (see
+			 *	\ref connection::pipeline).
+			 *
+			 *	Queries which may not are run exclusively as if
+			 *	pipeline mode were disabled.
+			 *
+			 *	The default implementation returns \em true.
+			 *
+			 *	\return
+			 *		\em true if this query may be pipelined, \em false
+			 *		otherwise.
+			 */
+			virtual bool pipelinable () const noexcept;
 
 
 			virtual operation_status begin (native_handle_type) override;
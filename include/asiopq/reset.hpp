@@ -14,6 +14,48 @@
 namespace asiopq {
 
 
+	/**
+	 *	An abstract base class for the operation of
+	 *	resetting the connection to a Postgres database.
+	 *
+	 *	Derived classes implement \ref operation::complete.
+	 *
+	 *	For more information see the libpq documentation
+	 *	of the PQresetStart and PQresetPoll functions.
+	 */
+	class basic_reset : public operation {
+
+
+		private:
+
+
+			timeout_type timeout_;
+
+
+		public:
+
+
+			/**
+			 *	Creates a basic_reset object.
+			 *
+			 *	\param [in] timeout
+			 *		A \ref operation::timeout_type object giving
+			 *		the amount of time this operation is permitted
+			 *		to take at maximum.  Defaults to no timeout
+			 *		which means this operation may take infinitely
+			 *		long.
+			 */
+			explicit basic_reset (timeout_type timeout=timeout_type{});
+
+
+			virtual operation_status begin (native_handle_type) override;
+			virtual operation_status perform (native_handle_type, socket_status) override;
+			virtual timeout_type timeout () override;
+
+
+	};
+
+
 	/**
 	 *	Represents the operation of resetting the
 	 *	connection to a Postgres database.
@@ -21,14 +63,13 @@ namespace asiopq {
 	 *	For more information see the libpq documentation
 	 *	of the PQresetStart and PQresetPoll functions.
 	 */
-	class reset : public operation {
+	class reset : public basic_reset {
 
 
 		private:
 
 
 			promise<void> promise_;
-			timeout_type timeout_;
 
 
 		public:
@@ -48,9 +89,6 @@ namespace asiopq {
 
 
 			virtual void complete (std::exception_ptr) override;
-			virtual operation_status begin (native_handle_type) override;
-			virtual operation_status perform (native_handle_type, socket_status) override;
-			virtual timeout_type timeout () override;
 
 
 			/**
@@ -0,0 +1,761 @@
+/**
+ *	\file
+ */
+
+
+#pragma once
+
+
+#include "exception.hpp"
+#include "optional.hpp"
+#include "types.hpp"
+#include <libpq-fe.h>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+namespace asiopq {
+
+
+	/**
+	 *	Reads an unsigned integer in network byte order.
+	 *
+	 *	\tparam T
+	 *		An unsigned integer type.
+	 *
+	 *	\param [in] ptr
+	 *		A pointer to \em sizeof(T) bytes.
+	 *
+	 *	\return
+	 *		The integer.
+	 */
+	template <typename T>
+	T get_network (const char * ptr) noexcept {
+
+		static_assert(std::is_unsigned<T>::value,"Only unsigned integers may be read");
+
+		T retr=0;
+		for (std::size_t i=0;i<sizeof(T);++i) retr=static_cast<T>((retr<<8)|static_cast<unsigned char>(ptr[i]));
+
+		return retr;
+
+	}
+
+
+	/**
+	 *	A base class for \ref field_traits specializations
+	 *	whose type cannot represent NULL.
+	 *
+	 *	\tparam T
+	 *		The type.
+	 */
+	template <typename T>
+	class non_null_field {
+
+
+		public:
+
+
+			[[noreturn]]
+			static T null () {
+
+				throw decode_error("Unexpected NULL");
+
+			}
+
+
+	};
+
+
+	/**
+	 *	Describes how values of a C++ type are decoded from
+	 *	fields of a result in binary format.
+	 *
+	 *	Each specialization has:
+	 *
+	 *	- A static member function \em accepts which determines
+	 *	  whether fields with a certain OID may be decoded
+	 *	- A static member function \em null which returns the
+	 *	  value of a NULL field or throws
+	 *	- A static member function \em decode which decodes the
+	 *	  value of a field from a pointer and a length, throwing
+	 *	  \ref decode_error if that is not possible
+	 *
+	 *	May be specialized for other types.
+	 *
+	 *	\tparam T
+	 *		The type.
+	 */
+	template <typename T, typename=void>
+	class field_traits;
+
+
+	template <typename T>
+	class field_traits<T,std::enable_if_t<
+		std::is_integral<T>::value &&
+		std::is_signed<T>::value &&
+		((sizeof(T)==2) || (sizeof(T)==4) || (sizeof(T)==8))
+	>> : public non_null_field<T> {
+
+
+		public:
+
+
+			//	Narrower integers may be widened
+			static constexpr bool accepts (Oid oid) noexcept {
+
+				return (oid==21) || ((oid==23) && (sizeof(T)>=4)) || ((oid==20) && (sizeof(T)==8));
+
+			}
+
+
+			static T decode (const char * ptr, std::size_t length) {
+
+				if ((length==2) && (sizeof(T)>=2)) return static_cast<T>(static_cast<std::int16_t>(get_network<std::uint16_t>(ptr)));
+				if ((length==4) && (sizeof(T)>=4)) return static_cast<T>(static_cast<std::int32_t>(get_network<std::uint32_t>(ptr)));
+				if ((length==8) && (sizeof(T)>=8)) return static_cast<T>(static_cast<std::int64_t>(get_network<std::uint64_t>(ptr)));
+
+				throw decode_error("Integer has unexpected length");
+
+			}
+
+
+	};
+
+
+	template <>
+	class field_traits<bool> : public non_null_field<bool> {
+
+
+		public:
+
+
+			static constexpr bool accepts (Oid oid) noexcept {
+
+				return oid==16;
+
+			}
+
+
+			static bool decode (const char * ptr, std::size_t length) {
+
+				if (length!=1) throw decode_error("Boolean has unexpected length");
+
+				return *ptr!=0;
+
+			}
+
+
+	};
+
+
+	template <typename T>
+	class field_traits<T,std::enable_if_t<std::is_floating_point<T>::value && ((sizeof(T)==4) || (sizeof(T)==8))>> : public non_null_field<T> {
+
+
+		public:
+
+
+			//	float4 may be widened
+			static constexpr bool accepts (Oid oid) noexcept {
+
+				return (oid==700) || ((oid==701) && (sizeof(T)==8));
+
+			}
+
+
+			static T decode (const char * ptr, std::size_t length) {
+
+				if (length==4) {
+
+					auto i=get_network<std::uint32_t>(ptr);
+					float f;
+					std::memcpy(&f,&i,sizeof(f));
+
+					return static_cast<T>(f);
+
+				}
+
+				if ((length==8) && (sizeof(T)==8)) {
+
+					auto i=get_network<std::uint64_t>(ptr);
+					double d;
+					std::memcpy(&d,&i,sizeof(d));
+
+					return static_cast<T>(d);
+
+				}
+
+				throw decode_error("Floating point number has unexpected length");
+
+			}
+
+
+	};
+
+
+	/**
+	 *	Determines whether fields of a certain type are sent
+	 *	as text in binary format.
+	 *
+	 *	\param [in] oid
+	 *		The OID of the type.
+	 *
+	 *	\return
+	 *		\em true if fields of type \em oid are text.
+	 */
+	constexpr bool is_text (Oid oid) noexcept {
+
+		//	text, bpchar, varchar, name, json, or unknown
+		return (oid==25) || (oid==1042) || (oid==1043) || (oid==19) || (oid==114) || (oid==705);
+
+	}
+
+
+	template <>
+	class field_traits<std::string> : public non_null_field<std::string> {
+
+
+		public:
+
+
+			static constexpr bool accepts (Oid oid) noexcept {
+
+				return is_text(oid);
+
+			}
+
+
+			static std::string decode (const char * ptr, std::size_t length) {
+
+				return std::string(ptr,length);
+
+			}
+
+
+	};
+
+
+	//	Refers to the memory owned by the result, which libpq
+	//	always null terminates
+	template <>
+	class field_traits<const char *> : public non_null_field<const char *> {
+
+
+		public:
+
+
+			static constexpr bool accepts (Oid oid) noexcept {
+
+				return is_text(oid);
+
+			}
+
+
+			static const char * decode (const char * ptr, std::size_t) noexcept {
+
+				return ptr;
+
+			}
+
+
+	};
+
+
+	template <>
+	class field_traits<bytea> : public non_null_field<bytea> {
+
+
+		public:
+
+
+			static constexpr bool accepts (Oid oid) noexcept {
+
+				return oid==17;
+
+			}
+
+
+			static bytea decode (const char * ptr, std::size_t length) noexcept {
+
+				return bytea(ptr,length);
+
+			}
+
+
+	};
+
+
+	template <>
+	class field_traits<uuid> : public non_null_field<uuid> {
+
+
+		public:
+
+
+			static constexpr bool accepts (Oid oid) noexcept {
+
+				return oid==2950;
+
+			}
+
+
+			static uuid decode (const char * ptr, std::size_t length) {
+
+				if (length!=16) throw decode_error("UUID has unexpected length");
+
+				uuid retr;
+				std::memcpy(retr.bytes.data(),ptr,length);
+
+				return retr;
+
+			}
+
+
+	};
+
+
+	template <>
+	class field_traits<std::chrono::system_clock::time_point> : public non_null_field<std::chrono::system_clock::time_point> {
+
+
+		private:
+
+
+			using time_point=std::chrono::system_clock::time_point;
+
+
+			//	Microseconds from the UNIX epoch to the PostgreSQL
+			//	epoch (2000-01-01 00:00:00 UTC)
+			static constexpr std::int64_t epoch=946684800LL*1000000LL;
+
+
+		public:
+
+
+			//	timestamptz or timestamp (the latter being taken
+			//	to be UTC)
+			static constexpr bool accepts (Oid oid) noexcept {
+
+				return (oid==1184) || (oid==1114);
+
+			}
+
+
+			static time_point decode (const char * ptr, std::size_t length) {
+
+				if (length!=8) throw decode_error("Timestamp has unexpected length");
+
+				auto us=static_cast<std::int64_t>(get_network<std::uint64_t>(ptr));
+				//	Also rejects infinity and -infinity
+				using limits=std::chrono::microseconds;
+				auto max=std::chrono::duration_cast<limits>(time_point::duration::max()).count()-epoch;
+				auto min=std::chrono::duration_cast<limits>(time_point::duration::min()).count()-epoch;
+				if ((us>=max) || (us<=min)) throw decode_error("Timestamp out of range");
+
+				return time_point(std::chrono::duration_cast<time_point::duration>(limits(us+epoch)));
+
+			}
+
+
+	};
+
+
+	template <typename T>
+	class field_traits<optional<T>> {
+
+
+		private:
+
+
+			using traits=field_traits<T>;
+
+
+		public:
+
+
+			static constexpr bool accepts (Oid oid) noexcept {
+
+				return traits::accepts(oid);
+
+			}
+
+
+			static optional<T> null () noexcept {
+
+				return optional<T>{};
+
+			}
+
+
+			static optional<T> decode (const char * ptr, std::size_t length) {
+
+				return optional<T>(traits::decode(ptr,length));
+
+			}
+
+
+	};
+
+
+	/**
+	 *	Decodes a field without checking its bounds, format,
+	 *	or type.
+	 *
+	 *	\tparam T
+	 *		The type to which to decode.
+	 *
+	 *	\param [in] result
+	 *		The result.
+	 *	\param [in] row
+	 *		The row.
+	 *	\param [in] column
+	 *		The column.
+	 *
+	 *	\return
+	 *		The value.
+	 */
+	template <typename T>
+	T decode_field (const PGresult * result, int row, int column) {
+
+		if (PQgetisnull(result,row,column)!=0) return field_traits<T>::null();
+
+		return field_traits<T>::decode(
+			PQgetvalue(result,row,column),
+			static_cast<std::size_t>(PQgetlength(result,row,column))
+		);
+
+	}
+
+
+	/**
+	 *	Owns a libpq result and provides bounds checked,
+	 *	typed access to the fields thereof.
+	 *
+	 *	Fields must be in binary format (i.e. results must be
+	 *	requested with a result format of one).
+	 */
+	class result {
+
+
+		public:
+
+
+			/**
+			 *	The type of a libpq result.
+			 */
+			using native_result_type=PGresult *;
+
+
+		private:
+
+
+			native_result_type handle_;
+
+
+			void check (int row, int column) const;
+			void check (int column, bool (*accepts) (Oid) noexcept) const;
+
+
+		public:
+
+
+			result () = delete;
+			result (const result &) = delete;
+			result & operator = (const result &) = delete;
+
+
+			/**
+			 *	Creates a result which assumes ownership of a
+			 *	libpq result.
+			 *
+			 *	\param [in] handle
+			 *		The libpq result.
+			 */
+			explicit result (native_result_type handle) noexcept;
+			result (result && rhs) noexcept;
+			result & operator = (result && rhs) noexcept;
+
+
+			/**
+			 *	Releases the libpq result.
+			 */
+			~result () noexcept;
+
+
+			/**
+			 *	Retrieves the number of rows.
+			 *
+			 *	\return
+			 *		A count of rows.
+			 */
+			int rows () const noexcept;
+			/**
+			 *	Retrieves the number of columns.
+			 *
+			 *	\return
+			 *		A count of columns.
+			 */
+			int columns () const noexcept;
+
+
+			/**
+			 *	Verifies that a column may be decoded as a certain
+			 *	type.
+			 *
+			 *	\tparam T
+			 *		The type.
+			 *
+			 *	\param [in] column
+			 *		The column.
+			 */
+			template <typename T>
+			void expect (int column) const {
+
+				check(column,&field_traits<T>::accepts);
+
+			}
+
+
+			/**
+			 *	Determines whether a field is NULL.
+			 *
+			 *	\param [in] row
+			 *		The row.
+			 *	\param [in] column
+			 *		The column.
+			 *
+			 *	\return
+			 *		\em true if the field is NULL.
+			 */
+			bool null (int row, int column) const;
+			/**
+			 *	Decodes a field.
+			 *
+			 *	Values which refer to memory (e.g. \ref bytea and
+			 *	\em const \em char \em *) are valid only so long as
+			 *	this object is.
+			 *
+			 *	\tparam T
+			 *		The type to which to decode.  \ref field_traits
+			 *		must be specialized therefor.
+			 *
+			 *	\param [in] row
+			 *		The row.
+			 *	\param [in] column
+			 *		The column.
+			 *
+			 *	\return
+			 *		The value.
+			 */
+			template <typename T>
+			T get (int row, int column) const {
+
+				check(row,column);
+				expect<T>(column);
+
+				return decode_field<T>(handle_,row,column);
+
+			}
+
+
+			/**
+			 *	Retrieves the managed libpq result.
+			 *
+			 *	\return
+			 *		The libpq result.
+			 */
+			native_result_type native_handle () const noexcept;
+			/**
+			 *	Relinquishes ownership of the managed libpq result.
+			 *
+			 *	\return
+			 *		The libpq result.
+			 */
+			native_result_type release () noexcept;
+
+
+	};
+
+
+	/**
+	 *	Decodes every row of a result at once.
+	 *
+	 *	The format and type of each column are verified once
+	 *	and the rows are then decoded into a single allocation.
+	 *	Values which refer to memory (e.g. \ref bytea and
+	 *	\em const \em char \em *) refer to the result rather than
+	 *	being copied and are valid only so long as this object is.
+	 *
+	 *	\tparam Ts
+	 *		The type of each column.
+	 */
+	template <typename... Ts>
+	class typed_result {
+
+
+		public:
+
+
+			/**
+			 *	The type of a decoded row.
+			 */
+			using row_type=std::tuple<Ts...>;
+			/**
+			 *	The type of an iterator over the decoded rows.
+			 */
+			using const_iterator=typename std::vector<row_type>::const_iterator;
+
+
+		private:
+
+
+			result result_;
+			std::vector<row_type> rows_;
+
+
+			template <std::size_t... Is>
+			void expect (std::index_sequence<Is...>) const {
+
+				(result_.expect<Ts>(static_cast<int>(Is)),...);
+
+			}
+
+
+			template <std::size_t... Is>
+			row_type decode (int row, std::index_sequence<Is...>) const {
+
+				return row_type{decode_field<Ts>(result_.native_handle(),row,static_cast<int>(Is))...};
+
+			}
+
+
+		public:
+
+
+			/**
+			 *	Decodes a result.
+			 *
+			 *	If the result reports an error \ref result_error is
+			 *	thrown, if it otherwise does not contain rows
+			 *	\ref decode_error is thrown.
+			 *
+			 *	\param [in] r
+			 *		The result.
+			 */
+			explicit typed_result (result r) : result_(std::move(r)) {
+
+				//	Otherwise an error reported by the server would
+				//	surface as a mismatch of the columns
+				switch (PQresultStatus(result_.native_handle())) {
+
+					case PGRES_TUPLES_OK:
+					case PGRES_SINGLE_TUPLE:
+					#ifdef LIBPQ_HAS_CHUNK_MODE
+					case PGRES_TUPLES_CHUNK:
+					#endif
+						break;
+					case PGRES_BAD_RESPONSE:
+					case PGRES_NONFATAL_ERROR:
+					case PGRES_FATAL_ERROR:
+						throw result_error(result_.native_handle());
+					default:
+						throw decode_error("Result does not contain rows");
+
+				}
+
+				if (result_.columns()!=static_cast<int>(sizeof...(Ts))) throw decode_error("Result has unexpected number of columns");
+
+				expect(std::index_sequence_for<Ts...>{});
+
+				auto n=result_.rows();
+				rows_.reserve(static_cast<typename std::vector<row_type>::size_type>(n));
+				for (int i=0;i<n;++i) rows_.push_back(decode(i,std::index_sequence_for<Ts...>{}));
+
+			}
+			/**
+			 *	Decodes a libpq result, assuming ownership thereof.
+			 *
+			 *	\param [in] handle
+			 *		The libpq result.
+			 */
+			explicit typed_result (result::native_result_type handle) : typed_result(result(handle)) {	}
+
+
+			/**
+			 *	Retrieves the number of rows.
+			 *
+			 *	\return
+			 *		A count of rows.
+			 */
+			std::size_t size () const noexcept {
+
+				return rows_.size();
+
+			}
+			/**
+			 *	Determines whether there are no rows.
+			 *
+			 *	\return
+			 *		\em true if there are no rows.
+			 */
+			bool empty () const noexcept {
+
+				return rows_.empty();
+
+			}
+
+
+			/**
+			 *	Retrieves a row, checking bounds.
+			 *
+			 *	\param [in] i
+			 *		The index of the row.
+			 *
+			 *	\return
+			 *		The row.
+			 */
+			const row_type & at (std::size_t i) const {
+
+				return rows_.at(i);
+
+			}
+			/**
+			 *	Retrieves a row without checking bounds.
+			 *
+			 *	\param [in] i
+			 *		The index of the row.
+			 *
+			 *	\return
+			 *		The row.
+			 */
+			const row_type & operator [] (std::size_t i) const noexcept {
+
+				return rows_[i];
+
+			}
+
+
+			const_iterator begin () const noexcept {
+
+				return rows_.begin();
+
+			}
+			const_iterator end () const noexcept {
+
+				return rows_.end();
+
+			}
+
+
+	};
+
+
+}
@@ -0,0 +1,208 @@
+/**
+ *	\file
+ */
+
+
+#pragma once
+
+
+#include <cstddef>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+namespace asiopq {
+
+
+	/**
+	 *	Tracks the statements which have been prepared
+	 *	on a single connection.
+	 *
+	 *	Statements are identified by their SQL text and are
+	 *	evicted in least recently used order once the cache
+	 *	is full.  The names of evicted statements, and of
+	 *	statements whose preparation was abandoned, are
+	 *	retained until they may be deallocated on the server.
+	 *
+	 *	Not thread safe, each \ref connection uses its own
+	 *	instance on its own strand.
+	 */
+	class statement_cache {
+
+
+		public:
+
+
+			/**
+			 *	The result of using a statement.
+			 */
+			class usage {
+
+
+				public:
+
+
+					/**
+					 *	The name of the prepared statement, or \em nullptr
+					 *	if the statement should be executed without being
+					 *	prepared.
+					 */
+					const std::string * name;
+					/**
+					 *	\em true if the statement must be prepared (as
+					 *	\ref name) before being executed, \em false if
+					 *	it has already been prepared.
+					 */
+					bool prepare;
+
+
+			};
+
+
+		private:
+
+
+			class entry {
+
+
+				public:
+
+
+					std::string sql;
+					std::string name;
+					std::size_t uses;
+					bool prepared;
+
+
+			};
+
+
+			using list_type=std::list<entry>;
+
+
+			std::size_t capacity_;
+			std::size_t threshold_;
+			std::size_t next_;
+			std::size_t prepared_;
+			list_type lru_;
+			std::unordered_map<std::string,list_type::iterator> map_;
+			std::vector<std::string> garbage_;
+
+
+			void evict ();
+
+
+		public:
+
+
+			/**
+			 *	Creates a new statement_cache.
+			 *
+			 *	\param [in] capacity
+			 *		The maximum number of statements to track.
+			 *		Zero disables preparation entirely.
+			 *	\param [in] threshold
+			 *		The number of times a statement must be used
+			 *		before it is prepared.  Zero and one both
+			 *		mean the statement is prepared on first use.
+			 */
+			explicit statement_cache (std::size_t capacity=128, std::size_t threshold=1);
+
+
+			/**
+			 *	Changes the capacity and threshold.
+			 *
+			 *	Statements evicted because the capacity shrank are
+			 *	deallocated the next time a statement is prepared.
+			 *
+			 *	\param [in] capacity
+			 *		See \ref statement_cache::statement_cache.
+			 *	\param [in] threshold
+			 *		See \ref statement_cache::statement_cache.
+			 */
+			void configure (std::size_t capacity, std::size_t threshold);
+
+
+			/**
+			 *	Determines whether using a statement would require
+			 *	that it be prepared, without using it.
+			 *
+			 *	\param [in] sql
+			 *		The SQL text of the statement.
+			 *
+			 *	\return
+			 *		\em true if \ref use would return a \ref usage
+			 *		whose \ref usage::prepare member is \em false.
+			 */
+			bool ready (const std::string & sql) const;
+			/**
+			 *	Records a use of a statement.
+			 *
+			 *	If the statement must be prepared the caller must
+			 *	subsequently invoke either \ref prepared or \ref erase
+			 *	depending on whether preparation succeeded.  If it
+			 *	invokes neither (e.g. because preparation timed out)
+			 *	the next use prepares the statement under a new name
+			 *	and the old name is deallocated.
+			 *
+			 *	\param [in] sql
+			 *		The SQL text of the statement.
+			 *
+			 *	\return
+			 *		A \ref usage object describing how the statement
+			 *		should be executed.  The name therein is valid
+			 *		until this object is next modified.
+			 */
+			usage use (const std::string & sql);
+			/**
+			 *	Records that a statement was successfully prepared.
+			 *
+			 *	\param [in] sql
+			 *		The SQL text of the statement.
+			 */
+			void prepared (const std::string & sql);
+			/**
+			 *	Forgets a statement.
+			 *
+			 *	Used when preparing the statement fails.
+			 *
+			 *	\param [in] sql
+			 *		The SQL text of the statement.
+			 */
+			void erase (const std::string & sql);
+			/**
+			 *	Retrieves and forgets the names of statements which
+			 *	must be deallocated on the server.
+			 *
+			 *	Statements whose preparation was abandoned may never
+			 *	have been prepared, so deallocating them may fail.
+			 *
+			 *	\return
+			 *		The names.
+			 */
+			std::vector<std::string> collect ();
+			/**
+			 *	Forgets all statements without deallocating them.
+			 *
+			 *	Used when the server has forgotten them (i.e. when
+			 *	the connection is reset).
+			 */
+			void clear () noexcept;
+
+
+			/**
+			 *	Retrieves the number of statements which have been
+			 *	prepared and not evicted.
+			 *
+			 *	\return
+			 *		A count of statements.
+			 */
+			std::size_t size () const noexcept;
+
+
+	};
+
+
+}
@@ -0,0 +1,88 @@
+/**
+ *	\file
+ */
+
+
+#pragma once
+
+
+#include "query.hpp"
+
+
+namespace asiopq {
+
+
+	/**
+	 *	A \ref query whose derived class is known at compile
+	 *	time so that sending it and handling each of its results
+	 *	are direct (and therefore inlinable) calls rather than
+	 *	virtual calls.
+	 *
+	 *	The \ref connection still invokes \ref operation::begin,
+	 *	\ref operation::perform, and \ref operation::complete
+	 *	through the \ref operation interface, but each readiness
+	 *	event then costs a single indirect call however many
+	 *	results it delivers.
+	 *
+	 *	\tparam Derived
+	 *		The derived class, which must provide:
+	 *		-	\em void \em do_send(native_handle_type), which
+	 *			has the contract of \ref query::send
+	 *		-	\em void \em do_result(native_result_type), which
+	 *			has the contract of \ref query::result
+	 *		-	\ref operation::complete
+	 */
+	template <typename Derived>
+	class static_query : public query {
+
+
+		private:
+
+
+			Derived & derived () noexcept {
+
+				return static_cast<Derived &>(*this);
+
+			}
+
+
+		public:
+
+
+			using query::query;
+
+
+			virtual void send (native_handle_type handle) override final {
+
+				derived().do_send(handle);
+
+			}
+
+
+			virtual void result (native_result_type result) override final {
+
+				derived().do_result(result);
+
+			}
+
+
+			virtual operation_status begin (native_handle_type handle) override final {
+
+				derived().do_send(handle);
+
+				return sent(handle);
+
+			}
+
+
+			virtual operation_status perform (native_handle_type handle, socket_status status) override final {
+
+				return receive(handle,status,[&] (native_result_type result) {	derived().do_result(result);	});
+
+			}
+
+
+	};
+
+
+}
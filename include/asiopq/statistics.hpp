@@ -0,0 +1,112 @@
+/**
+ *	\file
+ */
+
+
+#pragma once
+
+
+#include "priority.hpp"
+#include <array>
+#include <chrono>
+#include <cstddef>
+
+
+namespace asiopq {
+
+
+	/**
+	 *	Statistics gathered by a \ref connection over its
+	 *	lifetime.
+	 */
+	class statistics {
+
+
+		public:
+
+
+			/**
+			 *	The type used to represent spans of time.
+			 */
+			using duration=std::chrono::steady_clock::duration;
+
+
+			/**
+			 *	The time operations of a single \ref priority spent
+			 *	waiting to begin.
+			 */
+			class queue_wait {
+
+
+				public:
+
+
+					/**
+					 *	The number of operations which have begun.
+					 */
+					std::size_t operations=0;
+					/**
+					 *	The total amount of time those operations spent
+					 *	between being enqueued and beginning.
+					 */
+					duration total=duration::zero();
+					/**
+					 *	The longest amount of time a single such operation
+					 *	spent between being enqueued and beginning.
+					 */
+					duration max=duration::zero();
+
+
+			};
+
+
+			/**
+			 *	The number of times an \ref operation timed out while
+			 *	the server was still executing it and the connection
+			 *	was successfully recovered by cancelling that execution
+			 *	and discarding its results.
+			 */
+			std::size_t recovered=0;
+			/**
+			 *	The number of times such a recovery failed or itself
+			 *	timed out, in which case the connection was reset.
+			 */
+			std::size_t unrecovered=0;
+			/**
+			 *	The total amount of time spent cancelling and draining
+			 *	operations which timed out.
+			 */
+			duration recovery_time=duration::zero();
+			/**
+			 *	The longest amount of time spent cancelling and draining
+			 *	a single operation which timed out.
+			 */
+			duration max_recovery_time=duration::zero();
+			/**
+			 *	The time spent waiting to begin by operations of
+			 *	each \ref priority, indexed thereby.
+			 */
+			std::array<queue_wait,priorities> waits{};
+			/**
+			 *	The number of operations which timed out while
+			 *	waiting to begin and were therefore completed
+			 *	without being sent to the server.
+			 */
+			std::size_t expired=0;
+			/**
+			 *	The greatest number of operations which have been
+			 *	waiting to begin at once.
+			 */
+			std::size_t max_waiting=0;
+			/**
+			 *	The number of operations which were not enqueued
+			 *	because the maximum number of operations were
+			 *	already waiting to begin.
+			 */
+			std::size_t rejected=0;
+
+
+	};
+
+
+}
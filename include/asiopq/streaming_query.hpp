@@ -0,0 +1,116 @@
+/**
+ *	\file
+ */
+
+
+#pragma once
+
+
+#include "query.hpp"
+#include <libpq-fe.h>
+#include <cstddef>
+#include <vector>
+
+
+namespace asiopq {
+
+
+	/**
+	 *	An abstract base class for queries whose rows are
+	 *	retrieved incrementally rather than all at once.
+	 *
+	 *	Rows are retrieved using libpq's single-row mode (or,
+	 *	where available, chunked rows mode) and are handed to
+	 *	\ref consume in batches.  If \ref consume indicates that
+	 *	it cannot accept more rows the query suspends (see
+	 *	\ref operation::operation_status::suspend) and the
+	 *	connection stops reading from the server until
+	 *	\ref connection::resume is called with it.  Accordingly the
+	 *	amount of memory used is bounded regardless of the
+	 *	size of the result.
+	 *
+	 *	When run in pipeline mode rows are still handed to
+	 *	\ref consume in batches but the query cannot suspend.
+	 */
+	class streaming_query : public query {
+
+
+		public:
+
+
+			/**
+			 *	The type of a batch of rows.
+			 *
+			 *	Each result contains at least one row.
+			 */
+			using batch_type=std::vector<native_result_type>;
+
+
+		private:
+
+
+			int rows_;
+			int count_;
+			bool full_;
+			batch_type batch_;
+
+
+			void deliver ();
+
+
+		public:
+
+
+			/**
+			 *	Creates a new streaming_query object.
+			 *
+			 *	\param [in] rows
+			 *		The number of rows in each batch.  The final
+			 *		batch may contain fewer.  Must be positive.
+			 *	\param [in] timeout
+			 *		A \ref operation::timeout_type object giving the
+			 *		amount of time this operation is permitted to
+			 *		take at maximum.  Defaults to no timeout which
+			 *		means this operation may take infinitely long.
+			 */
+			explicit streaming_query (int rows, timeout_type timeout=timeout_type{});
+
+
+			/**
+			 *	Sends the query to the server.
+			 *
+			 *	Single-row (or chunked rows) mode is enabled
+			 *	immediately thereafter.
+			 *
+			 *	\param [in] handle
+			 *		A handle to the current libpq connection.
+			 */
+			virtual void start (native_handle_type handle) = 0;
+			/**
+			 *	Invoked with each batch of rows returned by the
+			 *	server.
+			 *
+			 *	The results in \em batch are cleared once this
+			 *	method returns (or throws), therefore any data which
+			 *	is required thereafter must be copied.
+			 *
+			 *	\param [in] batch
+			 *		The batch of rows.
+			 *
+			 *	\return
+			 *		\em true if more rows may be delivered immediately,
+			 *		\em false if the query should be suspended until
+			 *		\ref connection::resume is called with it.
+			 */
+			virtual bool consume (const batch_type & batch) = 0;
+
+
+			virtual void send (native_handle_type) override final;
+			virtual void result (native_result_type) override;
+			virtual operation_status perform (native_handle_type, socket_status) override;
+
+
+	};
+
+
+}
@@ -0,0 +1,243 @@
+/**
+ *	\file
+ */
+
+
+#pragma once
+
+
+#include "asio.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+
+namespace asiopq {
+
+
+	/**
+	 *	A hierarchical timer wheel shared by everything
+	 *	which uses a single asio::io_service.
+	 *
+	 *	Scheduling and cancelling an entry take constant
+	 *	time and neither allocates nor touches an asio
+	 *	timer unless the entry expires before every other.
+	 *	A single asio::steady_timer wakes the wheel only
+	 *	when an entry may have expired or when entries must
+	 *	be moved between levels.
+	 *
+	 *	Entries never expire early but may expire up to
+	 *	\ref resolution late.
+	 *
+	 *	Thread safe.  Obtain the instance for an
+	 *	asio::io_service using asio::use_service.
+	 */
+	class timer_wheel : public asio::io_service::service {
+
+
+		public:
+
+
+			/**
+			 *	The clock against which expiry is measured.
+			 */
+			using clock_type=std::chrono::steady_clock;
+			/**
+			 *	The type of a point in time on \ref clock_type.
+			 */
+			using time_point=clock_type::time_point;
+			/**
+			 *	The type of a function which is invoked when an
+			 *	entry expires.
+			 *
+			 *	Accepts the value passed to \ref schedule.
+			 */
+			using function_type=std::function<void (std::size_t)>;
+
+
+			/**
+			 *	The granularity with which expiry is measured.
+			 */
+			static constexpr std::chrono::milliseconds resolution{1};
+
+
+			/**
+			 *	Something which may be scheduled to expire.
+			 *
+			 *	Owned by the caller and must be cancelled before it
+			 *	is destroyed if it has ever been scheduled.
+			 */
+			class entry {
+
+
+				friend class timer_wheel;
+
+
+				private:
+
+
+					entry * prev_;
+					entry * next_;
+					//	The head of the slot (or of the list of expired
+					//	entries) which contains this entry so that it may
+					//	be unlinked in constant time, null if this entry
+					//	is neither scheduled nor awaiting invocation
+					entry ** slot_;
+					std::uint64_t expiry_;
+					std::size_t cookie_;
+
+
+				public:
+
+
+					entry (const entry &) = delete;
+					entry (entry &&) = delete;
+					entry & operator = (const entry &) = delete;
+					entry & operator = (entry &&) = delete;
+
+
+					entry () noexcept;
+
+
+					/**
+					 *	Invoked (without any lock held, on a thread running
+					 *	the asio::io_service) when the entry expires.  The
+					 *	function is invoked in place rather than copied:
+					 *	\ref cancel waits for it to return (unless called
+					 *	from within it) so the entry outlives it.  The
+					 *	owner of the entry may be in the midst of
+					 *	destruction, so it should be referred to weakly.
+					 */
+					function_type function;
+
+
+			};
+
+
+			/**
+			 *	Identifies the service.
+			 */
+			static asio::io_service::id id;
+
+
+		private:
+
+
+			static constexpr std::size_t bits=6;
+			static constexpr std::size_t slots=std::size_t(1)<<bits;
+			static constexpr std::size_t levels=4;
+
+
+			//	An invocation of the function of an entry which is
+			//	under way, these live on the stack of the thread
+			//	making the invocation
+			class invocation {
+
+
+				public:
+
+
+					entry * e;
+					std::thread::id thread;
+					invocation * next;
+
+
+			};
+
+
+			mutable std::mutex mutex_;
+			std::condition_variable invoked_;
+			asio::steady_timer timer_;
+			time_point start_;
+			std::uint64_t now_;
+			std::uint64_t wake_;
+			std::size_t generation_;
+			bool armed_;
+			bool shutdown_;
+			std::size_t size_;
+			entry * slots_ [levels][slots];
+			//	Entries which have expired but whose functions have
+			//	not been invoked, in order of expiry
+			entry * fired_;
+			entry * last_;
+			invocation * invocations_;
+
+
+			std::uint64_t tick (time_point) const noexcept;
+			void link (entry &) noexcept;
+			void unlink (entry &) noexcept;
+			void cascade (std::size_t level) noexcept;
+			void advance (std::uint64_t);
+			void arm ();
+			void expire (std::size_t);
+			virtual void shutdown () override;
+
+
+		public:
+
+
+			timer_wheel () = delete;
+			timer_wheel (const timer_wheel &) = delete;
+			timer_wheel (timer_wheel &&) = delete;
+			timer_wheel & operator = (const timer_wheel &) = delete;
+			timer_wheel & operator = (timer_wheel &&) = delete;
+
+
+			/**
+			 *	Creates a timer wheel.
+			 *
+			 *	\param [in] ios
+			 *		The asio::io_service which owns the service.
+			 */
+			explicit timer_wheel (asio::io_service & ios);
+
+
+			/**
+			 *	Schedules an entry to expire.
+			 *
+			 *	If the entry is already scheduled it is first
+			 *	cancelled.
+			 *
+			 *	\param [in] e
+			 *		The entry.
+			 *	\param [in] when
+			 *		The time at which \em e shall expire.  If this
+			 *		is in the past \em e expires as soon as possible.
+			 *	\param [in] cookie
+			 *		A value to pass to \ref entry::function so that
+			 *		expiry of an entry which has since been cancelled
+			 *		or scheduled again may be recognized.
+			 */
+			void schedule (entry & e, time_point when, std::size_t cookie);
+			/**
+			 *	Cancels an entry.
+			 *
+			 *	If the entry has expired but its function has not yet
+			 *	been invoked it will not be.  If its function is being
+			 *	invoked on another thread waits for it to return.
+			 *	Otherwise if the entry is not scheduled nothing
+			 *	happens.
+			 *
+			 *	\param [in] e
+			 *		The entry.
+			 */
+			void cancel (entry & e) noexcept;
+
+
+			/**
+			 *	Retrieves the number of entries which are scheduled.
+			 *
+			 *	\return
+			 *		A count of entries.
+			 */
+			std::size_t size () const noexcept;
+
+
+	};
+
+
+}
@@ -0,0 +1,57 @@
+/**
+ *	\file
+ */
+
+
+#pragma once
+
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+
+namespace asiopq {
+
+
+	/**
+	 *	Refers to binary data sent to or received from the
+	 *	server as a bytea.
+	 *
+	 *	The data is copied when bound by \ref params.  When
+	 *	decoded by \ref field_traits it refers to memory owned
+	 *	by the result.
+	 */
+	class bytea {
+
+
+		public:
+
+
+			const void * data;
+			std::size_t size;
+
+
+			bytea (const void * data, std::size_t size) noexcept : data(data), size(size) {	}
+			bytea (const std::vector<unsigned char> & data) noexcept : data(data.data()), size(data.size()) {	}
+
+
+	};
+
+
+	/**
+	 *	A UUID.
+	 */
+	class uuid {
+
+
+		public:
+
+
+			std::array<unsigned char,16> bytes;
+
+
+	};
+
+
+}
@@ -14,7 +14,7 @@
 namespace asiopq {
 
 
-	void connect::init () {
+	void basic_connect::init () {
 
 		if (!handle_) throw std::bad_alloc{};
 		auto g=make_scope_exit([&] () noexcept {	PQfinish(handle_);	});
@@ -26,7 +26,7 @@ namespace asiopq {
 	}
 
 
-	connect::connect (const char * const * keywords, const char * const * values, int expand_dbname, timeout_type timeout)
+	basic_connect::basic_connect (const char * const * keywords, const char * const * values, int expand_dbname, timeout_type timeout)
 		:	handle_(PQconnectStartParams(keywords,values,expand_dbname)),
 			timeout_(timeout)
 	{
@@ -36,43 +36,43 @@ namespace asiopq {
 	}
 
 
-	connect::connect (const char * conninfo, timeout_type timeout) : handle_(PQconnectStart(conninfo)), timeout_(timeout) {
+	basic_connect::basic_connect (const char * conninfo, timeout_type timeout) : handle_(PQconnectStart(conninfo)), timeout_(timeout) {
 
 		init();
 
 	}
 
 
-	connect::~connect () noexcept {
+	basic_connect::~basic_connect () noexcept {
 
 		if (handle_) PQfinish(handle_);
 
 	}
 
 
-	connection connect::connection (asio::io_service & ios) {
+	connection basic_connect::release (asio::io_service & ios) {
 
 		if (!handle_) throw std::logic_error("Object does not manage a Postgres connection");
 
 		asiopq::connection retr(handle_,ios);
 		handle_=nullptr;
 
-		retr.add(shared_from_this());
-
 		return retr;
 
 	}
 
 
-	void connect::complete (std::exception_ptr ex) {
+	connection basic_connect::connection (asio::io_service & ios) {
 
-		if (ex) set_exception(promise_,std::move(ex));
-		else promise_.set_value();
+		auto retr=release(ios);
+		retr.add(shared_from_this());
+
+		return retr;
 
 	}
 
 
-	connect::operation_status connect::begin (native_handle_type) {
+	basic_connect::operation_status basic_connect::begin (native_handle_type) {
 
 		//	If you have yet to call PQconnectPoll,
 		//	i.e., just after the call to PQconnectStart,
@@ -82,7 +82,7 @@ namespace asiopq {
 	}
 
 
-	connect::operation_status connect::perform (native_handle_type handle, socket_status) {
+	basic_connect::operation_status basic_connect::perform (native_handle_type handle, socket_status) {
 
 		switch (PQconnectPoll(handle)) {
 
@@ -100,13 +100,21 @@ namespace asiopq {
 	}
 
 
-	connect::timeout_type connect::timeout () {
+	basic_connect::timeout_type basic_connect::timeout () {
 
 		return timeout_;
 
 	}
 
 
+	void connect::complete (std::exception_ptr ex) {
+
+		if (ex) set_exception(promise_,std::move(ex));
+		else promise_.set_value();
+
+	}
+
+
 	future<void> connect::get_future () {
 
 		return promise_.get_future();
@@ -1,16 +1,39 @@
 #include <asiopq/asio.hpp>
+#include <asiopq/connect.hpp>
 #include <asiopq/connection.hpp>
+#include <asiopq/errc.hpp>
 #include <asiopq/exception.hpp>
+#include <asiopq/handler_allocator.hpp>
+#include <asiopq/mpsc_queue.hpp>
+#include <asiopq/notifier.hpp>
 #include <asiopq/operation.hpp>
+#include <asiopq/optional.hpp>
+#include <asiopq/pending_queue.hpp>
+#include <asiopq/prepared_query.hpp>
+#include <asiopq/priority.hpp>
+#include <asiopq/query.hpp>
+#include <asiopq/reset.hpp>
 #include <asiopq/scope.hpp>
+#include <asiopq/statement_cache.hpp>
+#include <asiopq/statistics.hpp>
+#include <asiopq/timer_wheel.hpp>
 #include <libpq-fe.h>
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <cstddef>
 #include <cstring>
+#include <deque>
 #include <exception>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
+#include <string>
 #include <system_error>
+#include <thread>
 #include <utility>
+#include <vector>
 
 
 #ifdef _WIN32
@@ -19,6 +42,7 @@
 #else
 #include <errno.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
 #include <unistd.h>
 #endif
 
@@ -26,48 +50,350 @@
 namespace asiopq {
 
 
-	connection::control::control (connection & self, asio::io_service & ios) : stop_(false), self_(&self), timer(ios) {	}
+	namespace {
 
 
-	connection::control::guard_type connection::control::lock () const noexcept {
+		//	Identifies a socket independently of its descriptor,
+		//	which may be reused as soon as libpq closes the socket
+		class socket_identity {
 
-		return guard_type(m_);
 
-	}
+			public:
+
+
+				int family;
+				#ifdef _WIN32
+				//	Only the address is available on Windows, which
+				//	suffices for TCP since each connection has its
+				//	own port
+				struct sockaddr_storage local;
+				#else
+				dev_t dev;
+				ino_t ino;
+				#endif
 
 
-	void connection::control::stop () noexcept {
+		};
 
-		stop_=true;
-		timer.cancel();
 
 	}
 
 
-	connection::control::operator bool () const noexcept {
+	class connection::state : public std::enable_shared_from_this<state> {
 
-		return !stop_;
 
-	}
+		private:
 
 
-	void connection::control::move (connection & self) noexcept {
+			class recovery;
 
-		self_=&self;
 
-	}
+			class in_flight {
 
 
-	connection & connection::control::self () const noexcept {
+				public:
 
-		return *self_;
 
-	}
+					std::shared_ptr<query> op;
+					operation::timeout_type timeout;
+					//	Only meaningful if there's a timeout
+					asio::steady_timer::time_point deadline;
+					std::exception_ptr ex;
 
 
-	static int dup (int socket) {
+			};
 
-		#ifdef _WIN32
+
+			//	Work submitted to the strand from other threads,
+			//	either an operation or a function
+			class command {
+
+
+				public:
+
+
+					operation_type op;
+					std::function<void (state &)> function;
+					priority cls;
+					asio::steady_timer::time_point enqueued;
+					//	Set if op must wait for admission
+					admission_handler admitted;
+
+
+			};
+
+
+			//	Written only on the strand but may be read by
+			//	any thread
+			class queue_wait {
+
+
+				public:
+
+
+					std::atomic<std::size_t> operations;
+					std::atomic<statistics_type::duration::rep> total;
+					std::atomic<statistics_type::duration::rep> max;
+
+
+					queue_wait () noexcept : operations(0), total(0), max(0) {	}
+
+
+			};
+
+
+			//	Operations which have completed, linked through
+			//	their hooks in the order in which they completed,
+			//	each with the outcome of which it is yet to be
+			//	informed
+			class completions {
+
+
+				private:
+
+
+					operation * head_;
+					operation * tail_;
+
+
+				public:
+
+
+					completions (const completions &) = delete;
+					completions & operator = (const completions &) = delete;
+					completions & operator = (completions &&) = delete;
+
+
+					completions () noexcept : head_(nullptr), tail_(nullptr) {	}
+
+
+					completions (completions && rhs) noexcept : head_(rhs.head_), tail_(rhs.tail_) {
+
+						rhs.head_=nullptr;
+						rhs.tail_=nullptr;
+
+					}
+
+
+					//	Operations which were never informed are simply
+					//	released
+					~completions () noexcept {
+
+						while (head_) pop();
+
+					}
+
+
+					bool empty () const noexcept {
+
+						return head_==nullptr;
+
+					}
+
+
+					void push (operation_type op, std::exception_ptr ex, std::error_code ec, std::shared_ptr<const std::string> message) noexcept {
+
+						auto & o=*op;
+						o.ex_=std::move(ex);
+						o.ec_=ec;
+						o.message_=std::move(message);
+						o.self_=std::move(op);
+						o.next_=nullptr;
+						if (tail_) tail_->next_=&o;
+						else head_=&o;
+						tail_=&o;
+
+					}
+
+
+					operation_type pop () noexcept {
+
+						auto & o=*head_;
+						head_=o.next_;
+						if (!head_) tail_=nullptr;
+						o.next_=nullptr;
+
+						return std::move(o.self_);
+
+					}
+
+
+			};
+
+
+			class free_notify {
+
+
+				public:
+
+
+					void operator () (PGnotify * n) const noexcept {
+
+						PQfreemem(n);
+
+					}
+
+
+			};
+
+
+			using notification=std::unique_ptr<PGnotify,free_notify>;
+
+
+			//	Set while a handler is running on the strand
+			static constexpr unsigned running=1;
+			//	Set once the connection object has been destroyed
+			static constexpr unsigned stopped=2;
+
+
+			native_handle_type handle_;
+			asio::io_service & ios_;
+			asio::io_service::strand strand_;
+			//	Handlers of the waits on the socket and the strand
+			//	are allocated from here so that running operations
+			//	does not allocate from the heap
+			handler_arena arena_;
+			std::atomic<unsigned> flags_;
+			mpsc_queue<command> queue_;
+			//	Operations passed to add, linked through their hooks
+			//	so that adding allocates nothing
+			intrusive_mpsc_queue<operation,&operation::next_> ops_;
+			std::atomic<bool> scheduled_;
+			std::atomic<std::size_t> queued_;
+			std::atomic<std::size_t> size_;
+			std::atomic<bool> pipeline_;
+			std::atomic<subscription_type> next_;
+			mutable std::mutex stats_mutex_;
+			statistics_type stats_;
+			timer_wheel & wheel_;
+			timer_wheel::entry timer_;
+			//	Identifies the most recent scheduling of timer_
+			std::size_t timers_;
+			//	Whether timer_ may be on the wheel, so that the
+			//	wheel (and its lock) need not be consulted after
+			//	every operation which had no timeout
+			bool timing_;
+			statement_cache statements_;
+			notifier notifications_;
+			operation_type op_;
+			pending_queue pending_;
+			std::array<queue_wait,priorities> waits_;
+			std::atomic<std::size_t> expired_;
+			//	The number of operations which have been added but
+			//	have not begun, incremented by any thread but only
+			//	decremented on the strand so that operations which
+			//	await admission cannot miss a vacancy
+			std::atomic<std::size_t> waiting_;
+			std::atomic<std::size_t> limit_;
+			std::atomic<std::size_t> max_waiting_;
+			std::atomic<std::size_t> rejected_;
+			std::deque<command> admissions_;
+			//	Operations which completed during the handler which
+			//	is running
+			completions completed_;
+			//	Notifications received during the handler which
+			//	is running
+			std::vector<notification> notified_;
+			asio::executor executor_;
+			//	The last libpq error message with which operations
+			//	failed, shared by all of them
+			std::shared_ptr<const std::string> message_;
+			std::deque<in_flight> sent_;
+			asio::generic::stream_protocol::socket socket_;
+			bool read_;
+			bool write_;
+			bool flushed_;
+			bool suspended_;
+			std::size_t epoch_;
+			optional<asio::steady_timer::time_point> deadline_;
+			bool establishing_;
+			int fd_;
+			socket_identity id_;
+
+
+			bool enter () noexcept;
+			void leave () noexcept;
+			template <typename F>
+			void run (F &&);
+			template <typename F>
+			auto wrap (F &&);
+			void wake ();
+			void submit (command);
+			void drain ();
+			void complete (operation_type, std::exception_ptr);
+			void complete (operation_type, std::error_code);
+			static void invoke (completions);
+			const std::shared_ptr<const std::string> & describe ();
+			void update_socket ();
+			void high_water (std::size_t) noexcept;
+			bool reserve () noexcept;
+			void occupy () noexcept;
+			void enqueue (operation_type, priority, asio::steady_timer::time_point);
+			std::exception_ptr enqueue_reserved (operation_type, priority, asio::steady_timer::time_point) noexcept;
+			void admission (command);
+			void admit ();
+			void vacate ();
+			void waited (const pending_queue::entry &, asio::steady_timer::time_point) noexcept;
+			bool drop (pending_queue::entry &, asio::steady_timer::time_point);
+			void reestablish ();
+			void quiesce ();
+			void next ();
+			void recover (std::chrono::milliseconds);
+			void proceed ();
+			bool begin (optional<asio::steady_timer::time_point>);
+			void dispatch (operation::operation_status);
+			void perform (operation::socket_status);
+			void pipe ();
+			bool flush () noexcept;
+			void receive ();
+			bool pump (bool);
+			void schedule (asio::steady_timer::time_point);
+			void unschedule () noexcept;
+			void expired (std::size_t);
+			void arm ();
+			void expire ();
+			void fail (std::exception_ptr);
+			void fail (std::error_code);
+			void notify ();
+			void deliver (std::vector<notification>) noexcept;
+			void idle ();
+			void update_size () noexcept;
+			void resume (std::size_t);
+			void wakeup ();
+
+
+		public:
+
+
+			state (native_handle_type, asio::io_service &);
+
+
+			void stop () noexcept;
+			void add (operation_type, priority);
+			void add (operation_type, priority, std::error_code &);
+			void admit (operation_type, priority, admission_handler);
+			void resume (operation_type);
+			void pipeline (bool) noexcept;
+			bool pipeline () const noexcept;
+			void cache (std::size_t, std::size_t);
+			void aging (std::chrono::milliseconds);
+			void earliest_deadline_first (bool);
+			void limit (std::size_t);
+			void completion_executor (asio::executor);
+			subscription_type subscribe (std::string, notification_handler);
+			void unsubscribe (subscription_type);
+			statistics_type statistics () const;
+			std::size_t size () const noexcept;
+			std::size_t waiting () const noexcept;
+			asio::io_service & get_io_service () const noexcept;
+			native_handle_type native_handle () const noexcept;
+
+
+	};
+
+
+	#ifdef _WIN32
+	static int dup (int socket) {
 
 		WSAPROTOCOL_INFOW info;
 		if (WSADuplicateSocketW(
@@ -98,344 +424,2097 @@ namespace asiopq {
 
 		return n;
 
-		#else
+	}
+	#endif
+
 
-		auto n=::dup(socket);
-		if (n==-1) throw std::system_error(
+	[[noreturn]]
+	static void socket_error () {
+
+		throw std::system_error(
 			std::error_code(
-				errno,
-				std::system_category()
+				#ifdef _WIN32
+				GetLastError()
+				#else
+				errno
+				#endif
+				,std::system_category()
 			)
 		);
 
-		return n;
+	}
 
-		#endif
 
-	}
+	static socket_identity identify (int socket) {
 
+		socket_identity retr;
+		struct sockaddr_storage local;
+		std::memset(&local,0,sizeof(local));
+		#ifdef _WIN32
+		int size=sizeof(local);
+		if (getsockname(socket,reinterpret_cast<struct sockaddr *>(&local),&size)==SOCKET_ERROR) socket_error();
+		retr.local=local;
+		#else
+		socklen_t size=sizeof(local);
+		if (getsockname(socket,reinterpret_cast<struct sockaddr *>(&local),&size)==-1) socket_error();
+		//	Unnamed Unix domain sockets all have the same address
+		//	so the address cannot tell them apart
+		struct stat st;
+		if (fstat(socket,&st)==-1) socket_error();
+		retr.dev=st.st_dev;
+		retr.ino=st.st_ino;
+		#endif
+		retr.family=local.ss_family;
 
-	void connection::update_socket () {
+		return retr;
 
-		auto s=PQsocket(handle_);
-		if (s==-1) {
+	}
 
-			socket_.close();
-			return;
 
-		}
+	static bool operator == (const socket_identity & a, const socket_identity & b) noexcept {
 
-		struct sockaddr_storage local;
-		std::memset(&local,0,sizeof(local));
 		#ifdef _WIN32
-		constexpr int error=SOCKET_ERROR;
-		int size;
+		return (a.family==b.family) && (std::memcmp(&a.local,&b.local,sizeof(a.local))==0);
 		#else
-		constexpr int error=-1;
-		socklen_t size;
+		return (a.family==b.family) && (a.dev==b.dev) && (a.ino==b.ino);
 		#endif
-		size=sizeof(local);
-		if (getsockname(s,reinterpret_cast<struct sockaddr *>(&local),&size)==error) throw std::system_error(
-			std::error_code(
-				#ifdef _WIN32
-				GetLastError()
-				#else
-				errno
-				#endif
-				,std::system_category()
-			)
-		);
 
-		if (socket_.is_open()) {
+	}
 
-			if (std::memcmp(&local_,&local,sizeof(local))==0) return;
 
-		}
+	//	Stops waiting on a socket which belongs to libpq
+	//	without closing it
+	static void release (asio::generic::stream_protocol::socket & socket) noexcept {
+
+		if (!socket.is_open()) return;
+
+		try {
 
-		auto n=dup(s);
-		auto g=make_scope_exit([&] () noexcept {
 			#ifdef _WIN32
-			closesocket(n);
+			//	A socket cannot be dissociated from an I/O
+			//	completion port so a duplicate is waited on
+			socket.close();
 			#else
-			close(n);
+			socket.release();
 			#endif
-		});
 
-		socket_.close();
-		socket_.assign((local.ss_family==AF_INET) ? asio::ip::tcp::v4() : asio::ip::tcp::v6(),n);
+		} catch (...) {	}
+
+	}
+
+
+	static void assign (asio::generic::stream_protocol::socket & socket, int s, int family) {
+
+		release(socket);
+
+		#ifdef _WIN32
+		auto n=dup(s);
+		auto g=make_scope_exit([&] () noexcept {	closesocket(n);	});
+		#else
+		auto n=s;
+		#endif
+
+		//	libpq may be connected over TCP or a Unix domain
+		//	socket, only readiness is waited for so the protocol
+		//	need only match the address family
+		socket.assign(asio::generic::stream_protocol(family,0),n);
+
+		#ifdef _WIN32
 		g.release();
+		#endif
+
+	}
 
-		std::memcpy(&local_,&local,sizeof(local));
+
+	void connection::state::high_water (std::size_t waiting) noexcept {
+
+		auto max=max_waiting_.load(std::memory_order_relaxed);
+		while ((waiting>max) && !max_waiting_.compare_exchange_weak(max,waiting,std::memory_order_relaxed));
 
 	}
 
 
-	template <typename F>
-	auto connection::wrap (F && functor) noexcept(std::is_nothrow_move_constructible<F>::value) {
+	bool connection::state::reserve () noexcept {
 
-		return [&,control=control_,op=op_,functor=std::forward<F>(functor)] (auto &&... args) mutable {
+		auto max=limit_.load(std::memory_order_relaxed);
+		auto waiting=waiting_.load(std::memory_order_relaxed);
+		do {
 
-			auto l=control->lock();
-			if (!*control) return;
-			auto & self=control->self();
-			if (op!=self.op_) return;
+			if ((max!=0) && (waiting>=max)) return false;
 
-			return std::forward<F>(functor)(self,std::forward<decltype(args)>(args)...);
+		} while (!waiting_.compare_exchange_weak(waiting,waiting+1,std::memory_order_relaxed));
+		high_water(waiting+1);
 
-		};
+		return true;
 
 	}
 
 
-	void connection::next () {
+	void connection::state::occupy () noexcept {
 
-		op_=operation_type{};
-		read_=false;
-		write_=false;
-		control_->timer.cancel();
-		if (socket_.is_open()) socket_.cancel();
+		high_water(waiting_.fetch_add(1,std::memory_order_relaxed)+1);
+
+	}
 
-		if (pending_.empty()) return;
 
-		op_=std::move(pending_.front());
-		pending_.pop_front();
+	void connection::state::enqueue (operation_type op, priority cls, asio::steady_timer::time_point enqueued) {
 
-		begin();
+		if (auto q=dynamic_cast<prepared_query *>(op.get())) q->cache_=&statements_;
+		//	The timeout of an operation runs from the moment
+		//	it was enqueued
+		optional<asio::steady_timer::time_point> deadline;
+		if (auto ms=op->timeout()) deadline=enqueued+std::chrono::duration_cast<asio::steady_timer::duration>(*ms);
+		op->ec_=std::error_code{};
+		pending_.push_back(std::move(op),cls,enqueued,deadline);
 
 	}
 
 
-	void connection::begin () {
+	std::exception_ptr connection::state::enqueue_reserved (operation_type op, priority cls, asio::steady_timer::time_point enqueued) noexcept {
 
-		//	Loop until we need to dispatch an asynchronous
-		//	operation
-		do {
+		//	An operation which could not be enqueued will never
+		//	begin so it must not keep its place
+		try {
 
-			operation::operation_status status;
-			std::exception_ptr ex;
-			try {
+			enqueue(std::move(op),cls,enqueued);
 
-				status=op_->begin(handle_);
+		} catch (...) {
 
-			} catch (...) {
+			waiting_.fetch_sub(1,std::memory_order_relaxed);
+			return std::current_exception();
 
-				ex=std::current_exception();
+		}
 
-			}
+		return std::exception_ptr{};
 
-			update_socket();
+	}
 
-			if (ex || (status==operation::operation_status::done)) {
 
-				op_->complete(std::move(ex));
-				continue;
+	void connection::state::admission (command c) {
 
-			}
+		//	Operations awaiting admission are admitted in order
+		if (!admissions_.empty() || !reserve()) {
 
-			//	Setup timeout if applicable
-			auto ms=op_->timeout();
-			if (ms) {
-
-				auto duration=std::chrono::duration_cast<asio::steady_timer::duration>(*ms);
-				control_->timer.expires_from_now(duration);
-				control_->timer.async_wait(wrap([ms=*ms] (auto & self, const auto &) {
-					
-					self.op_->complete(std::make_exception_ptr(timed_out(ms)));
-					self.next();
-				
-				}));
+			admissions_.push_back(std::move(c));
+			return;
 
-			}
+		}
 
-			//	Dispatch read and/or write
-			dispatch(status);
+		c.admitted(enqueue_reserved(std::move(c.op),c.cls,c.enqueued));
 
-			//	Done
-			break;
+	}
 
-		} while (next(),op_);
 
-	}
+	void connection::state::admit () {
 
+		std::exception_ptr ex;
+		while (!admissions_.empty() && reserve()) {
 
-	void connection::dispatch (operation::operation_status status) {
+			auto c=std::move(admissions_.front());
+			admissions_.pop_front();
+			auto failed=enqueue_reserved(std::move(c.op),c.cls,c.enqueued);
 
-		//	Dispatch read if applicable
-		switch (status) {
+			try {
 
-			default:
-				break;
-			case operation::operation_status::read:
-			case operation::operation_status::read_write:
-				//	There's a read pending, don't need to dispatch
-				//	another
-				if (read_) break;
-				socket_.async_read_some(asio::null_buffers{},wrap([] (auto & self, const auto &, auto) {
+				c.admitted(std::move(failed));
 
-					self.read_=false;
-					self.perform(operation::socket_status::readable);
+			} catch (...) {
 
-				}));
-				read_=true;
+				if (!ex) ex=std::current_exception();
+
+			}
 
 		}
 
-		//	Dispatch write if applicable
-		switch (status) {
+		if (ex) ios_.post([ex=std::move(ex)] () {	std::rethrow_exception(ex);	});
 
-			default:
-				break;
-			case operation::operation_status::write:
-			case operation::operation_status::read_write:
-				//	There's a write pending, don't need to dispatch
-				//	another
-				if (write_) break;
-				socket_.async_write_some(asio::null_buffers{},wrap([] (auto & self, const auto &, auto) {
+	}
 
-					self.write_=false;
-					self.perform(operation::socket_status::writable);
 
-				}));
-				write_=true;
-				break;
+	void connection::state::vacate () {
 
-		}
+		waiting_.fetch_sub(1,std::memory_order_relaxed);
+		admit();
 
 	}
 
 
-	void connection::perform (operation::socket_status status) {
+	void connection::state::waited (const pending_queue::entry & e, asio::steady_timer::time_point now) noexcept {
 
-		operation::operation_status result;
-		std::exception_ptr ex;
-		try {
+		//	Operations pushed onto the front are internal
+		if (!e.cls) return;
 
-			result=op_->perform(handle_,status);
+		//	Only ever written on the strand so there's no need
+		//	for read-modify-write operations
+		auto & w=waits_[static_cast<std::size_t>(*e.cls)];
+		auto wait=std::chrono::duration_cast<statistics_type::duration>(now-e.enqueued).count();
+		w.operations.store(w.operations.load(std::memory_order_relaxed)+1,std::memory_order_relaxed);
+		w.total.store(w.total.load(std::memory_order_relaxed)+wait,std::memory_order_relaxed);
+		if (wait>w.max.load(std::memory_order_relaxed)) w.max.store(wait,std::memory_order_relaxed);
 
-		} catch (...) {
+	}
 
-			ex=std::current_exception();
 
-		}
+	bool connection::state::drop (pending_queue::entry & e, asio::steady_timer::time_point now) {
 
-		update_socket();
+		//	There's no point sending an operation which has
+		//	already run out of time
+		if (!(e.deadline && (*e.deadline<=now))) return false;
 
-		if (ex || (result==operation::operation_status::done)) {
+		expired_.store(expired_.load(std::memory_order_relaxed)+1,std::memory_order_relaxed);
+		complete(std::move(e.op),errc::timed_out);
 
-			op_->complete(std::move(ex));
-			next();
+		return true;
+
+	}
+
+
+	void connection::state::update_socket () {
+
+		auto s=PQsocket(handle_);
+		if (s==-1) {
+
+			release(socket_);
 			return;
 
 		}
 
-		dispatch(result);
+		//	Only establishing (or re-establishing) the connection
+		//	replaces libpq's socket, and a new socket may reuse
+		//	the descriptor of the old, so otherwise it suffices
+		//	to compare descriptors
+		if (socket_.is_open() && (s==fd_) && !establishing_) return;
+
+		auto id=identify(s);
+		if (socket_.is_open() && (s==fd_) && (id==id_)) return;
+
+		assign(socket_,s,id.family);
+
+		fd_=s;
+		id_=id;
 
 	}
 
 
-	connection::connection (native_handle_type handle, asio::io_service & ios)
-		:	handle_(handle),
-			ios_(ios),
-			socket_(ios),
-			control_(std::make_shared<control>(*this,ios)),
-			read_(false),
-			write_(false)
-	{
+	namespace {
 
-		update_socket();
 
-		if (PQsetnonblocking(handle_,1)!=0) throw connection_error(handle_);
+		//	Invoked once a cancel request has finished, whether
+		//	or not it succeeded, possibly on a thread which is
+		//	not running the connection's io_service
+		using cancel_handler=std::function<void ()>;
 
-	}
 
+		#ifdef LIBPQ_HAS_ASYNC_CANCEL
 
-	connection::connection (connection && rhs) noexcept
-		:	handle_(rhs.handle_),
-			ios_(rhs.ios_),
-			socket_(ios_),
-			read_(rhs.read_),
-			write_(rhs.write_)
-	{
 
-		auto l=rhs.control_->lock();
+		//	Drives a cancel request on its own socket
+		//
+		//	Handlers hold a strong reference so the request
+		//	may outlive the connection which issued it
+		class cancel_request : public std::enable_shared_from_this<cancel_request> {
 
-		try {
 
-			op_=std::move(rhs.op_);
-			pending_=std::move(rhs.pending_);
-			socket_=std::move(rhs.socket_);
-			using std::swap;
-			swap(control_,rhs.control_);
+			private:
 
-		} catch (...) {
 
-			//	We cannot allow the lock to be released
-			//	or there could be UB
-			std::terminate();
+				PGcancelConn * handle_;
+				asio::generic::stream_protocol::socket socket_;
+				int fd_;
+				cancel_handler handler_;
 
-		}
 
-		control_->move(*this);
+				void finish () {
 
-	}
+					auto h=std::move(handler_);
+					handler_=nullptr;
+					if (h) h();
 
+				}
 
-	connection::~connection () noexcept {
 
-		if (!control_) return;
+				void wait (PostgresPollingStatusType status) {
 
-		auto l=control_->lock();
+					auto s=PQcancelSocket(handle_);
+					if (s==-1) {
 
-		//	This prevents asynchronous callbacks from proceeding
-		//	which prevents undefined behaviour
-		control_->stop();
+						finish();
+						return;
 
-		//	Inform all operations that they will not complete
-		auto ex=std::make_exception_ptr(aborted{});
-		for (auto && ptr : pending_) ptr->complete(ex);
-		if (op_) op_->complete(std::move(ex));
+					}
+					if (s!=fd_) {
 
-		PQfinish(handle_);
+						assign(socket_,s,identify(s).family);
+						fd_=s;
 
-	}
+					}
 
+					auto self=shared_from_this();
+					auto handler=[self=std::move(self)] (const auto & ec, auto) {
 
-	void connection::add (operation_type op) {
+						if (ec) self->finish();
+						else self->poll();
 
-		auto l=control_->lock();
+					};
+					if (status==PGRES_POLLING_READING) socket_.async_read_some(asio::null_buffers{},std::move(handler));
+					else socket_.async_write_some(asio::null_buffers{},std::move(handler));
 
-		//	If an operation is running this new operation
-		//	becomes pending
-		if (op_) {
+				}
 
-			pending_.push_back(std::move(op));
-			return;
 
-		}
+				void poll () {
 
-		//	No pending operation: This operation is now
-		//	the current operation
-		using std::swap;
-		swap(op_,op);
-		auto g=make_scope_exit([&] () noexcept {	swap(op_,op);	});
+					//	There's nothing to be done if the cancel
+					//	request fails: Draining the results of the
+					//	query will simply take longer
+					auto status=PQcancelPoll(handle_);
+					switch (status) {
 
-		ios_.post(wrap([] (auto & self) {	self.begin();	}));
+						case PGRES_POLLING_READING:
+						case PGRES_POLLING_WRITING:
+							wait(status);
+							break;
+						default:
+							finish();
+							break;
 
-		g.release();
+					}
 
-	}
+				}
 
 
-	asio::io_service & connection::get_io_service () const noexcept {
+			public:
 
-		return ios_;
 
-	}
+				cancel_request (connection::native_handle_type handle, asio::io_service & ios, cancel_handler handler)
+					:	handle_(PQcancelCreate(handle)),
+						socket_(ios),
+						fd_(-1),
+						handler_(std::move(handler))
+				{
 
+					if (!handle_) throw std::bad_alloc{};
 
-	connection::native_handle_type connection::native_handle () const noexcept {
+				}
 
-		return handle_;
+
+				~cancel_request () noexcept {
+
+					release(socket_);
+					PQcancelFinish(handle_);
+
+				}
+
+
+				void start () {
+
+					if (PQcancelStart(handle_)==0) {
+
+						finish();
+						return;
+
+					}
+
+					//	As with PQconnectPoll behave as if PQcancelPoll
+					//	last returned PGRES_POLLING_WRITING
+					wait(PGRES_POLLING_WRITING);
+
+				}
+
+
+		};
+
+
+		static void cancel (connection::native_handle_type handle, asio::io_service & ios, cancel_handler handler) {
+
+			std::make_shared<cancel_request>(handle,ios,std::move(handler))->start();
+
+		}
+
+
+		#else
+
+
+		static void cancel (connection::native_handle_type handle, asio::io_service &, cancel_handler handler) {
+
+			std::shared_ptr<PGcancel> c(PQgetCancel(handle),[] (PGcancel * ptr) noexcept {	if (ptr) PQfreeCancel(ptr);	});
+			if (!c) {
+
+				handler();
+				return;
+
+			}
+
+			//	PQcancel blocks until the server acknowledges the
+			//	request, which would stall every handler waiting to
+			//	run on the io_service, so it is given a thread of
+			//	its own and the handler is invoked there
+			std::thread([c=std::move(c),handler=std::move(handler)] () noexcept {
+
+				//	As with the non-blocking request failure simply
+				//	means draining takes longer
+				char error [256];
+				PQcancel(c.get(),error,sizeof(error));
+				try {
+
+					handler();
+
+				} catch (...) {	}
+
+			}).detach();
+
+		}
+
+
+		#endif
+
+
+		//	Replaces the connection to the server after the results
+		//	of an operation which timed out could not be discarded,
+		//	otherwise the next operation would be sent to a server
+		//	which is still busy
+		class recovery_reset : public basic_reset {
+
+
+			public:
+
+
+				using basic_reset::basic_reset;
+
+
+				virtual void complete (std::exception_ptr) override {	}
+
+
+		};
+
+
+	}
+
+
+	class connection::state::recovery : public operation {
+
+
+		private:
+
+
+			connection::state & state_;
+			timeout_type timeout_;
+			std::chrono::steady_clock::time_point started_;
+			bool flushed_;
+			//	Set off the strand once the cancel request has
+			//	finished
+			std::shared_ptr<std::atomic<bool>> cancelled_;
+			bool recovered_;
+
+
+			//	Until the cancel request has finished it might still
+			//	cancel whatever the server executes next so even
+			//	once drained the connection waits for it
+			operation_status drained () noexcept {
+
+				if (!cancelled_->load(std::memory_order_acquire)) return operation_status::suspend;
+
+				recovered_=true;
+
+				return operation_status::done;
+
+			}
+
+
+			void flush (native_handle_type handle) {
+
+				if (flushed_) return;
+
+				switch (PQflush(handle)) {
+
+					default:
+						throw connection_error(handle);
+					case 0:
+						flushed_=true;
+						break;
+					case 1:
+						break;
+
+				}
+
+			}
+
+
+			operation_status drain (native_handle_type handle) {
+
+				flush(handle);
+
+				while (PQisBusy(handle)==0) {
+
+					auto res=PQgetResult(handle);
+					if (!res) return drained();
+
+					auto status=PQresultStatus(res);
+					PQclear(res);
+
+					//	PQgetResult keeps returning PGRES_COPY_IN until
+					//	the copy is ended
+					if (status==PGRES_COPY_IN) switch (PQputCopyEnd(handle,"Operation timed out")) {
+
+						case 1:
+							flushed_=false;
+							flush(handle);
+							break;
+						case 0:
+							return operation_status::read_write;
+						default:
+							throw connection_error(handle);
+
+					}
+
+					//	Likewise PGRES_COPY_OUT is returned until all
+					//	the data has been read
+					if (status==PGRES_COPY_OUT) for (;;) {
+
+						char * ptr;
+						auto n=PQgetCopyData(handle,&ptr,1);
+						if (n==0) return flushed_ ? operation_status::read : operation_status::read_write;
+						if (n==-1) break;
+						if (n==-2) throw connection_error(handle);
+
+						PQfreemem(ptr);
+
+					}
+
+				}
+
+				return flushed_ ? operation_status::read : operation_status::read_write;
+
+			}
+
+
+		public:
+
+
+			recovery (connection::state & state, std::chrono::milliseconds timeout)
+				:	state_(state),
+					timeout_(timeout),
+					flushed_(false),
+					cancelled_(std::make_shared<std::atomic<bool>>(false)),
+					recovered_(false)
+			{	}
+
+
+			//	Whether the results were discarded and the cancel
+			//	request has finished
+			bool recovered () const noexcept {
+
+				return recovered_;
+
+			}
+
+
+			virtual void complete (std::exception_ptr ex) override {
+
+				std::lock_guard<std::mutex> l(state_.stats_mutex_);
+				auto & stats=state_.stats_;
+				if (ex) {
+
+					++stats.unrecovered;
+					return;
+
+				}
+
+				auto elapsed=std::chrono::steady_clock::now()-started_;
+				++stats.recovered;
+				stats.recovery_time+=elapsed;
+				if (elapsed>stats.max_recovery_time) stats.max_recovery_time=elapsed;
+
+			}
+
+
+			virtual operation_status begin (native_handle_type handle) override {
+
+				started_=std::chrono::steady_clock::now();
+
+				cancel(handle,state_.ios_,[self=std::weak_ptr<state>(state_.shared_from_this()),epoch=state_.epoch_,cancelled=cancelled_] () {
+
+					cancelled->store(true,std::memory_order_release);
+					if (auto ptr=self.lock()) ptr->resume(epoch);
+
+				});
+
+				return drain(handle);
+
+			}
+
+
+			virtual operation_status perform (native_handle_type handle, socket_status status) override {
+
+				if ((status==socket_status::readable) && (PQconsumeInput(handle)==0)) throw connection_error(handle);
+
+				return drain(handle);
+
+			}
+
+
+			virtual timeout_type timeout () override {
+
+				return timeout_;
+
+			}
+
+
+	};
+
+
+	#ifdef LIBPQ_HAS_PIPELINING
+
+
+	static void enter_pipeline (connection::native_handle_type handle) {
+
+		if (PQpipelineStatus(handle)!=PQ_PIPELINE_OFF) return;
+
+		if (PQenterPipelineMode(handle)==0) throw connection_error(handle);
+
+	}
+
+
+	static void exit_pipeline (connection::native_handle_type handle) noexcept {
+
+		//	If this fails the connection still has work
+		//	outstanding (i.e. it is broken) in which case
+		//	the next operation will fail and report that
+		if (PQpipelineStatus(handle)!=PQ_PIPELINE_OFF) PQexitPipelineMode(handle);
+
+	}
+
+
+	static void sync_pipeline (connection::native_handle_type handle) {
+
+		if (PQpipelineSync(handle)==0) throw connection_error(handle);
+
+	}
+
+
+	static bool is_sync (const PGresult * result) noexcept {
+
+		return PQresultStatus(result)==PGRES_PIPELINE_SYNC;
+
+	}
+
+
+	#else
+
+
+	[[noreturn]]
+	static void pipeline_unsupported () {
+
+		throw std::logic_error("libpq does not support pipeline mode");
+
+	}
+
+
+	static void enter_pipeline (connection::native_handle_type) {
+
+		pipeline_unsupported();
+
+	}
+
+
+	static void exit_pipeline (connection::native_handle_type) noexcept {	}
+
+
+	static void sync_pipeline (connection::native_handle_type) {
+
+		pipeline_unsupported();
+
+	}
+
+
+	static bool is_sync (const PGresult *) noexcept {
+
+		return false;
+
+	}
+
+
+	#endif
+
+
+	namespace {
+
+
+		//	Executes LISTEN or UNLISTEN for a collection of
+		//	channels on behalf of the connection's subscribers
+		class listen_query : public query {
+
+
+			private:
+
+
+				std::vector<std::string> channels_;
+				const char * command_;
+
+
+			public:
+
+
+				listen_query (std::vector<std::string> channels, const char * command) : channels_(std::move(channels)), command_(command) {	}
+
+
+				virtual void send (native_handle_type handle) override {
+
+					std::string sql;
+					for (auto && channel : channels_) {
+
+						auto id=PQescapeIdentifier(handle,channel.data(),channel.size());
+						if (!id) throw connection_error(handle);
+						auto g=make_scope_exit([&] () noexcept {	PQfreemem(id);	});
+
+						sql+=command_;
+						sql+=' ';
+						sql+=id;
+						sql+=';';
+
+					}
+
+					//	Several statements may only be sent at once
+					//	using the simple query protocol
+					if (PQsendQuery(handle,sql.c_str())==0) throw connection_error(handle);
+
+				}
+
+
+				virtual void result (native_result_type result) override {
+
+					//	Throwing would leave the results of the
+					//	remaining statements for the next operation
+					PQclear(result);
+
+				}
+
+
+				virtual bool pipelinable () const noexcept override {
+
+					return false;
+
+				}
+
+
+				virtual void complete (std::exception_ptr) override {	}
+
+
+		};
+
+
+	}
+
+
+	static bool pipelinable (const connection::operation_type & op) noexcept {
+
+		auto q=dynamic_cast<const query *>(op.get());
+
+		return q && q->pipelinable();
+
+	}
+
+
+	bool connection::state::enter () noexcept {
+
+		//	Only one handler runs on the strand at a time so
+		//	the only contention is with the destructor of the
+		//	connection object
+		if ((flags_.fetch_or(running,std::memory_order_acq_rel)&stopped)==0) return true;
+
+		leave();
+
+		return false;
+
+	}
+
+
+	void connection::state::leave () noexcept {
+
+		flags_.fetch_and(~running,std::memory_order_release);
+
+	}
+
+
+	template <typename F>
+	void connection::state::run (F && functor) {
+
+		if (!enter()) return;
+
+		std::exception_ptr ex;
+		try {
+
+			std::forward<F>(functor)();
+			update_size();
+
+		} catch (...) {
+
+			ex=std::current_exception();
+
+		}
+
+		//	Operations are informed of their completion only
+		//	once the connection has finished with them and the
+		//	next operation has begun, and only once the
+		//	destructor no longer waits on this handler so that
+		//	slow completions delay neither
+		completions completed(std::move(completed_));
+		auto notified=std::move(notified_);
+		notified_.clear();
+		auto executor=executor_;
+		leave();
+
+		//	Likewise subscribers are only notified once the
+		//	destructor no longer waits on this handler so that
+		//	they may destroy the connection
+		if (!notified.empty()) deliver(std::move(notified));
+
+		if (!completed.empty()) {
+
+			if (executor) asio::post(executor,[self=shared_from_this(),completed=std::move(completed)] () mutable {
+
+				invoke(std::move(completed));
+
+			});
+			else invoke(std::move(completed));
+
+		}
+
+		if (ex) std::rethrow_exception(ex);
+
+	}
+
+
+	template <typename F>
+	auto connection::state::wrap (F && functor) {
+
+		//	Equivalent to asio::io_service::strand::wrap except
+		//	that both the wait and the dispatch onto the strand
+		//	allocate from the arena
+		return bind_arena(arena_,[self=shared_from_this(),epoch=epoch_,functor=std::forward<F>(functor)] (auto... args) mutable {
+
+			auto & state=*self;
+			state.strand_.dispatch(bind_arena(state.arena_,[self=std::move(self),epoch,functor=std::move(functor),args...] () mutable {
+
+				self->run([&] () {
+
+					//	The connection has moved on since this
+					//	handler was dispatched
+					if (epoch!=self->epoch_) return;
+
+					functor(*self,args...);
+
+				});
+
+			}));
+
+		});
+
+	}
+
+
+	void connection::state::complete (operation_type op, std::exception_ptr ex) {
+
+		//	The operation may have failed without throwing
+		if (!ex && op->ec_) {
+
+			auto ec=op->ec_;
+			complete(std::move(op),ec);
+			return;
+
+		}
+
+		completed_.push(std::move(op),std::move(ex),std::error_code{},nullptr);
+
+	}
+
+
+	void connection::state::complete (operation_type op, std::error_code ec) {
+
+		std::shared_ptr<const std::string> message;
+		if (ec==errc::connection_failed) message=describe();
+		completed_.push(std::move(op),std::exception_ptr{},ec,std::move(message));
+
+	}
+
+
+	void connection::state::invoke (completions completed) {
+
+		std::exception_ptr ex;
+		while (!completed.empty()) try {
+
+			//	Unlinked before it is informed so that it may be
+			//	added again from within complete
+			auto op=completed.pop();
+			auto message=std::move(op->message_);
+			if (op->ec_) op->complete(op->ec_,message ? *message : std::string());
+			else op->complete(std::move(op->ex_));
+
+		} catch (...) {
+
+			if (!ex) ex=std::current_exception();
+
+		}
+
+		if (ex) std::rethrow_exception(ex);
+
+	}
+
+
+	const std::shared_ptr<const std::string> & connection::state::describe () {
+
+		//	Every operation fails with the same message when
+		//	the connection is lost so it is copied only when
+		//	it changes
+		auto msg=PQerrorMessage(handle_);
+		auto len=std::strlen(msg);
+		while ((len!=0) && ((msg[len-1]=='\n') || (msg[len-1]=='\r'))) --len;
+		if (!(message_ && (message_->size()==len) && (message_->compare(0,len,msg,len)==0))) message_=std::make_shared<const std::string>(msg,len);
+
+		return message_;
+
+	}
+
+
+	void connection::state::submit (command c) {
+
+		queue_.push(std::move(c));
+		wake();
+
+	}
+
+
+	void connection::state::wake () {
+
+		//	Only one drain need be pending at a time, it takes
+		//	everything which was submitted before it runs
+		if (scheduled_.exchange(true,std::memory_order_acq_rel)) return;
+
+		strand_.post(bind_arena(arena_,[self=shared_from_this()] () {
+
+			self->run([&] () {	self->drain();	});
+
+		}));
+
+	}
+
+
+	void connection::state::drain () {
+
+		//	Anything submitted after this point schedules
+		//	another drain
+		scheduled_.store(false,std::memory_order_release);
+
+		std::exception_ptr ex;
+		queue_.consume([&] (command c) {
+
+			try {
+
+				if (c.admitted) admission(std::move(c));
+				else c.function(*this);
+
+			} catch (...) {
+
+				if (!ex) ex=std::current_exception();
+
+			}
+
+		});
+		bool released=false;
+		auto ops=ops_.consume([&] (operation & o) {
+
+			auto op=std::move(o.self_);
+			//	Otherwise the operation would never learn that it
+			//	was not enqueued
+			if (auto e=enqueue_reserved(op,o.cls_,o.enqueued_)) {
+
+				released=true;
+				complete(std::move(op),std::move(e));
+
+			}
+
+		});
+		queued_.fetch_sub(ops,std::memory_order_relaxed);
+		if (released) admit();
+
+		//	If an operation is running the new operations
+		//	simply become pending
+		if (!op_) proceed();
+
+		if (ex) ios_.post([ex=std::move(ex)] () {	std::rethrow_exception(ex);	});
+
+	}
+
+
+	void connection::state::reestablish () {
+
+		auto r=dynamic_cast<recovery *>(op_.get());
+		if (!(r && !r->recovered())) return;
+
+		pending_.push_front(std::make_shared<recovery_reset>(r->timeout()));
+
+	}
+
+
+	void connection::state::quiesce () {
+
+		reestablish();
+
+		//	Resetting the connection discards every prepared
+		//	statement and every LISTEN on the server whether it
+		//	succeeds or not
+		if (dynamic_cast<basic_reset *>(op_.get())) {
+
+			statements_.clear();
+			if (!notifications_.empty()) pending_.push_front(std::make_shared<listen_query>(notifications_.channels(),"LISTEN"));
+
+		}
+
+		op_=operation_type{};
+		++epoch_;
+		establishing_=false;
+		read_=false;
+		write_=false;
+		suspended_=false;
+		deadline_=nullopt;
+		unschedule();
+		if (socket_.is_open()) socket_.cancel();
+
+	}
+
+
+	void connection::state::next () {
+
+		quiesce();
+
+		while (!pending_.empty()) {
+
+			if (pipeline_) {
+
+				if (pump(false)) return;
+				if (pending_.empty()) break;
+				//	A query at the head of the queue which failed
+				//	to be sent may be followed by others
+				if (pipelinable(pending_.front())) continue;
+
+			}
+
+			auto now=asio::steady_timer::clock_type::now();
+			auto e=pending_.pop_front(now);
+			if (e.cls) vacate();
+			if (drop(e,now)) continue;
+			waited(e,now);
+
+			//	Operations other than queries run exclusively
+			exit_pipeline(handle_);
+
+			op_=std::move(e.op);
+
+			if (begin(e.deadline)) return;
+			reestablish();
+
+		}
+
+		op_=operation_type{};
+		exit_pipeline(handle_);
+		idle();
+
+	}
+
+
+	void connection::state::recover (std::chrono::milliseconds timeout) {
+
+		//	If the server is still executing the operation which
+		//	timed out it must be cancelled and its results discarded
+		//	otherwise they would be received by the next operation
+		if (
+			!dynamic_cast<recovery *>(op_.get()) &&
+			(PQtransactionStatus(handle_)==PQTRANS_ACTIVE)
+		) pending_.push_front(std::make_shared<recovery>(*this,timeout));
+
+		next();
+
+	}
+
+
+	void connection::state::proceed () {
+
+		if (!pump(false)) next();
+
+	}
+
+
+	bool connection::state::begin (optional<asio::steady_timer::time_point> deadline) {
+
+		establishing_=dynamic_cast<basic_connect *>(op_.get()) || dynamic_cast<basic_reset *>(op_.get());
+
+		operation::operation_status status;
+		std::exception_ptr ex;
+		try {
+
+			status=op_->begin(handle_);
+
+		} catch (...) {
+
+			ex=std::current_exception();
+
+		}
+
+		notify();
+		update_socket();
+
+		if (ex || (status==operation::operation_status::done)) {
+
+			complete(op_,std::move(ex));
+			return false;
+
+		}
+
+		//	Setup timeout if applicable
+		auto ms=op_->timeout();
+		//	Operations which waited to begin have only what
+		//	remains of their timeout
+		if (ms) schedule(deadline ? *deadline : (asio::steady_timer::clock_type::now()+std::chrono::duration_cast<asio::steady_timer::duration>(*ms)));
+
+		//	Dispatch read and/or write
+		dispatch(status);
+
+		return true;
+
+	}
+
+
+	void connection::state::dispatch (operation::operation_status status) {
+
+		//	Nothing is dispatched until the operation is
+		//	explicitly resumed
+		if (status==operation::operation_status::suspend) {
+
+			suspended_=true;
+			return;
+
+		}
+
+		//	Dispatch read if applicable
+		switch (status) {
+
+			default:
+				break;
+			case operation::operation_status::read:
+			case operation::operation_status::read_write:
+				//	There's a read pending, don't need to dispatch
+				//	another
+				if (read_) break;
+				socket_.async_read_some(asio::null_buffers{},wrap([] (auto & self, const auto &, auto) {
+
+					self.read_=false;
+					self.perform(operation::socket_status::readable);
+
+				}));
+				read_=true;
+
+		}
+
+		//	Dispatch write if applicable
+		switch (status) {
+
+			default:
+				break;
+			case operation::operation_status::write:
+			case operation::operation_status::read_write:
+				//	There's a write pending, don't need to dispatch
+				//	another
+				if (write_) break;
+				socket_.async_write_some(asio::null_buffers{},wrap([] (auto & self, const auto &, auto) {
+
+					self.write_=false;
+					self.perform(operation::socket_status::writable);
+
+				}));
+				write_=true;
+				break;
+
+		}
+
+	}
+
+
+	void connection::state::perform (operation::socket_status status) {
+
+		//	No exclusive operation: The socket is being
+		//	driven by the pipeline
+		if (!op_) {
+
+			if (!pump(status==operation::socket_status::readable)) next();
+			return;
+
+		}
+
+		operation::operation_status result;
+		std::exception_ptr ex;
+		try {
+
+			result=op_->perform(handle_,status);
+
+		} catch (...) {
+
+			ex=std::current_exception();
+
+		}
+
+		notify();
+		update_socket();
+
+		if (ex || (result==operation::operation_status::done)) {
+
+			complete(op_,std::move(ex));
+			next();
+			return;
+
+		}
+
+		dispatch(result);
+
+	}
+
+
+	void connection::state::pipe () {
+
+		if (!pipeline_) return;
+
+		auto now=asio::steady_timer::clock_type::now();
+		while (!pending_.empty()) {
+
+			if (!pipelinable(pending_.front(now))) break;
+			auto e=pending_.pop_front(now);
+			if (e.cls) vacate();
+			if (drop(e,now)) continue;
+			waited(e,now);
+			auto q=std::static_pointer_cast<query>(e.op);
+
+			std::exception_ptr ex;
+			try {
+
+				enter_pipeline(handle_);
+				q->send(handle_);
+
+			} catch (...) {
+
+				ex=std::current_exception();
+
+			}
+
+			if (ex) {
+
+				complete(std::move(q),std::move(ex));
+				continue;
+
+			}
+
+			//	The query has been queued by libpq so it must
+			//	be tracked even if the synchronization point
+			//	cannot be
+			auto timeout=q->timeout();
+			auto deadline=e.deadline;
+			if (timeout && !deadline) deadline=now+std::chrono::duration_cast<asio::steady_timer::duration>(*timeout);
+			sent_.push_back(in_flight{std::move(q),timeout,deadline ? *deadline : now,std::exception_ptr{}});
+			flushed_=false;
+
+			//	Each query gets its own synchronization point
+			//	so that an error in one query does not cause
+			//	subsequent queries to be aborted
+			sync_pipeline(handle_);
+
+		}
+
+	}
+
+
+	bool connection::state::flush () noexcept {
+
+		if (flushed_) return true;
+
+		switch (PQflush(handle_)) {
+
+			default:
+				return false;
+			case 0:
+				flushed_=true;
+				break;
+			case 1:
+				break;
+
+		}
+
+		return true;
+
+	}
+
+
+	void connection::state::receive () {
+
+		//	Two consecutive null results mean libpq has
+		//	nothing more for us until more input arrives
+		bool null=false;
+		while (!sent_.empty() && (PQisBusy(handle_)==0)) {
+
+			auto res=PQgetResult(handle_);
+			if (!res) {
+
+				if (null) break;
+				null=true;
+				continue;
+
+			}
+			null=false;
+
+			auto & f=sent_.front();
+
+			//	The synchronization point which follows each
+			//	query marks the end of that query's results
+			if (is_sync(res)) {
+
+				PQclear(res);
+				auto op=std::move(f.op);
+				auto ex=std::move(f.ex);
+				sent_.pop_front();
+				if (op) complete(std::move(op),std::move(ex));
+				continue;
+
+			}
+
+			//	The query timed out or has already failed:
+			//	Discard its remaining results
+			if (!f.op || f.ex) {
+
+				PQclear(res);
+				continue;
+
+			}
+
+			try {
+
+				f.op->result(res);
+
+			} catch (...) {
+
+				f.ex=std::current_exception();
+
+			}
+
+		}
+
+	}
+
+
+	bool connection::state::pump (bool readable) {
+
+		try {
+
+			pipe();
+			//	Losing the connection fails every query in flight
+			//	so this must not throw
+			if ((readable && (PQconsumeInput(handle_)==0)) || !flush()) fail(errc::connection_failed);
+			else receive();
+
+		} catch (...) {
+
+			fail(std::current_exception());
+
+		}
+
+		notify();
+		update_socket();
+
+		if (sent_.empty()) return false;
+
+		arm();
+		//	libpq must keep reading while it has output
+		//	it cannot flush otherwise the server may block
+		//	trying to send results
+		dispatch(flushed_ ? operation::operation_status::read : operation::operation_status::read_write);
+
+		return true;
+
+	}
+
+
+	void connection::state::schedule (asio::steady_timer::time_point when) {
+
+		//	Expiry is delivered to the strand, the entry refers
+		//	to this object weakly since this object owns it
+		if (!timer_.function) timer_.function=[self=std::weak_ptr<state>(shared_from_this())] (std::size_t cookie) {
+
+			auto ptr=self.lock();
+			if (!ptr) return;
+			auto & state=*ptr;
+			state.strand_.post(bind_arena(state.arena_,[self=std::move(ptr),cookie] () {
+
+				self->run([&] () {	self->expired(cookie);	});
+
+			}));
+
+		};
+
+		wheel_.schedule(timer_,when,++timers_);
+		timing_=true;
+
+	}
+
+
+	void connection::state::unschedule () noexcept {
+
+		//	An expiry which has already left the wheel is
+		//	recognized as stale by its cookie
+		if (timing_) {
+
+			wheel_.cancel(timer_);
+			timing_=false;
+
+		}
+		++timers_;
+
+	}
+
+
+	void connection::state::expired (std::size_t cookie) {
+
+		//	Superseded by a later scheduling or cancelled
+		if (cookie!=timers_) return;
+		timing_=false;
+
+		if (deadline_) {
+
+			deadline_=nullopt;
+			expire();
+			return;
+
+		}
+
+		if (!op_) return;
+
+		auto ms=*op_->timeout();
+		complete(op_,errc::timed_out);
+		recover(ms);
+
+	}
+
+
+	void connection::state::arm () {
+
+		optional<asio::steady_timer::time_point> earliest;
+		for (auto && f : sent_) {
+
+			if (!(f.op && f.timeout)) continue;
+
+			auto when=f.deadline;
+			if (!earliest || (when<*earliest)) earliest=when;
+
+		}
+
+		if (!earliest || (deadline_==earliest)) return;
+
+		deadline_=earliest;
+		schedule(*earliest);
+
+	}
+
+
+	void connection::state::expire () {
+
+		auto now=asio::steady_timer::clock_type::now();
+		for (auto && f : sent_) {
+
+			if (!(f.op && f.timeout)) continue;
+
+			if (f.deadline>now) continue;
+
+			//	The slot remains so that the results, once they
+			//	arrive, may be discarded
+			complete(std::move(f.op),errc::timed_out);
+
+		}
+
+		arm();
+
+	}
+
+
+	void connection::state::fail (std::exception_ptr ex) {
+
+		auto sent=std::move(sent_);
+		sent_.clear();
+		flushed_=true;
+
+		for (auto && f : sent) if (f.op) complete(std::move(f.op),f.ex ? std::move(f.ex) : ex);
+
+	}
+
+
+	void connection::state::fail (std::error_code ec) {
+
+		auto sent=std::move(sent_);
+		sent_.clear();
+		flushed_=true;
+
+		for (auto && f : sent) {
+
+			if (!f.op) continue;
+
+			if (f.ex) complete(std::move(f.op),std::move(f.ex));
+			else complete(std::move(f.op),ec);
+
+		}
+
+	}
+
+
+	void connection::state::notify () {
+
+		//	Input consumed on behalf of any operation may
+		//	contain notifications
+		for (;;) {
+
+			notification n(PQnotifies(handle_));
+			if (!n) return;
+
+			if (notifications_.listening(n->relname)) notified_.push_back(std::move(n));
+
+		}
+
+	}
+
+
+	void connection::state::deliver (std::vector<notification> notified) noexcept {
+
+		for (auto && n : notified) {
+
+			//	A subscriber destroyed the connection
+			if ((flags_.load(std::memory_order_acquire)&stopped)!=0) return;
+
+			try {
+
+				notifications_.dispatch(*n);
+
+			} catch (...) {
+
+				//	As if the handler had been dispatched through
+				//	the asio::io_service
+				try {
+
+					ios_.post([ex=std::current_exception()] () {	std::rethrow_exception(ex);	});
+
+				} catch (...) {	}
+
+			}
+
+		}
+
+	}
+
+
+	void connection::state::idle () {
+
+		//	While nothing else is reading the socket a read
+		//	is kept pending so that notifications are not
+		//	delayed until the next operation
+		if (
+			op_ ||
+			!sent_.empty() ||
+			notifications_.empty() ||
+			!socket_.is_open() ||
+			(PQstatus(handle_)!=CONNECTION_OK)
+		) return;
+
+		dispatch(operation::operation_status::read);
+
+	}
+
+
+	void connection::state::update_size () noexcept {
+
+		size_.store(pending_.size()+sent_.size()+(op_ ? 1 : 0),std::memory_order_relaxed);
+
+	}
+
+
+	connection::state::state (native_handle_type handle, asio::io_service & ios)
+		:	handle_(handle),
+			ios_(ios),
+			strand_(ios),
+			flags_(0),
+			scheduled_(false),
+			queued_(0),
+			size_(0),
+			pipeline_(false),
+			next_(0),
+			wheel_(asio::use_service<timer_wheel>(ios)),
+			timers_(0),
+			timing_(false),
+			pending_(std::chrono::milliseconds(100)),
+			expired_(0),
+			waiting_(0),
+			limit_(0),
+			max_waiting_(0),
+			rejected_(0),
+			socket_(ios),
+			read_(false),
+			write_(false),
+			flushed_(true),
+			suspended_(false),
+			epoch_(0),
+			establishing_(false),
+			fd_(-1),
+			id_()
+	{
+
+		update_socket();
+
+		if (PQsetnonblocking(handle_,1)!=0) throw connection_error(handle_);
+
+	}
+
+
+	void connection::state::stop () noexcept {
+
+		//	Handlers which begin after this point return
+		//	immediately, wait for any which is already running
+		flags_.fetch_or(stopped,std::memory_order_acq_rel);
+		while ((flags_.load(std::memory_order_acquire)&running)!=0) std::this_thread::yield();
+
+		//	Inform all operations that they will not complete,
+		//	only admission handlers need an exception
+		std::error_code ec(errc::aborted);
+		const std::string none;
+		std::exception_ptr ex;
+		auto abort=[&] (const admission_handler & h) {
+
+			if (!ex) ex=std::make_exception_ptr(aborted{});
+			h(ex);
+
+		};
+		try {
+
+			queue_.consume([&] (command c) {	if (c.admitted) abort(c.admitted);	});
+
+		} catch (...) {	}
+		while (!ops_.empty()) try {
+
+			ops_.consume([&] (operation & o) {
+
+				auto op=std::move(o.self_);
+				op->complete(ec,none);
+
+			});
+
+		} catch (...) {	}
+		for (auto && c : admissions_) try {
+
+			abort(c.admitted);
+
+		} catch (...) {	}
+		pending_.for_each([&] (const operation_type & ptr) {	ptr->complete(ec,none);	});
+		for (auto && f : sent_) if (f.op) f.op->complete(ec,none);
+		if (op_) op_->complete(ec,none);
+
+		//	Handlers still pending refer to this object, they
+		//	must not keep the operations alive
+		pending_.clear();
+		admissions_.clear();
+		sent_.clear();
+		op_=operation_type{};
+
+		//	Even once expiry has been delivered the wheel may
+		//	still be invoking timer_'s function, which must
+		//	return before timer_ is destroyed
+		wheel_.cancel(timer_);
+		release(socket_);
+
+		PQfinish(handle_);
+
+	}
+
+
+	void connection::state::add (operation_type op, priority cls) {
+
+		std::error_code ec;
+		add(std::move(op),cls,ec);
+		if (ec) throw queue_full(limit_.load(std::memory_order_relaxed));
+
+	}
+
+
+	void connection::state::add (operation_type op, priority cls, std::error_code & ec) {
+
+		if (!reserve()) {
+
+			rejected_.fetch_add(1,std::memory_order_relaxed);
+			ec=errc::queue_full;
+			return;
+
+		}
+
+		ec=std::error_code{};
+		//	The operation holds the reference to itself until
+		//	the strand takes it
+		auto & o=*op;
+		o.cls_=cls;
+		o.enqueued_=asio::steady_timer::clock_type::now();
+		o.self_=std::move(op);
+		queued_.fetch_add(1,std::memory_order_relaxed);
+		ops_.push(o);
+
+		wake();
+
+	}
+
+
+	void connection::state::admit (operation_type op, priority cls, admission_handler handler) {
+
+		submit(command{std::move(op),nullptr,cls,asio::steady_timer::clock_type::now(),std::move(handler)});
+
+	}
+
+
+	void connection::state::wakeup () {
+
+		if (!suspended_) return;
+
+		suspended_=false;
+		perform(operation::socket_status::readable);
+
+	}
+
+
+	void connection::state::resume (operation_type op) {
+
+		//	Holding the operation until the request is handled
+		//	means another cannot take its place in memory
+		strand_.post([self=shared_from_this(),op=std::move(op)] () {
+
+			self->run([&] () {
+
+				//	The operation has finished, a request which
+				//	arrives late must not wake whichever operation
+				//	is running now
+				if (op!=self->op_) return;
+
+				self->wakeup();
+
+			});
+
+		});
+
+	}
+
+
+	void connection::state::resume (std::size_t epoch) {
+
+		strand_.post([self=shared_from_this(),epoch] () {
+
+			self->run([&] () {
+
+				if (epoch!=self->epoch_) return;
+
+				self->wakeup();
+
+			});
+
+		});
+
+	}
+
+
+	void connection::state::pipeline (bool enable) noexcept {
+
+		pipeline_.store(enable,std::memory_order_relaxed);
+
+	}
+
+
+	bool connection::state::pipeline () const noexcept {
+
+		return pipeline_.load(std::memory_order_relaxed);
+
+	}
+
+
+	void connection::state::cache (std::size_t capacity, std::size_t threshold) {
+
+		submit(command{nullptr,[capacity,threshold] (state & self) {	self.statements_.configure(capacity,threshold);	},priority::normal,{},nullptr});
+
+	}
+
+
+	void connection::state::aging (std::chrono::milliseconds interval) {
+
+		submit(command{nullptr,[interval] (state & self) {	self.pending_.aging(interval);	},priority::normal,{},nullptr});
+
+	}
+
+
+	void connection::state::earliest_deadline_first (bool enable) {
+
+		submit(command{nullptr,[enable] (state & self) {	self.pending_.earliest_deadline_first(enable);	},priority::normal,{},nullptr});
+
+	}
+
+
+	void connection::state::limit (std::size_t max) {
+
+		limit_.store(max,std::memory_order_relaxed);
+
+		//	Raising the limit may admit operations which are
+		//	waiting for admission
+		submit(command{nullptr,[] (state & self) {	self.admit();	},priority::normal,{},nullptr});
+
+	}
+
+
+	void connection::state::completion_executor (asio::executor executor) {
+
+		submit(command{nullptr,[executor=std::move(executor)] (state & self) mutable {	self.executor_=std::move(executor);	},priority::normal,{},nullptr});
+
+	}
+
+
+	connection::subscription_type connection::state::subscribe (std::string channel, notification_handler handler) {
+
+		auto retr=next_.fetch_add(1,std::memory_order_relaxed);
+		submit(command{nullptr,[retr,channel=std::move(channel),handler=std::move(handler)] (state & self) mutable {
+
+			auto & n=self.notifications_;
+			if (!n.listening(channel)) {
+
+				auto q=std::make_shared<listen_query>(std::vector<std::string>{channel},"LISTEN");
+				self.occupy();
+				if (auto ex=self.enqueue_reserved(
+					std::move(q),
+					priority::normal,
+					asio::steady_timer::clock_type::now()
+				)) std::rethrow_exception(ex);
+
+			}
+			n.subscribe(retr,channel,std::move(handler));
+
+		},priority::normal,{},nullptr});
+
+		return retr;
+
+	}
+
+
+	void connection::state::unsubscribe (subscription_type id) {
+
+		submit(command{nullptr,[id] (state & self) {
+
+			auto channel=self.notifications_.unsubscribe(id);
+			if (!channel) return;
+
+			auto q=std::make_shared<listen_query>(std::vector<std::string>{std::move(*channel)},"UNLISTEN");
+			self.occupy();
+			if (auto ex=self.enqueue_reserved(
+				std::move(q),
+				priority::normal,
+				asio::steady_timer::clock_type::now()
+			)) std::rethrow_exception(ex);
+
+		},priority::normal,{},nullptr});
+
+	}
+
+
+	connection::statistics_type connection::state::statistics () const {
+
+		std::unique_lock<std::mutex> l(stats_mutex_);
+		auto retr=stats_;
+		l.unlock();
+
+		retr.expired=expired_.load(std::memory_order_relaxed);
+		retr.max_waiting=max_waiting_.load(std::memory_order_relaxed);
+		retr.rejected=rejected_.load(std::memory_order_relaxed);
+		for (std::size_t i=0;i<priorities;++i) {
+
+			auto & from=waits_[i];
+			auto & to=retr.waits[i];
+			to.operations=from.operations.load(std::memory_order_relaxed);
+			to.total=statistics_type::duration(from.total.load(std::memory_order_relaxed));
+			to.max=statistics_type::duration(from.max.load(std::memory_order_relaxed));
+
+		}
+
+		return retr;
+
+	}
+
+
+	std::size_t connection::state::size () const noexcept {
+
+		return queued_.load(std::memory_order_relaxed)+size_.load(std::memory_order_relaxed);
+
+	}
+
+
+	std::size_t connection::state::waiting () const noexcept {
+
+		return waiting_.load(std::memory_order_relaxed);
+
+	}
+
+
+	asio::io_service & connection::state::get_io_service () const noexcept {
+
+		return ios_;
+
+	}
+
+
+	connection::native_handle_type connection::state::native_handle () const noexcept {
+
+		return handle_;
+
+	}
+
+
+	connection::connection (native_handle_type handle, asio::io_service & ios) : state_(std::make_shared<state>(handle,ios)) {	}
+
+
+	connection::connection (connection && rhs) noexcept : state_(std::move(rhs.state_)) {	}
+
+
+	connection::~connection () noexcept {
+
+		if (state_) state_->stop();
+
+	}
+
+
+	void connection::add (operation_type op, priority cls) {
+
+		state_->add(std::move(op),cls);
+
+	}
+
+
+	void connection::add (operation_type op, priority cls, std::error_code & ec) {
+
+		state_->add(std::move(op),cls,ec);
+
+	}
+
+
+	void connection::admit (operation_type op, priority cls, admission_handler handler) {
+
+		state_->admit(std::move(op),cls,std::move(handler));
+
+	}
+
+
+	void connection::resume (operation_type op) {
+
+		state_->resume(std::move(op));
+
+	}
+
+
+	void connection::pipeline (bool enable) {
+
+		#ifndef LIBPQ_HAS_PIPELINING
+		if (enable) throw std::logic_error("libpq does not support pipeline mode");
+		#endif
+
+		state_->pipeline(enable);
+
+	}
+
+
+	bool connection::pipeline () const noexcept {
+
+		return state_->pipeline();
+
+	}
+
+
+	void connection::cache (std::size_t capacity, std::size_t threshold) {
+
+		state_->cache(capacity,threshold);
+
+	}
+
+
+	void connection::aging (std::chrono::milliseconds interval) {
+
+		state_->aging(interval);
+
+	}
+
+
+	void connection::earliest_deadline_first (bool enable) {
+
+		state_->earliest_deadline_first(enable);
+
+	}
+
+
+	void connection::limit (std::size_t max) {
+
+		state_->limit(max);
+
+	}
+
+
+	void connection::completion_executor (asio::executor executor) {
+
+		state_->completion_executor(std::move(executor));
+
+	}
+
+
+	connection::subscription_type connection::subscribe (std::string channel, notification_handler handler) {
+
+		return state_->subscribe(std::move(channel),std::move(handler));
+
+	}
+
+
+	void connection::unsubscribe (subscription_type id) {
+
+		state_->unsubscribe(id);
+
+	}
+
+
+	connection::statistics_type connection::statistics () const {
+
+		return state_->statistics();
+
+	}
+
+
+	std::size_t connection::size () const noexcept {
+
+		return state_->size();
+
+	}
+
+
+	std::size_t connection::waiting () const noexcept {
+
+		return state_->waiting();
+
+	}
+
+
+	asio::io_service & connection::get_io_service () const noexcept {
+
+		return state_->get_io_service();
+
+	}
+
+
+	connection::native_handle_type connection::native_handle () const noexcept {
+
+		return state_->native_handle();
 
 	}
 
@@ -0,0 +1,250 @@
+#include <asiopq/asio.hpp>
+#include <asiopq/copy_in.hpp>
+#include <asiopq/errc.hpp>
+#include <asiopq/exception.hpp>
+#include <asiopq/scope.hpp>
+#include <libpq-fe.h>
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <limits>
+
+
+namespace asiopq {
+
+
+	void copy_in::next () {
+
+		buffers_.clear();
+		pos_=0;
+		offset_=0;
+
+		try {
+
+			more_=produce(buffers_);
+
+		} catch (...) {
+
+			ex_=std::current_exception();
+			more_=false;
+
+		}
+
+		//	Asking again immediately would spin until the
+		//	producer has something
+		starved_=more_ && (asio::buffer_size(buffers_)==0);
+
+	}
+
+
+	copy_in::operation_status copy_in::put (native_handle_type handle) {
+
+		for (;;) {
+
+			if (pos_==buffers_.size()) {
+
+				if (!more_) {
+
+					state_=state::ending;
+					return end(handle);
+
+				}
+
+				if (starved_) {
+
+					//	Whatever libpq has buffered is sent before
+					//	waiting to be resumed
+					switch (PQflush(handle)) {
+
+						case 0:
+							break;
+						case 1:
+							return operation_status::read_write;
+						default:
+							set_error(errc::connection_failed);
+							return operation_status::done;
+
+					}
+
+					starved_=false;
+
+					return operation_status::suspend;
+
+				}
+
+				next();
+				continue;
+
+			}
+
+			auto & buffer=buffers_[pos_];
+			auto size=asio::buffer_size(buffer);
+			auto n=std::min<std::size_t>(size-offset_,std::numeric_limits<int>::max());
+			if (n!=0) switch (PQputCopyData(
+				handle,
+				asio::buffer_cast<const char *>(buffer)+offset_,
+				static_cast<int>(n)
+			)) {
+
+				case 1:
+					break;
+				//	libpq could not buffer the data without
+				//	blocking: Try again once the socket becomes
+				//	writable
+				case 0:
+					return operation_status::read_write;
+				default:
+					set_error(errc::connection_failed);
+					return operation_status::done;
+
+			}
+
+			offset_+=n;
+			if (offset_!=size) continue;
+
+			++pos_;
+			offset_=0;
+
+		}
+
+	}
+
+
+	copy_in::operation_status copy_in::end (native_handle_type handle) {
+
+		//	If the producer failed the server is told to
+		//	abort the copy
+		switch (PQputCopyEnd(handle,ex_ ? "Aborted by client" : nullptr)) {
+
+			case 1:
+				break;
+			case 0:
+				return operation_status::read_write;
+			default:
+				set_error(errc::connection_failed);
+				return operation_status::done;
+
+		}
+
+		state_=state::flushing;
+
+		return finish(handle);
+
+	}
+
+
+	copy_in::operation_status copy_in::finish (native_handle_type handle) {
+
+		switch (PQflush(handle)) {
+
+			case 0:
+				break;
+			case 1:
+				return operation_status::read_write;
+			default:
+				set_error(errc::connection_failed);
+				return operation_status::done;
+
+		}
+
+		state_=state::finishing;
+
+		return results(handle);
+
+	}
+
+
+	copy_in::operation_status copy_in::results (native_handle_type handle) {
+
+		while (PQisBusy(handle)==0) {
+
+			auto res=PQgetResult(handle);
+			if (!res) {
+
+				if (ex_) std::rethrow_exception(ex_);
+
+				return operation_status::done;
+
+			}
+
+			if ((state_==state::command) && (PQresultStatus(res)==PGRES_COPY_IN)) {
+
+				PQclear(res);
+				state_=state::copying;
+
+				return put(handle);
+
+			}
+
+			//	The server's report of the failure of an aborted
+			//	copy is superseded by the reason it was aborted
+			if (ex_) PQclear(res);
+			else result(res);
+
+		}
+
+		return operation_status::read;
+
+	}
+
+
+	copy_in::copy_in (timeout_type timeout) : query(timeout), state_(state::command), pos_(0), offset_(0), more_(true), starved_(false) {	}
+
+
+	const std::string & copy_in::rows () const noexcept {
+
+		return rows_;
+
+	}
+
+
+	void copy_in::result (native_result_type result) {
+
+		auto g=make_scope_exit([&] () noexcept {	PQclear(result);	});
+
+		if (PQresultStatus(result)!=PGRES_COMMAND_OK) throw result_error(result);
+
+		rows_=PQcmdTuples(result);
+
+	}
+
+
+	bool copy_in::pipelinable () const noexcept {
+
+		return false;
+
+	}
+
+
+	copy_in::operation_status copy_in::perform (native_handle_type handle, socket_status status) {
+
+		//	Still sending the COPY command
+		if (!flushed()) return query::perform(handle,status);
+
+		if ((status==socket_status::readable) && (PQconsumeInput(handle)==0)) {
+
+			set_error(errc::connection_failed);
+
+			return operation_status::done;
+
+		}
+
+		switch (state_) {
+
+			case state::copying:
+				return put(handle);
+			case state::ending:
+				return end(handle);
+			case state::flushing:
+				return finish(handle);
+			default:
+				break;
+
+		}
+
+		return results(handle);
+
+	}
+
+
+}
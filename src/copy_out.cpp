@@ -0,0 +1,197 @@
+#include <asiopq/asio.hpp>
+#include <asiopq/copy_out.hpp>
+#include <asiopq/errc.hpp>
+#include <asiopq/exception.hpp>
+#include <asiopq/scope.hpp>
+#include <libpq-fe.h>
+#include <cstddef>
+#include <exception>
+#include <utility>
+
+
+namespace asiopq {
+
+
+	copy_out::chunk::chunk (char * ptr, std::size_t size) noexcept : ptr_(ptr), size_(size) {	}
+
+
+	copy_out::chunk::chunk (chunk && rhs) noexcept : ptr_(rhs.ptr_), size_(rhs.size_) {
+
+		rhs.ptr_=nullptr;
+		rhs.size_=0;
+
+	}
+
+
+	copy_out::chunk & copy_out::chunk::operator = (chunk && rhs) noexcept {
+
+		using std::swap;
+		swap(ptr_,rhs.ptr_);
+		swap(size_,rhs.size_);
+
+		return *this;
+
+	}
+
+
+	copy_out::chunk::~chunk () noexcept {
+
+		if (ptr_) PQfreemem(ptr_);
+
+	}
+
+
+	const char * copy_out::chunk::data () const noexcept {
+
+		return ptr_;
+
+	}
+
+
+	std::size_t copy_out::chunk::size () const noexcept {
+
+		return size_;
+
+	}
+
+
+	asio::const_buffers_1 copy_out::chunk::buffer () const noexcept {
+
+		return asio::buffer(static_cast<const void *>(ptr_),size_);
+
+	}
+
+
+	copy_out::operation_status copy_out::copy (native_handle_type handle) {
+
+		for (;;) {
+
+			char * ptr;
+			auto n=PQgetCopyData(handle,&ptr,1);
+			switch (n) {
+
+				//	No complete row is available yet
+				case 0:
+					return operation_status::read;
+				//	The copy is done
+				case -1:
+					state_=state::finishing;
+					return results(handle);
+				case -2:
+					set_error(errc::connection_failed);
+					return operation_status::done;
+				default:
+					break;
+
+			}
+
+			chunk c(ptr,static_cast<std::size_t>(n));
+			//	Once the sink has failed the remaining data
+			//	is discarded
+			if (ex_) continue;
+
+			try {
+
+				//	Stop retrieving data (and reading the socket)
+				//	until the sink catches up
+				if (!consume(std::move(c))) return operation_status::suspend;
+
+			} catch (...) {
+
+				ex_=std::current_exception();
+
+			}
+
+		}
+
+	}
+
+
+	copy_out::operation_status copy_out::results (native_handle_type handle) {
+
+		while (PQisBusy(handle)==0) {
+
+			auto res=PQgetResult(handle);
+			if (!res) {
+
+				if (ex_) std::rethrow_exception(ex_);
+
+				return operation_status::done;
+
+			}
+
+			if ((state_==state::command) && (PQresultStatus(res)==PGRES_COPY_OUT)) {
+
+				PQclear(res);
+				state_=state::copying;
+
+				return copy(handle);
+
+			}
+
+			if (ex_) PQclear(res);
+			else result(res);
+
+		}
+
+		return operation_status::read;
+
+	}
+
+
+	void copy_out::fail (std::exception_ptr ex) noexcept {
+
+		if (!ex_) ex_=std::move(ex);
+
+	}
+
+
+	copy_out::copy_out (timeout_type timeout) : query(timeout), state_(state::command) {	}
+
+
+	const std::string & copy_out::rows () const noexcept {
+
+		return rows_;
+
+	}
+
+
+	void copy_out::result (native_result_type result) {
+
+		auto g=make_scope_exit([&] () noexcept {	PQclear(result);	});
+
+		if (PQresultStatus(result)!=PGRES_COMMAND_OK) throw result_error(result);
+
+		rows_=PQcmdTuples(result);
+
+	}
+
+
+	bool copy_out::pipelinable () const noexcept {
+
+		return false;
+
+	}
+
+
+	copy_out::operation_status copy_out::perform (native_handle_type handle, socket_status status) {
+
+		//	Still sending the COPY command
+		if (!flushed()) return query::perform(handle,status);
+
+		if ((status==socket_status::readable) && (PQconsumeInput(handle)==0)) {
+
+			set_error(errc::connection_failed);
+
+			return operation_status::done;
+
+		}
+
+		if (state_==state::copying) return copy(handle);
+
+		return results(handle);
+
+	}
+
+
+}
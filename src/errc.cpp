@@ -0,0 +1,87 @@
+#include <asiopq/errc.hpp>
+#include <string>
+#include <system_error>
+
+
+namespace asiopq {
+
+
+	namespace {
+
+
+		class category : public std::error_category {
+
+
+			public:
+
+
+				virtual const char * name () const noexcept override {
+
+					return "asiopq";
+
+				}
+
+
+				virtual std::string message (int ev) const override {
+
+					switch (static_cast<errc>(ev)) {
+
+						case errc::aborted:
+							return "Operation aborted";
+						case errc::timed_out:
+							return "Operation exceeded timeout";
+						case errc::queue_full:
+							return "Operation rejected, too many operations already waiting";
+						case errc::connection_failed:
+							return "Connection failed";
+
+					}
+
+					return "Unknown error";
+
+				}
+
+
+				virtual std::error_condition default_error_condition (int ev) const noexcept override {
+
+					switch (static_cast<errc>(ev)) {
+
+						case errc::aborted:
+							return std::errc::operation_canceled;
+						case errc::timed_out:
+							return std::errc::timed_out;
+						case errc::queue_full:
+							return std::errc::resource_unavailable_try_again;
+						case errc::connection_failed:
+							return std::errc::io_error;
+
+					}
+
+					return std::error_condition(ev,*this);
+
+				}
+
+
+		};
+
+
+	}
+
+
+	const std::error_category & error_category () noexcept {
+
+		static const category retr;
+
+		return retr;
+
+	}
+
+
+	std::error_code make_error_code (errc e) noexcept {
+
+		return std::error_code(static_cast<int>(e),error_category());
+
+	}
+
+
+}
@@ -1,5 +1,6 @@
 #include <asiopq/exception.hpp>
 #include <libpq-fe.h>
+#include <cstddef>
 #include <sstream>
 #include <string>
 
@@ -25,6 +26,9 @@ namespace asiopq {
 	connection_error::connection_error (native_handle_type handle) : error(get_error_message(PQerrorMessage(handle))) {	}
 
 
+	connection_error::connection_error (const std::string & message) : error(message) {	}
+
+
 	aborted::aborted () : error("Operation aborted") {	}
 
 
@@ -50,6 +54,26 @@ namespace asiopq {
 	}
 
 
+	static std::string get_queue_full_message (std::size_t limit) {
+
+		std::ostringstream ss;
+		ss << "Operation rejected, " << limit << " operations already waiting";
+
+		return ss.str();
+
+	}
+
+
+	queue_full::queue_full (std::size_t limit) : error(get_queue_full_message(limit)), limit_(limit) {	}
+
+
+	std::size_t queue_full::limit () const noexcept {
+
+		return limit_;
+
+	}
+
+
 	result_error::result_error (native_result_type result) : error(get_error_message(PQresultErrorMessage(result))) {	}
 
 
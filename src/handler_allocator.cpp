@@ -0,0 +1,57 @@
+#include <asiopq/handler_allocator.hpp>
+#include <atomic>
+#include <cstddef>
+#include <new>
+
+
+namespace asiopq {
+
+
+	handler_arena::handler_arena () noexcept {
+
+		for (auto && b : blocks_) b.used.store(false,std::memory_order_relaxed);
+
+	}
+
+
+	void * handler_arena::allocate (std::size_t n, std::size_t alignment) {
+
+		if (alignment>alignof(std::max_align_t)) throw std::bad_alloc{};
+
+		if (n<=size) for (auto && b : blocks_) {
+
+			if (b.used.load(std::memory_order_relaxed)) continue;
+			if (!b.used.exchange(true,std::memory_order_acquire)) return &b.storage;
+
+		}
+
+		return ::operator new(n);
+
+	}
+
+
+	void handler_arena::deallocate (void * ptr) noexcept {
+
+		for (auto && b : blocks_) if (ptr==&b.storage) {
+
+			b.used.store(false,std::memory_order_release);
+			return;
+
+		}
+
+		::operator delete(ptr);
+
+	}
+
+
+	std::size_t handler_arena::used () const noexcept {
+
+		std::size_t retr=0;
+		for (auto && b : blocks_) if (b.used.load(std::memory_order_relaxed)) ++retr;
+
+		return retr;
+
+	}
+
+
+}
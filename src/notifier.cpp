@@ -0,0 +1,111 @@
+#include <asiopq/notifier.hpp>
+#include <asiopq/optional.hpp>
+#include <libpq-fe.h>
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace asiopq {
+
+
+	bool notifier::listening (const std::string & channel) const {
+
+		return channels_.find(channel)!=channels_.end();
+
+	}
+
+
+	void notifier::subscribe (subscription_type id, const std::string & channel, handler_type handler) {
+
+		auto & pair=*channels_.emplace(channel,std::vector<entry>{}).first;
+		auto & entries=pair.second;
+		entries.push_back(entry{id,std::move(handler)});
+
+		try {
+
+			ids_.emplace(id,&pair);
+
+		} catch (...) {
+
+			entries.pop_back();
+			if (entries.empty()) channels_.erase(channel);
+			throw;
+
+		}
+
+	}
+
+
+	optional<std::string> notifier::unsubscribe (subscription_type id) {
+
+		auto iter=ids_.find(id);
+		if (iter==ids_.end()) return nullopt;
+
+		auto & pair=*iter->second;
+		ids_.erase(iter);
+
+		auto & entries=pair.second;
+		entries.erase(
+			std::find_if(entries.begin(),entries.end(),[&] (const entry & e) noexcept {	return e.id==id;	})
+		);
+		if (!entries.empty()) return nullopt;
+
+		optional<std::string> retr(pair.first);
+		channels_.erase(*retr);
+
+		return retr;
+
+	}
+
+
+	void notifier::dispatch (const PGnotify & notify) const {
+
+		auto iter=channels_.find(notify.relname);
+		if (iter==channels_.end()) return;
+
+		std::exception_ptr ex;
+		for (auto && e : iter->second) try {
+
+			e.handler(notify);
+
+		} catch (...) {
+
+			if (!ex) ex=std::current_exception();
+
+		}
+
+		if (ex) std::rethrow_exception(ex);
+
+	}
+
+
+	std::vector<std::string> notifier::channels () const {
+
+		std::vector<std::string> retr;
+		retr.reserve(channels_.size());
+		for (auto && pair : channels_) retr.push_back(pair.first);
+
+		return retr;
+
+	}
+
+
+	bool notifier::empty () const noexcept {
+
+		return channels_.empty();
+
+	}
+
+
+	std::size_t notifier::size () const noexcept {
+
+		return channels_.size();
+
+	}
+
+
+}
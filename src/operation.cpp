@@ -1,4 +1,11 @@
+#include <asiopq/errc.hpp>
+#include <asiopq/exception.hpp>
 #include <asiopq/operation.hpp>
+#include <chrono>
+#include <exception>
+#include <string>
+#include <system_error>
+#include <utility>
 
 
 namespace asiopq {
@@ -7,4 +14,29 @@ namespace asiopq {
 	operation::~operation () noexcept {	}
 
 
+	void operation::set_error (std::error_code ec) noexcept {
+
+		ec_=ec;
+
+	}
+
+
+	void operation::complete (std::error_code ec, const std::string & message) {
+
+		std::exception_ptr ex;
+		if (ec==errc::aborted) ex=std::make_exception_ptr(aborted{});
+		else if (ec==errc::timed_out) {
+
+			auto ms=timeout();
+			ex=std::make_exception_ptr(timed_out(ms ? *ms : std::chrono::milliseconds(0)));
+
+		}
+		else if (ec==errc::connection_failed) ex=std::make_exception_ptr(connection_error(message));
+		else ex=std::make_exception_ptr(std::system_error(ec));
+
+		complete(std::move(ex));
+
+	}
+
+
 }
@@ -0,0 +1,245 @@
+#include <asiopq/operation.hpp>
+#include <asiopq/optional.hpp>
+#include <asiopq/pending_queue.hpp>
+#include <asiopq/priority.hpp>
+#include <cstddef>
+#include <utility>
+
+
+namespace asiopq {
+
+
+	bool pending_queue::later (const operation & a, const operation & b) const noexcept {
+
+		//	Operations without a deadline follow those with
+		//	one
+		if (edf_ && (a.deadline_!=b.deadline_)) {
+
+			if (!a.deadline_) return true;
+			if (!b.deadline_) return false;
+
+			return *a.deadline_>*b.deadline_;
+
+		}
+
+		return a.sequence_>b.sequence_;
+
+	}
+
+
+	void pending_queue::insert (list & l, operation & o) noexcept {
+
+		//	Operations usually arrive in order so appending
+		//	is checked first
+		if (!l.tail || later(o,*l.tail)) {
+
+			o.next_=nullptr;
+			if (l.tail) l.tail->next_=&o;
+			else l.head=&o;
+			l.tail=&o;
+
+			return;
+
+		}
+
+		operation * prev=nullptr;
+		auto curr=l.head;
+		while (!later(*curr,o)) {
+
+			prev=curr;
+			curr=curr->next_;
+
+		}
+		o.next_=curr;
+		if (prev) prev->next_=&o;
+		else l.head=&o;
+
+	}
+
+
+	std::size_t pending_queue::select (time_point now) {
+
+		if (selected_!=none) return selected_;
+
+		if (front_.head) return selected_=priorities;
+
+		std::size_t retr=none;
+		long long best=0;
+		for (std::size_t i=0;i<classes_.size();++i) {
+
+			auto head=classes_[i].head;
+			if (!head) continue;
+
+			//	The head is promoted by one class for every
+			//	aging interval it has waited, ties go to the
+			//	operation which has waited longest and then to
+			//	the higher class
+			long long effective=static_cast<long long>(i);
+			if (aging_!=duration::zero()) {
+
+				auto waited=now-head->enqueued_;
+				if (waited>duration::zero()) effective-=static_cast<long long>(waited/aging_);
+
+			}
+
+			if ((retr!=none) && (
+				(effective>best) ||
+				((effective==best) && (head->enqueued_>=classes_[retr].head->enqueued_))
+			)) continue;
+
+			retr=i;
+			best=effective;
+
+		}
+
+		return selected_=retr;
+
+	}
+
+
+	pending_queue::pending_queue (duration aging) noexcept
+		:	aging_(aging),
+			edf_(false),
+			size_(0),
+			sequence_(0),
+			selected_(none)
+	{	}
+
+
+	pending_queue::~pending_queue () noexcept {
+
+		clear();
+
+	}
+
+
+	void pending_queue::aging (duration aging) noexcept {
+
+		aging_=aging;
+		selected_=none;
+
+	}
+
+
+	void pending_queue::earliest_deadline_first (bool enable) {
+
+		if (edf_==enable) return;
+
+		edf_=enable;
+		for (auto && c : classes_) {
+
+			auto o=c.head;
+			c=list{};
+			while (o) {
+
+				auto next=o->next_;
+				insert(c,*o);
+				o=next;
+
+			}
+
+		}
+		selected_=none;
+
+	}
+
+
+	void pending_queue::push_back (value_type op, priority cls, time_point when, optional<time_point> deadline) {
+
+		auto & o=*op;
+		o.cls_=cls;
+		o.enqueued_=when;
+		o.deadline_=deadline;
+		o.sequence_=sequence_++;
+		o.self_=std::move(op);
+		insert(classes_[static_cast<std::size_t>(cls)],o);
+		++size_;
+		selected_=none;
+
+	}
+
+
+	void pending_queue::push_front (value_type op) {
+
+		auto & o=*op;
+		o.enqueued_=time_point{};
+		o.deadline_=nullopt;
+		o.sequence_=0;
+		o.next_=front_.head;
+		o.self_=std::move(op);
+		front_.head=&o;
+		if (!front_.tail) front_.tail=&o;
+		++size_;
+		selected_=none;
+
+	}
+
+
+	const pending_queue::value_type & pending_queue::front (time_point now) {
+
+		auto i=select(now);
+
+		return ((i==priorities) ? front_ : classes_[i]).head->self_;
+
+	}
+
+
+	pending_queue::entry pending_queue::pop_front (time_point now) {
+
+		auto i=select(now);
+		auto & l=(i==priorities) ? front_ : classes_[i];
+		auto & o=*l.head;
+		l.head=o.next_;
+		if (!l.head) l.tail=nullptr;
+		o.next_=nullptr;
+		--size_;
+		selected_=none;
+
+		optional<priority> cls;
+		if (i!=priorities) cls=o.cls_;
+
+		return entry{std::move(o.self_),o.enqueued_,cls,o.deadline_,o.sequence_};
+
+	}
+
+
+	void pending_queue::clear () noexcept {
+
+		auto release=[] (list & l) noexcept {
+
+			auto o=l.head;
+			l=list{};
+			while (o) {
+
+				auto next=o->next_;
+				o->next_=nullptr;
+				//	May destroy the operation
+				o->self_.reset();
+				o=next;
+
+			}
+
+		};
+		release(front_);
+		for (auto && c : classes_) release(c);
+		size_=0;
+		selected_=none;
+
+	}
+
+
+	bool pending_queue::empty () const noexcept {
+
+		return size_==0;
+
+	}
+
+
+	std::size_t pending_queue::size () const noexcept {
+
+		return size_;
+
+	}
+
+
+}
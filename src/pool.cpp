@@ -0,0 +1,361 @@
+#include <asiopq/asio.hpp>
+#include <asiopq/connect.hpp>
+#include <asiopq/connection.hpp>
+#include <asiopq/operation.hpp>
+#include <asiopq/pool.hpp>
+#include <asiopq/priority.hpp>
+#include <asiopq/reset.hpp>
+#include <asiopq/scope.hpp>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+
+namespace asiopq {
+
+
+	static constexpr std::size_t pinned_bit=~(std::numeric_limits<std::size_t>::max()>>1);
+
+
+	//	The health of a member of the pool
+	static constexpr unsigned healthy=0;
+	static constexpr unsigned disconnected=1;
+	static constexpr unsigned reconnecting=2;
+
+
+	namespace {
+
+
+		//	Records whether the connection was established rather
+		//	than discarding the outcome
+		class pool_connect : public basic_connect {
+
+
+			private:
+
+
+				std::shared_ptr<std::atomic<unsigned>> health_;
+
+
+			public:
+
+
+				pool_connect (const char * conninfo, timeout_type timeout, std::shared_ptr<std::atomic<unsigned>> health)
+					:	basic_connect(conninfo,timeout),
+						health_(std::move(health))
+				{	}
+
+
+				asiopq::connection open (asio::io_service & ios) {
+
+					return release(ios);
+
+				}
+
+
+				virtual void complete (std::exception_ptr ex) override {
+
+					health_->store(ex ? disconnected : healthy,std::memory_order_release);
+
+				}
+
+
+		};
+
+
+		class pool_reset : public basic_reset {
+
+
+			private:
+
+
+				std::shared_ptr<std::atomic<unsigned>> health_;
+
+
+			public:
+
+
+				pool_reset (timeout_type timeout, std::shared_ptr<std::atomic<unsigned>> health)
+					:	basic_reset(timeout),
+						health_(std::move(health))
+				{	}
+
+
+				virtual void complete (std::exception_ptr ex) override {
+
+					health_->store(ex ? disconnected : healthy,std::memory_order_release);
+
+				}
+
+
+		};
+
+
+	}
+
+
+	pool::member::member (asiopq::connection conn, std::shared_ptr<std::atomic<unsigned>> health)
+		:	connection(std::move(conn)),
+			state(0),
+			health(std::move(health))
+	{	}
+
+
+	pool::pinned::pinned (member & m) noexcept : m_(&m) {	}
+
+
+	pool::pinned::pinned (pinned && rhs) noexcept : m_(rhs.m_) {
+
+		rhs.m_=nullptr;
+
+	}
+
+
+	pool::pinned::~pinned () noexcept {
+
+		if (m_) m_->state.fetch_and(~pinned_bit,std::memory_order_release);
+
+	}
+
+
+	void pool::pinned::add (operation_type op, priority cls) {
+
+		m_->connection.add(std::move(op),cls);
+
+	}
+
+
+	connection & pool::pinned::connection () const noexcept {
+
+		return m_->connection;
+
+	}
+
+
+	void pool::init (const char * conninfo, const io_services_type & ios, operation::timeout_type timeout) {
+
+		if ((size_==0) || ios.empty()) throw std::logic_error("Pool must contain at least one connection");
+
+		conninfo_=conninfo;
+		ios_=&ios.front().get();
+		timeout_=timeout;
+
+		members_.reserve(size_*ios.size());
+		for (auto && s : ios) for (std::size_t i=0;i<size_;++i) {
+
+			auto health=std::make_shared<std::atomic<unsigned>>(healthy);
+			auto c=std::make_shared<pool_connect>(conninfo,timeout,health);
+			members_.push_back(std::make_unique<member>(c->open(s.get()),std::move(health)));
+			members_.back()->connection.add(std::move(c));
+
+		}
+
+	}
+
+
+	std::size_t pool::shards () const noexcept {
+
+		return members_.size()/size_;
+
+	}
+
+
+	std::size_t pool::home () const noexcept {
+
+		//	A thread running a shard's asio::io_service stays
+		//	on that shard
+		auto n=shards();
+		for (std::size_t i=0;i<n;++i) if (members_[i*size_]->connection.get_io_service().get_executor().running_in_this_thread()) return i;
+
+		//	Other threads are assigned to shards round robin
+		//	so that submitting threads do not all contend for
+		//	the same connections
+		static std::atomic<std::size_t> next(0);
+		thread_local auto i=next.fetch_add(1,std::memory_order_relaxed);
+
+		return i%n;
+
+	}
+
+
+	pool::member * pool::select (std::size_t shard) const noexcept {
+
+		member * retr=nullptr;
+		std::size_t size=0;
+		bool connected=false;
+		auto begin=members_.begin()+shard*size_;
+		for (auto iter=begin,end=begin+size_;iter!=end;++iter) {
+
+			auto & m=**iter;
+			if ((m.state.load(std::memory_order_acquire)&pinned_bit)!=0) continue;
+
+			//	Connections which failed are only used when
+			//	there's nothing else
+			auto h=m.health->load(std::memory_order_acquire)==healthy;
+			if (connected && !h) continue;
+
+			auto s=m.connection.size();
+			if (retr && (connected==h) && (s>=size)) continue;
+
+			retr=&m;
+			size=s;
+			connected=h;
+
+		}
+
+		return retr;
+
+	}
+
+
+	pool::member * pool::acquire () const noexcept {
+
+		auto h=home();
+		auto n=shards();
+		for (std::size_t i=0;i<n;) {
+
+			auto m=select((h+i)%n);
+			if (!m) {
+
+				++i;
+				continue;
+
+			}
+
+			//	Announce that this thread is dispatching to
+			//	this connection so that it cannot be pinned
+			//	out from under it
+			if ((m->state.fetch_add(1,std::memory_order_acquire)&pinned_bit)==0) return m;
+
+			//	Pinned since it was selected, try again
+			m->state.fetch_sub(1,std::memory_order_relaxed);
+
+		}
+
+		return nullptr;
+
+	}
+
+
+	pool::member * pool::pin_member () const noexcept {
+
+		auto h=home();
+		auto n=shards();
+		for (std::size_t i=0;i<n;) {
+
+			auto m=select((h+i)%n);
+			if (!m) {
+
+				++i;
+				continue;
+
+			}
+
+			auto state=m->state.fetch_or(pinned_bit,std::memory_order_acquire);
+			//	Somebody else pinned it since it was selected
+			if ((state&pinned_bit)!=0) continue;
+
+			//	Wait for threads which were already dispatching
+			//	to this connection to finish doing so, new threads
+			//	will see that it is pinned and go elsewhere
+			while ((m->state.load(std::memory_order_acquire)&~pinned_bit)!=0) std::this_thread::yield();
+
+			return m;
+
+		}
+
+		return nullptr;
+
+	}
+
+
+	void pool::reconnect (member & m) {
+
+		//	Only one reset is enqueued at a time
+		auto expected=disconnected;
+		if (!m.health->compare_exchange_strong(expected,reconnecting,std::memory_order_acq_rel)) return;
+
+		auto g=make_scope_fail([&] () noexcept {	m.health->store(disconnected,std::memory_order_release);	});
+		m.connection.add(std::make_shared<pool_reset>(timeout_,m.health),priority::interactive);
+
+	}
+
+
+	pool::pool (const char * conninfo, std::size_t size, asio::io_service & ios, operation::timeout_type timeout) : size_(size) {
+
+		init(conninfo,io_services_type{std::ref(ios)},timeout);
+
+	}
+
+
+	pool::pool (const char * conninfo, std::size_t size, const io_services_type & ios, operation::timeout_type timeout) : size_(size) {
+
+		init(conninfo,ios,timeout);
+
+	}
+
+
+	void pool::add (operation_type op, priority cls) {
+
+		auto m=acquire();
+		if (!m) throw std::runtime_error("Every connection in the pool is pinned");
+
+		auto g=make_scope_exit([&] () noexcept {	m->state.fetch_sub(1,std::memory_order_release);	});
+
+		reconnect(*m);
+		m->connection.add(std::move(op),cls);
+
+	}
+
+
+	pool::pinned pool::pin () {
+
+		auto m=pin_member();
+		if (!m) throw std::runtime_error("Every connection in the pool is pinned");
+
+		pinned retr(*m);
+		reconnect(*m);
+
+		return retr;
+
+	}
+
+
+	connection & pool::listener () {
+
+		std::call_once(once_,[&] () {
+
+			auto c=std::make_shared<connect>(conninfo_.c_str(),timeout_);
+			listener_=std::make_unique<asiopq::connection>(c->connection(*ios_));
+
+		});
+
+		return *listener_;
+
+	}
+
+
+	std::size_t pool::failed () const noexcept {
+
+		std::size_t retr=0;
+		for (auto && m : members_) if (m->health->load(std::memory_order_relaxed)!=healthy) ++retr;
+
+		return retr;
+
+	}
+
+
+	std::size_t pool::size () const noexcept {
+
+		return members_.size();
+
+	}
+
+
+}
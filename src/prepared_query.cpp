@@ -0,0 +1,205 @@
+#include <asiopq/errc.hpp>
+#include <asiopq/exception.hpp>
+#include <asiopq/prepared_query.hpp>
+#include <asiopq/scope.hpp>
+#include <libpq-fe.h>
+#include <exception>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace asiopq {
+
+
+	void prepared_query::deallocate (native_handle_type handle) {
+
+		std::string sql;
+		for (auto i=garbage_.begin()+deallocated_;i!=garbage_.end();++i) {
+
+			sql+="DEALLOCATE \"";
+			sql+=*i;
+			sql+="\";";
+
+		}
+
+		if (PQsendQuery(handle,sql.c_str())==0) throw connection_error(handle);
+
+	}
+
+
+	void prepared_query::prepare (native_handle_type handle) {
+
+		auto p=bind();
+		if (PQsendPrepare(
+			handle,
+			name_.c_str(),
+			sql_.c_str(),
+			p.count,
+			p.types
+		)==0) throw connection_error(handle);
+
+	}
+
+
+	void prepared_query::execute (native_handle_type handle) {
+
+		auto p=bind();
+		if ((name_.empty() ? PQsendQueryParams(
+			handle,
+			sql_.c_str(),
+			p.count,
+			p.types,
+			p.values,
+			p.lengths,
+			p.formats,
+			p.result_format
+		) : PQsendQueryPrepared(
+			handle,
+			name_.c_str(),
+			p.count,
+			p.values,
+			p.lengths,
+			p.formats,
+			p.result_format
+		))==0) throw connection_error(handle);
+
+	}
+
+
+	prepared_query::operation_status prepared_query::step (native_handle_type handle) {
+
+		if (PQconsumeInput(handle)==0) {
+
+			set_error(errc::connection_failed);
+
+			return operation_status::done;
+
+		}
+
+		while (PQisBusy(handle)==0) {
+
+			auto res=PQgetResult(handle);
+			if (!res) break;
+
+			auto g=make_scope_exit([&] () noexcept {	PQclear(res);	});
+
+			//	Statements being deallocated may not exist (e.g.
+			//	if their preparation was abandoned) which is
+			//	harmless, but the server skips the statements
+			//	after one which fails so each result accounts for
+			//	one name and those without a result are sent again
+			if (state_==state::deallocating) ++deallocated_;
+			else if ((state_==state::preparing) && !ex_ && (PQresultStatus(res)!=PGRES_COMMAND_OK)) {
+
+				cache_->erase(sql_);
+				ex_=std::make_exception_ptr(result_error(res));
+
+			}
+
+		}
+
+		if (PQisBusy(handle)!=0) return operation_status::read;
+
+		//	All results of this step have been retrieved,
+		//	only now may the next command be sent
+		if (ex_) std::rethrow_exception(ex_);
+
+		if (state_==state::deallocating) {
+
+			if (deallocated_<garbage_.size()) return restart(handle);
+
+			garbage_.clear();
+			state_=state::preparing;
+
+		} else {
+
+			cache_->prepared(sql_);
+			state_=state::executing;
+
+		}
+
+		return restart(handle);
+
+	}
+
+
+	prepared_query::parameters prepared_query::bind () {
+
+		return parameters{};
+
+	}
+
+
+	prepared_query::prepared_query (std::string sql, timeout_type timeout)
+		:	query(timeout),
+			sql_(std::move(sql)),
+			state_(state::fresh),
+			cache_(nullptr),
+			deallocated_(0)
+	{	}
+
+
+	const std::string & prepared_query::sql () const noexcept {
+
+		return sql_;
+
+	}
+
+
+	void prepared_query::send (native_handle_type handle) {
+
+		switch (state_) {
+
+			case state::fresh:{
+
+				state_=state::executing;
+				if (!cache_) break;
+
+				auto u=cache_->use(sql_);
+				if (!u.name) break;
+
+				name_=*u.name;
+				if (!u.prepare) break;
+
+				state_=state::preparing;
+				garbage_=cache_->collect();
+				if (garbage_.empty()) break;
+
+				state_=state::deallocating;
+				deallocate(handle);
+
+				return;
+
+			}
+			case state::deallocating:
+				deallocate(handle);
+				return;
+			default:
+				break;
+
+		}
+
+		if (state_==state::preparing) prepare(handle);
+		else execute(handle);
+
+	}
+
+
+	bool prepared_query::pipelinable () const noexcept {
+
+		return !cache_ || cache_->ready(sql_);
+
+	}
+
+
+	prepared_query::operation_status prepared_query::perform (native_handle_type handle, socket_status status) {
+
+		if (!flushed() || (state_==state::executing)) return query::perform(handle,status);
+
+		return step(handle);
+
+	}
+
+
+}
@@ -1,4 +1,4 @@
-#include <asiopq/exception.hpp>
+#include <asiopq/errc.hpp>
 #include <asiopq/query.hpp>
 #include <libpq-fe.h>
 #include <stdexcept>
@@ -7,12 +7,13 @@
 namespace asiopq {
 
 
-	void query::flush (native_handle_type handle) {
+	bool query::flush (native_handle_type handle) noexcept {
 
 		switch (PQflush(handle)) {
 
 			default:
-				throw connection_error(handle);
+				set_error(errc::connection_failed);
+				return false;
 			case 0:
 				flushed_=true;
 				break;
@@ -21,6 +22,8 @@ namespace asiopq {
 
 		}
 
+		return true;
+
 	}
 
 
@@ -35,6 +38,22 @@ namespace asiopq {
 	}
 
 
+	bool query::flushed () const noexcept {
+
+		return flushed_;
+
+	}
+
+
+	query::operation_status query::restart (native_handle_type handle) {
+
+		flushed_=false;
+
+		return query::begin(handle);
+
+	}
+
+
 	query::query (timeout_type timeout) noexcept : timeout_(timeout), flushed_(false) {	}
 
 
@@ -47,57 +66,46 @@ namespace asiopq {
 	}
 
 
-	query::operation_status query::begin (native_handle_type handle) {
+	bool query::pipelinable () const noexcept {
 
-		send(handle);
+		return true;
 
-		//	After sending any command or data on a nonblocking connection, call PQflush.
-		flush(handle);
+	}
 
-		return get_status();
 
-	}
+	bool query::consume_input (native_handle_type handle) noexcept {
 
+		if (PQconsumeInput(handle)!=0) return true;
 
-	static void consume (query::native_handle_type handle) {
+		set_error(errc::connection_failed);
 
-		if (PQconsumeInput(handle)==0) throw connection_error(handle);
+		return false;
 
 	}
 
 
-	query::operation_status query::perform (native_handle_type handle, socket_status status) {
+	query::operation_status query::sent (native_handle_type handle) {
 
-		if (!flushed_) {
+		//	After sending any command or data on a nonblocking connection, call PQflush.
+		if (!flush(handle)) return operation_status::done;
+
+		return get_status();
 
-			//	If it becomes read-ready, call PQconsumeInput...
-			if (status==socket_status::readable) consume(handle);
-			//	...then call PQflush again.
-			//
-			//	If it becomes write-ready, call PQflush again.
-			flush(handle);
+	}
 
-			return get_status();
 
-		}
+	query::operation_status query::begin (native_handle_type handle) {
 
-		//	When the main loop detects input ready, it should call PQconsumeInput to read
-		//	the input.
-		consume(handle);
+		send(handle);
 
-		//	It can then call PQisBusy, followed by PQgetResult if PQisBusy returns false (0).
-		while (PQisBusy(handle)==0) {
+		return sent(handle);
 
-			auto res=PQgetResult(handle);
-			//	PQgetResult must be called repeatedly until it returns a null pointer,
-			//	indicating that the command is done.
-			if (!res) return operation_status::done;
+	}
 
-			result(res);
 
-		}
+	query::operation_status query::perform (native_handle_type handle, socket_status status) {
 
-		return operation_status::read;
+		return receive(handle,status,[&] (native_result_type res) {	result(res);	});
 
 	}
 
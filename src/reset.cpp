@@ -7,18 +7,10 @@
 namespace asiopq {
 
 
-	reset::reset (timeout_type timeout) : timeout_(timeout) {	}
+	basic_reset::basic_reset (timeout_type timeout) : timeout_(timeout) {	}
 
 
-	void reset::complete (std::exception_ptr ex) {
-
-		if (ex) set_exception(promise_,std::move(ex));
-		else promise_.set_value();
-
-	}
-
-
-	reset::operation_status reset::begin (native_handle_type handle) {
+	basic_reset::operation_status basic_reset::begin (native_handle_type handle) {
 
 		if (PQresetStart(handle)==0) throw connection_error(handle);
 
@@ -38,7 +30,7 @@ namespace asiopq {
 	}
 
 
-	reset::operation_status reset::perform (native_handle_type handle, socket_status) {
+	basic_reset::operation_status basic_reset::perform (native_handle_type handle, socket_status) {
 
 		switch (PQresetPoll(handle)) {
 
@@ -56,13 +48,24 @@ namespace asiopq {
 	}
 
 
-	reset::timeout_type reset::timeout () {
+	basic_reset::timeout_type basic_reset::timeout () {
 
 		return timeout_;
 
 	}
 
 
+	reset::reset (timeout_type timeout) : basic_reset(timeout) {	}
+
+
+	void reset::complete (std::exception_ptr ex) {
+
+		if (ex) set_exception(promise_,std::move(ex));
+		else promise_.set_value();
+
+	}
+
+
 	future<void> reset::get_future () {
 
 		return promise_.get_future();
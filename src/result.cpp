@@ -0,0 +1,111 @@
+#include <asiopq/exception.hpp>
+#include <asiopq/result.hpp>
+#include <libpq-fe.h>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+
+namespace asiopq {
+
+
+	void result::check (int row, int column) const {
+
+		if ((row<0) || (row>=rows())) throw std::out_of_range("Row out of range");
+		if ((column<0) || (column>=columns())) throw std::out_of_range("Column out of range");
+
+	}
+
+
+	void result::check (int column, bool (*accepts) (Oid) noexcept) const {
+
+		if ((column<0) || (column>=columns())) throw std::out_of_range("Column out of range");
+
+		if (PQfformat(handle_,column)!=1) {
+
+			std::ostringstream ss;
+			ss << "Column \"" << PQfname(handle_,column) << "\" is not in binary format";
+			throw decode_error(ss.str());
+
+		}
+
+		auto oid=PQftype(handle_,column);
+		if (!accepts(oid)) {
+
+			std::ostringstream ss;
+			ss << "Column \"" << PQfname(handle_,column) << "\" has type " << oid << " which cannot be decoded as requested";
+			throw decode_error(ss.str());
+
+		}
+
+	}
+
+
+	result::result (native_result_type handle) noexcept : handle_(handle) {	}
+
+
+	result::result (result && rhs) noexcept : handle_(rhs.handle_) {
+
+		rhs.handle_=nullptr;
+
+	}
+
+
+	result & result::operator = (result && rhs) noexcept {
+
+		using std::swap;
+		swap(handle_,rhs.handle_);
+
+		return *this;
+
+	}
+
+
+	result::~result () noexcept {
+
+		if (handle_) PQclear(handle_);
+
+	}
+
+
+	int result::rows () const noexcept {
+
+		return PQntuples(handle_);
+
+	}
+
+
+	int result::columns () const noexcept {
+
+		return PQnfields(handle_);
+
+	}
+
+
+	bool result::null (int row, int column) const {
+
+		check(row,column);
+
+		return PQgetisnull(handle_,row,column)!=0;
+
+	}
+
+
+	result::native_result_type result::native_handle () const noexcept {
+
+		return handle_;
+
+	}
+
+
+	result::native_result_type result::release () noexcept {
+
+		auto retr=handle_;
+		handle_=nullptr;
+
+		return retr;
+
+	}
+
+
+}
@@ -0,0 +1,156 @@
+#include <asiopq/statement_cache.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace asiopq {
+
+
+	void statement_cache::evict () {
+
+		while (lru_.size()>capacity_) {
+
+			//	A statement whose preparation was issued may exist
+			//	on the server even if it isn't known to have been
+			//	prepared (e.g. because preparing it timed out)
+			auto & e=lru_.back();
+			if (e.prepared) --prepared_;
+			if (!e.name.empty()) garbage_.push_back(std::move(e.name));
+			map_.erase(e.sql);
+			lru_.pop_back();
+
+		}
+
+	}
+
+
+	statement_cache::statement_cache (std::size_t capacity, std::size_t threshold) : next_(0), prepared_(0) {
+
+		configure(capacity,threshold);
+
+	}
+
+
+	void statement_cache::configure (std::size_t capacity, std::size_t threshold) {
+
+		capacity_=capacity;
+		threshold_=std::max<std::size_t>(threshold,1);
+
+		evict();
+
+	}
+
+
+	bool statement_cache::ready (const std::string & sql) const {
+
+		if (capacity_==0) return true;
+
+		auto iter=map_.find(sql);
+		if (iter==map_.end()) return threshold_>1;
+
+		auto & e=*iter->second;
+
+		return e.prepared || ((e.uses+1)<threshold_);
+
+	}
+
+
+	statement_cache::usage statement_cache::use (const std::string & sql) {
+
+		if (capacity_==0) return usage{nullptr,false};
+
+		auto iter=map_.find(sql);
+		if (iter==map_.end()) {
+
+			lru_.push_front(entry{sql,std::string{},0,false});
+			try {
+
+				map_.emplace(sql,lru_.begin());
+
+			} catch (...) {
+
+				lru_.pop_front();
+				throw;
+
+			}
+			evict();
+
+		} else {
+
+			lru_.splice(lru_.begin(),lru_,iter->second);
+
+		}
+
+		auto & e=lru_.front();
+		if (e.prepared) return usage{&e.name,false};
+
+		if (++e.uses<threshold_) return usage{nullptr,false};
+
+		//	A fresh name each time so that a statement whose
+		//	preparation was abandoned (e.g. because it timed
+		//	out) can never collide with this one, though that
+		//	statement may nonetheless exist and so must be
+		//	deallocated
+		auto name="asiopq_"+std::to_string(next_++);
+		if (!e.name.empty()) garbage_.push_back(std::move(e.name));
+		e.name=std::move(name);
+
+		return usage{&e.name,true};
+
+	}
+
+
+	void statement_cache::prepared (const std::string & sql) {
+
+		auto iter=map_.find(sql);
+		if ((iter==map_.end()) || iter->second->prepared) return;
+
+		iter->second->prepared=true;
+		++prepared_;
+
+	}
+
+
+	void statement_cache::erase (const std::string & sql) {
+
+		auto iter=map_.find(sql);
+		if (iter==map_.end()) return;
+
+		if (iter->second->prepared) --prepared_;
+		lru_.erase(iter->second);
+		map_.erase(iter);
+
+	}
+
+
+	std::vector<std::string> statement_cache::collect () {
+
+		auto retr=std::move(garbage_);
+		garbage_.clear();
+
+		return retr;
+
+	}
+
+
+	void statement_cache::clear () noexcept {
+
+		lru_.clear();
+		map_.clear();
+		garbage_.clear();
+		prepared_=0;
+
+	}
+
+
+	std::size_t statement_cache::size () const noexcept {
+
+		return prepared_;
+
+	}
+
+
+}
@@ -0,0 +1,129 @@
+#include <asiopq/errc.hpp>
+#include <asiopq/exception.hpp>
+#include <asiopq/scope.hpp>
+#include <asiopq/streaming_query.hpp>
+#include <libpq-fe.h>
+#include <stdexcept>
+
+
+namespace asiopq {
+
+
+	void streaming_query::deliver () {
+
+		if (batch_.empty()) return;
+
+		auto g=make_scope_exit([&] () noexcept {
+
+			for (auto && res : batch_) PQclear(res);
+			batch_.clear();
+			count_=0;
+
+		});
+
+		if (!consume(batch_)) full_=true;
+
+	}
+
+
+	streaming_query::streaming_query (int rows, timeout_type timeout) : query(timeout), rows_(rows), count_(0), full_(false) {
+
+		if (rows_<=0) throw std::logic_error("Batches must contain at least one row");
+
+		#ifndef LIBPQ_HAS_CHUNK_MODE
+		//	Each result contains exactly one row in
+		//	single-row mode
+		batch_.reserve(static_cast<batch_type::size_type>(rows_));
+		#endif
+
+	}
+
+
+	void streaming_query::send (native_handle_type handle) {
+
+		start(handle);
+
+		//	The query has already been sent so its results are
+		//	still retrieved (whole) before the operation fails
+		#ifdef LIBPQ_HAS_CHUNK_MODE
+		if (PQsetChunkedRowsMode(handle,rows_)==0) set_error(errc::connection_failed);
+		#else
+		if (PQsetSingleRowMode(handle)==0) set_error(errc::connection_failed);
+		#endif
+
+	}
+
+
+	void streaming_query::result (native_result_type result) {
+
+		auto g=make_scope_exit([&] () noexcept {	PQclear(result);	});
+
+		switch (PQresultStatus(result)) {
+
+			case PGRES_SINGLE_TUPLE:
+			#ifdef LIBPQ_HAS_CHUNK_MODE
+			case PGRES_TUPLES_CHUNK:
+			#endif
+				batch_.push_back(result);
+				g.release();
+				count_+=PQntuples(result);
+				if (count_>=rows_) deliver();
+				return;
+			//	The end of a result set
+			case PGRES_TUPLES_OK:
+			case PGRES_COMMAND_OK:
+				deliver();
+				return;
+			default:
+				break;
+
+		}
+
+		deliver();
+
+		throw result_error(result);
+
+	}
+
+
+	streaming_query::operation_status streaming_query::perform (native_handle_type handle, socket_status status) {
+
+		//	Still sending the query
+		if (!flushed()) return query::perform(handle,status);
+
+		//	If this query was suspended it is only performed
+		//	again once resumed
+		full_=false;
+
+		if ((status==socket_status::readable) && (PQconsumeInput(handle)==0)) {
+
+			set_error(errc::connection_failed);
+
+			return operation_status::done;
+
+		}
+
+		while (PQisBusy(handle)==0) {
+
+			auto res=PQgetResult(handle);
+			if (!res) {
+
+				deliver();
+				return operation_status::done;
+
+			}
+
+			result(res);
+
+			//	Stop retrieving results (and reading the socket)
+			//	until the consumer catches up
+			if (full_) return operation_status::suspend;
+
+		}
+
+		return operation_status::read;
+
+	}
+
+
+}
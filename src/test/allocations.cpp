@@ -0,0 +1,110 @@
+#include "allocations.hpp"
+
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+
+namespace {
+
+
+	std::atomic<std::size_t> count(0);
+
+
+	void * allocate (std::size_t size) noexcept {
+
+		count.fetch_add(1,std::memory_order_relaxed);
+		return std::malloc(size ? size : 1);
+
+	}
+
+
+}
+
+
+std::size_t allocations () noexcept {
+
+	return count.load(std::memory_order_relaxed);
+
+}
+
+
+//	Every unaligned form of operator new and operator delete is
+//	replaced so that memory is always released by the allocator
+//	which obtained it
+
+
+void * operator new (std::size_t size) {
+
+	if (auto ptr=allocate(size)) return ptr;
+
+	throw std::bad_alloc{};
+
+}
+
+
+void * operator new[] (std::size_t size) {
+
+	if (auto ptr=allocate(size)) return ptr;
+
+	throw std::bad_alloc{};
+
+}
+
+
+void * operator new (std::size_t size, const std::nothrow_t &) noexcept {
+
+	return allocate(size);
+
+}
+
+
+void * operator new[] (std::size_t size, const std::nothrow_t &) noexcept {
+
+	return allocate(size);
+
+}
+
+
+void operator delete (void * ptr) noexcept {
+
+	std::free(ptr);
+
+}
+
+
+void operator delete[] (void * ptr) noexcept {
+
+	std::free(ptr);
+
+}
+
+
+void operator delete (void * ptr, std::size_t) noexcept {
+
+	std::free(ptr);
+
+}
+
+
+void operator delete[] (void * ptr, std::size_t) noexcept {
+
+	std::free(ptr);
+
+}
+
+
+void operator delete (void * ptr, const std::nothrow_t &) noexcept {
+
+	std::free(ptr);
+
+}
+
+
+void operator delete[] (void * ptr, const std::nothrow_t &) noexcept {
+
+	std::free(ptr);
+
+}
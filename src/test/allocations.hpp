@@ -0,0 +1,15 @@
+#pragma once
+
+
+#include <cstddef>
+
+
+/**
+ *	Retrieves the number of allocations which have been made
+ *	through the global operator new, which the tests replace,
+ *	so that tests may check that a path makes none.
+ *
+ *	\return
+ *		A count of allocations.
+ */
+std::size_t allocations () noexcept;
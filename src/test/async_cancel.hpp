@@ -0,0 +1,43 @@
+/**
+ *	\file
+ *
+ *	Included ahead of a translation unit so that, where the
+ *	installed libpq predates PostgreSQL 17, the non-blocking
+ *	cancel API is declared and the code which uses it may be
+ *	compiled (though not linked).
+ */
+
+
+#pragma once
+
+
+#include <libpq-fe.h>
+
+
+#ifndef LIBPQ_HAS_ASYNC_CANCEL
+
+
+#define LIBPQ_HAS_ASYNC_CANCEL 1
+
+
+extern "C" {
+
+
+typedef struct pg_cancel_conn PGcancelConn;
+
+
+PGcancelConn * PQcancelCreate (PGconn *);
+int PQcancelStart (PGcancelConn *);
+int PQcancelBlocking (PGcancelConn *);
+PostgresPollingStatusType PQcancelPoll (PGcancelConn *);
+ConnStatusType PQcancelStatus (const PGcancelConn *);
+int PQcancelSocket (const PGcancelConn *);
+char * PQcancelErrorMessage (const PGcancelConn *);
+void PQcancelReset (PGcancelConn *);
+void PQcancelFinish (PGcancelConn *);
+
+
+}
+
+
+#endif
@@ -0,0 +1,242 @@
+#include <asiopq/connection.hpp>
+
+
+#include "allocations.hpp"
+#include "server.hpp"
+#include <asiopq/asio.hpp>
+#include <asiopq/connect.hpp>
+#include <asiopq/exception.hpp>
+#include <asiopq/query.hpp>
+#include <asiopq/scope.hpp>
+#include <libpq-fe.h>
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <string>
+#include <vector>
+#include <catch.hpp>
+
+
+#ifndef _WIN32
+
+
+namespace {
+
+
+	class connect_op : public asiopq::basic_connect {
+
+
+		public:
+
+
+			using asiopq::basic_connect::basic_connect;
+
+
+			bool done=false;
+			std::exception_ptr ex;
+			std::vector<int> sockets;
+
+
+			virtual operation_status begin (native_handle_type handle) override {
+
+				auto retr=asiopq::basic_connect::begin(handle);
+				sockets.push_back(PQsocket(handle));
+
+				return retr;
+
+			}
+
+
+			virtual operation_status perform (native_handle_type handle, socket_status status) override {
+
+				auto retr=asiopq::basic_connect::perform(handle,status);
+				sockets.push_back(PQsocket(handle));
+
+				return retr;
+
+			}
+
+
+			virtual void complete (std::exception_ptr ex) override {
+
+				done=true;
+				this->ex=std::move(ex);
+
+			}
+
+
+	};
+
+
+	class command : public asiopq::query {
+
+
+		private:
+
+
+			std::size_t & completed_;
+			std::exception_ptr & ex_;
+
+
+		public:
+
+
+			command (timeout_type timeout, std::size_t & completed, std::exception_ptr & ex) noexcept
+				:	asiopq::query(timeout),
+					completed_(completed),
+					ex_(ex)
+			{	}
+
+
+			virtual void send (native_handle_type handle) override {
+
+				if (PQsendQuery(handle,"SET application_name TO 'asiopq'")==0) throw asiopq::connection_error(handle);
+
+			}
+
+
+			virtual void result (native_result_type result) override {
+
+				auto g=asiopq::make_scope_exit([&] () noexcept {	PQclear(result);	});
+				if (PQresultStatus(result)!=PGRES_COMMAND_OK) throw asiopq::result_error(result);
+
+			}
+
+
+			virtual void complete (std::exception_ptr ex) override {
+
+				if (ex && !ex_) ex_=std::move(ex);
+				++completed_;
+
+			}
+
+
+	};
+
+
+	bool timed_out (const std::exception_ptr & ex) {
+
+		try {
+
+			std::rethrow_exception(ex);
+
+		} catch (const asiopq::timed_out &) {
+
+			return true;
+
+		} catch (...) {	}
+
+		return false;
+
+	}
+
+
+}
+
+
+SCENARIO("asiopq::connection objects wait on the new socket when libpq reuses the descriptor of the old","[asiopq][connection][unix]") {
+
+	GIVEN("A read only server listening on a Unix domain socket") {
+
+		asiopq::asio::io_service ios;
+		fake_server server(ios,true);
+
+		WHEN("A read-write connection is attempted to that server as two hosts") {
+
+			//	Having rejected the first host libpq closes its
+			//	socket and opens another for the second, which
+			//	receives the same descriptor and an identical
+			//	(unnamed) local address
+			auto host=server.dir();
+			auto info="host="+host+","+host+" port="+server.port+","+server.port+" sslmode=disable gssencmode=disable target_session_attrs=read-write";
+			auto c=std::make_shared<connect_op>(info.c_str(),std::chrono::milliseconds(5000));
+			auto conn=c->connection(ios);
+			while (!c->done) ios.run_one();
+
+			THEN("Both hosts are tried on the same descriptor") {
+
+				CHECK(server.accepted()==2U);
+				REQUIRE_FALSE(c->sockets.empty());
+				auto s=c->sockets.front();
+				CHECK(s!=-1);
+				CHECK(std::all_of(c->sockets.begin(),c->sockets.end(),[&] (int socket) noexcept {	return (socket==s) || (socket==-1);	}));
+
+			}
+
+			THEN("The attempt fails rather than timing out") {
+
+				REQUIRE(c->ex);
+				CHECK_FALSE(timed_out(c->ex));
+
+			}
+
+		}
+
+	}
+
+}
+
+
+SCENARIO("asiopq::connection objects run operations without allocating once running","[asiopq][connection][unix][allocation]") {
+
+	GIVEN("An asiopq::connection which has already run operations with and without timeouts") {
+
+		asiopq::asio::io_service ios;
+		fake_server server(ios,false);
+		auto info=server.conninfo();
+		auto c=std::make_shared<connect_op>(info.c_str(),std::chrono::milliseconds(5000));
+		auto conn=c->connection(ios);
+		while (!c->done) ios.run_one();
+		REQUIRE_FALSE(c->ex);
+
+		//	Waking the connection, waiting on its socket, and
+		//	scheduling and cancelling timeouts on the shared
+		//	timer wheel all happen on every round trip
+		const std::size_t n=100;
+		std::size_t completed=0;
+		std::exception_ptr ex;
+		std::vector<std::shared_ptr<command>> commands;
+		for (std::size_t i=0;i<(2*n);++i) {
+
+			auto timeout=((i%2)==0) ? asiopq::operation::timeout_type{} : asiopq::operation::timeout_type(std::chrono::milliseconds(5000));
+			commands.push_back(std::make_shared<command>(timeout,completed,ex));
+
+		}
+		auto run=[&] (std::size_t begin, std::size_t end) {
+
+			for (auto i=begin;i<end;++i) {
+
+				auto before=completed;
+				conn.add(commands[i]);
+				while (completed==before) ios.run_one();
+
+			}
+
+		};
+		run(0,n);
+		REQUIRE_FALSE(ex);
+
+		WHEN("More operations are run one after another") {
+
+			auto before=allocations();
+			run(n,2*n);
+			auto after=allocations();
+
+			THEN("They succeed and nothing is allocated") {
+
+				CHECK_FALSE(ex);
+				CHECK(completed==(2*n));
+				CHECK(after==before);
+
+			}
+
+		}
+
+	}
+
+}
+
+
+#endif
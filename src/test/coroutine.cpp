@@ -0,0 +1,241 @@
+#include <asiopq/coroutine.hpp>
+
+
+#include "server.hpp"
+#include <asiopq/asio.hpp>
+#include <asiopq/connection.hpp>
+#include <asiopq/exception.hpp>
+#include <asiopq/scope.hpp>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <catch.hpp>
+
+
+namespace {
+
+
+	//	Records the destruction of the coroutine frame which
+	//	owns it
+	class sentinel {
+
+
+		private:
+
+
+			bool * destroyed_;
+
+
+		public:
+
+
+			sentinel (const sentinel &) = delete;
+			sentinel & operator = (const sentinel &) = delete;
+			sentinel & operator = (sentinel &&) = delete;
+
+
+			explicit sentinel (bool & destroyed) noexcept : destroyed_(&destroyed) {	}
+			sentinel (sentinel && rhs) noexcept : destroyed_(std::exchange(rhs.destroyed_,nullptr)) {	}
+
+
+			~sentinel () noexcept {
+
+				if (destroyed_) *destroyed_=true;
+
+			}
+
+
+	};
+
+
+	asiopq::task<int> answer () {
+
+		co_return 42;
+
+	}
+
+
+	asiopq::task<int> twice () {
+
+		co_return 2*(co_await answer());
+
+	}
+
+
+	asiopq::task<int> fail () {
+
+		throw std::runtime_error("Failed");
+		co_return 0;
+
+	}
+
+
+	asiopq::task<> store (int & out) {
+
+		out=co_await twice();
+
+	}
+
+
+	asiopq::task<> catch_failure (bool & caught) {
+
+		try {
+
+			co_await fail();
+
+		} catch (const std::runtime_error &) {
+
+			caught=true;
+
+		}
+
+	}
+
+
+	asiopq::task<> propagate_failure () {
+
+		co_await fail();
+
+	}
+
+
+	asiopq::task<> hold (sentinel) {
+
+		co_return;
+
+	}
+
+
+	#ifndef _WIN32
+
+
+	asiopq::task<> connect_and_query (asiopq::asio::io_service & ios, std::string conninfo, bool & connected, bool & timed_out, bool & done) {
+
+		auto g=asiopq::make_scope_exit([&] () noexcept {	done=true;	});
+
+		auto conn=co_await asiopq::async_connect(conninfo.c_str(),ios,std::chrono::milliseconds(5000));
+		connected=true;
+
+		try {
+
+			co_await asiopq::async_query(conn,std::chrono::milliseconds(100),"SELECT $1::integer",1);
+
+		} catch (const asiopq::timed_out &) {
+
+			timed_out=true;
+
+		}
+
+	}
+
+
+	#endif
+
+
+}
+
+
+SCENARIO("asiopq::task objects may be awaited and spawned","[asiopq][coroutine]") {
+
+	GIVEN("An asio::io_service") {
+
+		asiopq::asio::io_service ios;
+
+		WHEN("A task which awaits tasks in turn is spawned and the asio::io_service is run") {
+
+			int result=0;
+			asiopq::spawn(ios,store(result));
+			ios.run();
+
+			THEN("It receives the result of the tasks it awaited") {
+
+				CHECK(result==84);
+
+			}
+
+		}
+
+		WHEN("A task which awaits a task which throws is spawned and the asio::io_service is run") {
+
+			bool caught=false;
+			asiopq::spawn(ios,catch_failure(caught));
+			ios.run();
+
+			THEN("The exception is thrown from co_await") {
+
+				CHECK(caught);
+
+			}
+
+		}
+
+		WHEN("A task which throws is spawned") {
+
+			asiopq::spawn(ios,propagate_failure());
+
+			THEN("The exception is thrown from asio::io_service::run") {
+
+				CHECK_THROWS_AS(ios.run(),std::runtime_error);
+
+			}
+
+		}
+
+	}
+
+	GIVEN("A task spawned on an asio::io_service which is never run") {
+
+		bool destroyed=false;
+		{
+
+			asiopq::asio::io_service ios;
+			asiopq::spawn(ios,hold(sentinel(destroyed)));
+			REQUIRE_FALSE(destroyed);
+
+		}
+
+		THEN("The task is destroyed with the asio::io_service") {
+
+			CHECK(destroyed);
+
+		}
+
+	}
+
+}
+
+
+#ifndef _WIN32
+
+
+SCENARIO("Coroutines may await asiopq operations","[asiopq][coroutine][unix]") {
+
+	GIVEN("A server which never answers queries") {
+
+		asiopq::asio::io_service ios;
+		fake_server server(ios,false);
+
+		WHEN("A coroutine connects to it and awaits a query which times out") {
+
+			bool connected=false;
+			bool timed_out=false;
+			bool done=false;
+			asiopq::spawn(ios,connect_and_query(ios,server.conninfo(),connected,timed_out,done));
+			while (!done) ios.run_one();
+
+			THEN("The connection is established and the timeout is thrown from co_await") {
+
+				CHECK(connected);
+				CHECK(timed_out);
+
+			}
+
+		}
+
+	}
+
+}
+
+
+#endif
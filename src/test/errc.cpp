@@ -0,0 +1,189 @@
+#include <asiopq/errc.hpp>
+
+
+#include <asiopq/exception.hpp>
+#include <asiopq/operation.hpp>
+#include <chrono>
+#include <exception>
+#include <string>
+#include <system_error>
+#include <catch.hpp>
+
+
+namespace {
+
+
+	class operation : public asiopq::operation {
+
+
+		public:
+
+
+			std::exception_ptr ex;
+			timeout_type ms;
+
+
+			using asiopq::operation::complete;
+
+
+			virtual void complete (std::exception_ptr ex) override {
+
+				this->ex=ex;
+
+			}
+
+
+			virtual operation_status begin (native_handle_type) override {
+
+				return operation_status::done;
+
+			}
+
+
+			virtual operation_status perform (native_handle_type, socket_status) override {
+
+				return operation_status::done;
+
+			}
+
+
+			virtual timeout_type timeout () override {
+
+				return ms;
+
+			}
+
+
+	};
+
+
+}
+
+
+SCENARIO("asiopq::errc values are std::error_code values equivalent to the corresponding std::errc values","[asiopq][errc]") {
+
+	GIVEN("A std::error_code created from asiopq::errc::timed_out") {
+
+		std::error_code ec(asiopq::errc::timed_out);
+
+		THEN("It is an error of the asiopq category") {
+
+			CHECK(ec);
+			CHECK(&ec.category()==&asiopq::error_category());
+			CHECK(std::string(ec.category().name())=="asiopq");
+			CHECK(ec==asiopq::errc::timed_out);
+			CHECK(ec!=asiopq::errc::aborted);
+			CHECK_FALSE(ec.message().empty());
+
+		}
+
+		THEN("It is equivalent to std::errc::timed_out") {
+
+			CHECK(ec==std::errc::timed_out);
+			CHECK(ec!=std::errc::operation_canceled);
+
+		}
+
+	}
+
+	GIVEN("std::error_code objects created from the other asiopq::errc values") {
+
+		THEN("They are equivalent to the corresponding std::errc values") {
+
+			CHECK(std::error_code(asiopq::errc::aborted)==std::errc::operation_canceled);
+			CHECK(std::error_code(asiopq::errc::queue_full)==std::errc::resource_unavailable_try_again);
+			CHECK(std::error_code(asiopq::errc::connection_failed)==std::errc::io_error);
+
+		}
+
+	}
+
+}
+
+
+SCENARIO("Operations which do not handle std::error_code values receive the corresponding exceptions","[asiopq][errc]") {
+
+	GIVEN("An asiopq::operation which handles only exceptions") {
+
+		operation op;
+		op.ms=std::chrono::milliseconds(5);
+
+		WHEN("It completes with asiopq::errc::aborted") {
+
+			op.complete(asiopq::errc::aborted,std::string());
+
+			THEN("It receives asiopq::aborted") {
+
+				REQUIRE(op.ex);
+				CHECK_THROWS_AS(std::rethrow_exception(op.ex),asiopq::aborted);
+
+			}
+
+		}
+
+		WHEN("It completes with asiopq::errc::timed_out") {
+
+			op.complete(asiopq::errc::timed_out,std::string());
+
+			THEN("It receives asiopq::timed_out carrying its timeout") {
+
+				REQUIRE(op.ex);
+				try {
+
+					std::rethrow_exception(op.ex);
+
+				} catch (const asiopq::timed_out & ex) {
+
+					CHECK(ex.timeout()==std::chrono::milliseconds(5));
+
+				}
+
+			}
+
+		}
+
+		WHEN("It completes with asiopq::errc::connection_failed") {
+
+			op.complete(asiopq::errc::connection_failed,"server closed the connection unexpectedly");
+
+			THEN("It receives asiopq::connection_error carrying the message") {
+
+				REQUIRE(op.ex);
+				try {
+
+					std::rethrow_exception(op.ex);
+
+				} catch (const asiopq::connection_error & ex) {
+
+					CHECK(std::string(ex.what())=="server closed the connection unexpectedly");
+
+				}
+
+			}
+
+		}
+
+		WHEN("It completes with an error of another category") {
+
+			op.complete(std::make_error_code(std::errc::broken_pipe),std::string());
+
+			THEN("It receives std::system_error carrying the error") {
+
+				REQUIRE(op.ex);
+				try {
+
+					std::rethrow_exception(op.ex);
+
+				} catch (const std::system_error & ex) {
+
+					CHECK(ex.code()==std::errc::broken_pipe);
+
+				}
+
+			}
+
+		}
+
+	}
+
+}
@@ -0,0 +1,78 @@
+#include <asiopq/handler_allocator.hpp>
+
+
+#include <asiopq/asio.hpp>
+#include <cstddef>
+#include <vector>
+#include <catch.hpp>
+
+
+SCENARIO("asiopq::handler_arena objects recycle a small number of blocks","[asiopq][handler_allocator]") {
+
+	GIVEN("An asiopq::handler_arena") {
+
+		asiopq::handler_arena arena;
+
+		THEN("No blocks are in use") {
+
+			CHECK(arena.used()==0);
+
+		}
+
+		WHEN("A block is allocated, deallocated, and allocated again") {
+
+			auto a=arena.allocate(64,alignof(std::max_align_t));
+			auto used=arena.used();
+			arena.deallocate(a);
+			auto b=arena.allocate(64,alignof(std::max_align_t));
+
+			THEN("The same memory is reused") {
+
+				CHECK(used==1);
+				CHECK(a==b);
+				arena.deallocate(b);
+				CHECK(arena.used()==0);
+
+			}
+
+		}
+
+		WHEN("More blocks are allocated than there are and an allocation is too large") {
+
+			std::vector<void *> ptrs;
+			for (std::size_t i=0;i<(asiopq::handler_arena::blocks+1);++i) ptrs.push_back(arena.allocate(8,alignof(std::max_align_t)));
+			auto large=arena.allocate(asiopq::handler_arena::size+1,alignof(std::max_align_t));
+
+			THEN("The excess are satisfied from the heap and may be deallocated") {
+
+				CHECK(arena.used()==asiopq::handler_arena::blocks);
+				for (auto ptr : ptrs) arena.deallocate(ptr);
+				arena.deallocate(large);
+				CHECK(arena.used()==0);
+
+			}
+
+		}
+
+		WHEN("A handler bound to it is posted to an asio::io_service") {
+
+			asiopq::asio::io_service ios;
+			bool invoked=false;
+			std::size_t used=0;
+			asiopq::asio::post(ios,asiopq::bind_arena(arena,[&] () {	invoked=true;	}));
+			used=arena.used();
+			ios.run();
+
+			THEN("The operation is allocated from the arena and released before the handler is invoked") {
+
+				CHECK(used==1);
+				CHECK(invoked);
+				CHECK(arena.used()==0);
+
+			}
+
+		}
+
+	}
+
+}
@@ -1,11 +1,20 @@
 #include <asiopq/asio.hpp>
+#include <asiopq/async.hpp>
 #include <asiopq/connect.hpp>
+#include <asiopq/copy_in.hpp>
+#include <asiopq/copy_out.hpp>
+#include <asiopq/errc.hpp>
 #include <asiopq/exception.hpp>
 #include <asiopq/future.hpp>
+#include <asiopq/pool.hpp>
+#include <asiopq/prepared_query.hpp>
 #include <asiopq/query.hpp>
 #include <asiopq/reset.hpp>
+#include <asiopq/static_query.hpp>
+#include <asiopq/streaming_query.hpp>
 
 
+#include "allocations.hpp"
 #include "login.hpp"
 
 
@@ -13,12 +22,17 @@
 #include <asiopq/scope.hpp>
 #include <libpq-fe.h>
 #include <chrono>
+#include <cstddef>
 #include <exception>
+#include <functional>
+#include <future>
 #include <memory>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <system_error>
 #include <utility>
+#include <vector>
 #include <catch.hpp>
 
 
@@ -89,6 +103,147 @@ namespace {
 	};
 
 
+	class command_query : public no_result_query {
+
+
+		private:
+
+
+			const char * sql_;
+
+
+		public:
+
+
+			command_query (const char * sql, timeout_type timeout=timeout_type{}) : no_result_query(timeout), sql_(sql) {	}
+
+
+			virtual void send (native_handle_type handle) override {
+
+				if (PQsendQuery(handle,sql_)==0) throw asiopq::connection_error(handle);
+
+			}
+
+
+	};
+
+
+	class callback_query : public asiopq::query {
+
+
+		public:
+
+
+			using callback_type=std::function<void (std::exception_ptr)>;
+
+
+		private:
+
+
+			const char * sql_;
+			callback_type callback_;
+
+
+		public:
+
+
+			callback_query (const char * sql, timeout_type timeout, callback_type callback) : asiopq::query(timeout), sql_(sql), callback_(std::move(callback)) {	}
+
+
+			virtual void send (native_handle_type handle) override {
+
+				if (PQsendQuery(handle,sql_)==0) throw asiopq::connection_error(handle);
+
+			}
+
+
+			virtual void result (native_result_type result) override {
+
+				auto g=asiopq::make_scope_exit([&] () noexcept {	PQclear(result);	});
+				if (PQresultStatus(result)!=PGRES_COMMAND_OK) throw asiopq::result_error(result);
+
+			}
+
+
+			virtual void complete (std::exception_ptr ex) override {
+
+				callback_(std::move(ex));
+
+			}
+
+
+	};
+
+
+	//	Fails as it is enqueued
+	class throwing_timeout_query : public callback_query {
+
+
+		public:
+
+
+			using callback_query::callback_query;
+
+
+			virtual timeout_type timeout () override {
+
+				throw std::runtime_error("timeout");
+
+			}
+
+
+	};
+
+
+	//	As callback_query but dispatched statically
+	class static_callback_query final : public asiopq::static_query<static_callback_query> {
+
+
+		public:
+
+
+			using callback_type=std::function<void (std::exception_ptr)>;
+
+
+		private:
+
+
+			const char * sql_;
+			callback_type callback_;
+
+
+		public:
+
+
+			static_callback_query (const char * sql, timeout_type timeout, callback_type callback) : asiopq::static_query<static_callback_query>(timeout), sql_(sql), callback_(std::move(callback)) {	}
+
+
+			void do_send (native_handle_type handle) {
+
+				if (PQsendQuery(handle,sql_)==0) throw asiopq::connection_error(handle);
+
+			}
+
+
+			void do_result (native_result_type result) {
+
+				auto g=asiopq::make_scope_exit([&] () noexcept {	PQclear(result);	});
+				auto status=PQresultStatus(result);
+				if ((status!=PGRES_COMMAND_OK) && (status!=PGRES_TUPLES_OK)) throw asiopq::result_error(result);
+
+			}
+
+
+			virtual void complete (std::exception_ptr ex) override {
+
+				callback_(std::move(ex));
+
+			}
+
+
+	};
+
+
 	class insert_query : public no_result_query {
 
 
@@ -199,20 +354,33 @@ namespace {
 	};
 
 
-	class min_query : public integer_query {
+	class select_query : public integer_query {
+
+
+		private:
+
+
+			const char * sql_;
 
 
 		public:
 
 
-			using integer_query::integer_query;
+			select_query (const char * sql, timeout_type timeout=timeout_type{}) : integer_query(timeout), sql_(sql) {	}
 
 
 			virtual void send (native_handle_type handle) override {
 
-				if (PQsendQuery(
+				//	PQsendQuery may not be used in pipeline mode
+				if (PQsendQueryParams(
 					handle,
-					"SELECT MIN(\"foo\") FROM \"test\";"
+					sql_,
+					0,
+					nullptr,
+					nullptr,
+					nullptr,
+					nullptr,
+					0
 				)==0) throw asiopq::connection_error(handle);
 
 			}
@@ -221,14 +389,8 @@ namespace {
 	};
 
 
-}
-
-
-SCENARIO("ASIO PQ features may be used to connect to a PostgreSQL database, reset that connection, and submit queries","[asiopq][integration][connect][connection][query][reset]") {
-
-	GIVEN("An asiopq::connect object representing a connection attempt to a PostgreSQL server") {
+	std::shared_ptr<asiopq::connect> make_connect (std::chrono::milliseconds timeout) {
 
-		asiopq::asio::io_service ios;
 		const char * keywords []={
 			"hostaddr",
 			"port",
@@ -245,160 +407,523 @@ SCENARIO("ASIO PQ features may be used to connect to a PostgreSQL database, rese
 			ASIOPQ_PASSWORD,
 			nullptr
 		};
-		std::chrono::milliseconds timeout(1000);
-		auto connect=std::make_shared<asiopq::connect>(keywords,values,0,timeout);
-		auto connection=connect->connection(ios);
 
-		WHEN("That connection attempt is run on an asiopq::connection") {
+		return std::make_shared<asiopq::connect>(keywords,values,0,timeout);
 
-			ios.run();
-			
-			THEN("The connection completes successfully") {
+	}
 
-				CHECK_NOTHROW(connect->get_future().get());
 
-				GIVEN("An asiopq::reset object") {
+	template <typename Future>
+	void run_until_ready (asiopq::asio::io_service & ios, Future & future) {
 
-					auto reset=std::make_shared<asiopq::reset>(timeout);
+		#ifdef ASIOPQ_USE_BOOST_FUTURE
+		while (!future.is_ready()) ios.run_one();
+		#else
+		while (future.wait_for(std::chrono::seconds(0))!=std::future_status::ready) ios.run_one();
+		#endif
 
-					WHEN("That reset attempt is run on the connected asiopq::connection") {
+	}
 
-						connection.add(reset);
-						ios.reset();
-						ios.run();
 
-						THEN("The reset completes successfully") {
+	class series_query : public asiopq::streaming_query {
 
-							CHECK_NOTHROW(reset->get_future().get());
 
-							GIVEN("Several queries represented by objects which derive from asiopq::query") {
+		private:
 
-								auto create=std::make_shared<create_query>(timeout);
-								auto insert_1=std::make_shared<insert_query>(1,timeout);
-								auto insert_2=std::make_shared<insert_query>(2,timeout);
-								auto count=std::make_shared<count_query>(timeout);
-								auto min=std::make_shared<min_query>(timeout);
 
-								WHEN("They are run on the asiopq::connection") {
+			asiopq::promise<void> promise_;
 
-									connection.add(create);
-									connection.add(insert_1);
-									connection.add(insert_2);
-									connection.add(count);
-									connection.add(min);
-									ios.reset();
-									ios.run();
 
-									THEN("They all complete successfully") {
+		public:
 
-										CHECK_NOTHROW(create->get_future().get());
-										CHECK_NOTHROW(insert_1->get_future().get());
-										CHECK_NOTHROW(insert_2->get_future().get());
-										CHECK(count->get_future().get()==2);
-										CHECK(min->get_future().get()==1);
 
-									}
+			using asiopq::streaming_query::streaming_query;
 
-								}
 
-							}
+			int rows=0;
+			long long sum=0;
+			int batches=0;
 
-						}
 
-					}
+			virtual void start (native_handle_type handle) override {
 
-				}
+				if (PQsendQueryParams(
+					handle,
+					"SELECT generate_series(1,1000);",
+					0,
+					nullptr,
+					nullptr,
+					nullptr,
+					nullptr,
+					0
+				)==0) throw asiopq::connection_error(handle);
 
 			}
 
-		}
 
-	}
+			virtual bool consume (const batch_type & batch) override {
 
-}
+				for (auto && res : batch) for (int i=0,n=PQntuples(res);i<n;++i) {
 
-SCENARIO("When an ASIO PQ connection fails enqueued operations all fail gracefully","[asiopq][integration][connect][connection]") {
+					sum+=std::stoi(PQgetvalue(res,i,0));
+					++rows;
 
-	GIVEN("An asiopq::connection object representing a connection attempt to a PostgreSQL server which will fail") {
+				}
 
-		asiopq::asio::io_service ios;
-		const char * keywords []={
-			"hostaddr",
-			"port",
-			"dbname",
-			"user",
-			"password",
-			nullptr
-		};
-		const char * values []={
-			ASIOPQ_BAD_HOST_ADDR,
-			ASIOPQ_BAD_PORT,
-			ASIOPQ_BAD_DATABASE_NAME,
-			ASIOPQ_BAD_USERNAME,
-			ASIOPQ_BAD_PASSWORD,
-			nullptr
-		};
-		std::chrono::milliseconds timeout(1000);
-		auto connect=std::make_shared<asiopq::connect>(keywords,values,0,timeout);
-		auto connection=connect->connection(ios);
+				//	Suspend after the first batch
+				return ++batches!=1;
 
-		WHEN("That connection attempt is run on an asiopq::connection") {
+			}
 
-			ios.run();
 
-			THEN("The connection attempt fails") {
+			virtual void complete (std::exception_ptr ex) override {
 
-				auto f=connect->get_future();
-				//	Due to the fact boost::future refuses to accept
-				//	std::exception_ptr, and due to the fact
-				//	boost::current_exception doesn't transport exception
-				//	type information perfectly, we can't assert the
-				//	exception type when using boost::future because
-				//	it won't actually be that type
-				#ifdef ASIOPQ_USE_BOOST_FUTURE
-				CHECK_THROWS(f.get());
-				#else
-				CHECK_THROWS_AS(f.get(),asiopq::connection_error);
-				#endif
+				if (ex) asiopq::set_exception(promise_,std::move(ex));
+				else promise_.set_value();
 
 			}
 
-		}
 
-		WHEN("Several operations are enqueued on the asiopq::connection") {
+			asiopq::future<void> get_future () {
 
-			//	Same batch of operations as the success integration
-			//	test
-			auto create=std::make_shared<create_query>(timeout);
-			auto insert_1=std::make_shared<insert_query>(1,timeout);
-			auto insert_2=std::make_shared<insert_query>(2,timeout);
-			auto count=std::make_shared<count_query>(timeout);
-			auto min=std::make_shared<min_query>(timeout);
-			connection.add(create);
-			connection.add(insert_1);
-			connection.add(insert_2);
-			connection.add(count);
-			connection.add(min);
+				return promise_.get_future();
 
-			AND_WHEN("The asiopq::connection is run") {
+			}
 
-				ios.run();
 
-				THEN("All operations fail") {
+	};
 
-					auto co=connect->get_future();
-					auto cr=create->get_future();
-					auto i1=insert_1->get_future();
-					auto i2=insert_2->get_future();
-					auto ct=count->get_future();
-					auto mi=min->get_future();
-					#ifdef ASIOPQ_USE_BOOST_FUTURE
-					CHECK_THROWS(co.get());
-					CHECK_THROWS(cr.get());
-					CHECK_THROWS(i1.get());
-					CHECK_THROWS(i2.get());
-					CHECK_THROWS(ct.get());
-					CHECK_THROWS(mi.get());
+
+	class copy_rows : public asiopq::copy_in, public std::enable_shared_from_this<copy_rows> {
+
+
+		private:
+
+
+			std::vector<std::string> chunks_;
+			std::size_t i_;
+			asiopq::connection * conn_;
+			asiopq::promise<void> promise_;
+
+
+		public:
+
+
+			//	Empty chunks supply no data, the operation is
+			//	resumed later through conn
+			copy_rows (std::vector<std::string> chunks, timeout_type timeout=timeout_type{}, asiopq::connection * conn=nullptr) : asiopq::copy_in(timeout), chunks_(std::move(chunks)), i_(0), conn_(conn), produced(0) {	}
+
+
+			std::size_t produced;
+
+
+			virtual void send (native_handle_type handle) override {
+
+				if (PQsendQuery(
+					handle,
+					"COPY \"copy_test\" (\"foo\") FROM STDIN;"
+				)==0) throw asiopq::connection_error(handle);
+
+			}
+
+
+			virtual bool produce (buffers_type & buffers) override {
+
+				++produced;
+				if (i_==chunks_.size()) return false;
+
+				if (chunks_[i_].empty() && conn_) {
+
+					auto conn=conn_;
+					conn->get_io_service().post([conn,self=shared_from_this()] () {	conn->resume(self);	});
+
+				}
+				append(buffers,asiopq::asio::buffer(chunks_[i_]));
+
+				return ++i_!=chunks_.size();
+
+			}
+
+
+			virtual void complete (std::exception_ptr ex) override {
+
+				if (ex) asiopq::set_exception(promise_,std::move(ex));
+				else promise_.set_value();
+
+			}
+
+
+			asiopq::future<void> get_future () {
+
+				return promise_.get_future();
+
+			}
+
+
+	};
+
+
+	class copy_series : public asiopq::copy_out, public std::enable_shared_from_this<copy_series> {
+
+
+		private:
+
+
+			asiopq::connection * conn_;
+			std::string data_;
+			asiopq::promise<void> promise_;
+
+
+		public:
+
+
+			explicit copy_series (asiopq::connection * conn=nullptr, timeout_type timeout=timeout_type{}) : asiopq::copy_out(timeout), conn_(conn) {	}
+
+
+			virtual void send (native_handle_type handle) override {
+
+				if (PQsendQuery(
+					handle,
+					"COPY (SELECT * FROM generate_series(1,100)) TO STDOUT;"
+				)==0) throw asiopq::connection_error(handle);
+
+			}
+
+
+			virtual bool consume (chunk c) override {
+
+				data_.append(c.data(),c.size());
+
+				if (!conn_) return true;
+
+				//	Suspend after every chunk, resuming later
+				auto conn=conn_;
+				conn->get_io_service().post([conn,self=shared_from_this()] () {	conn->resume(self);	});
+
+				return false;
+
+			}
+
+
+			virtual void complete (std::exception_ptr ex) override {
+
+				if (ex) asiopq::set_exception(promise_,std::move(ex));
+				else promise_.set_value();
+
+			}
+
+
+			asiopq::future<void> get_future () {
+
+				return promise_.get_future();
+
+			}
+
+
+			const std::string & data () const noexcept {
+
+				return data_;
+
+			}
+
+
+	};
+
+
+	class increment_query : public asiopq::prepared_query {
+
+
+		private:
+
+
+			std::string value_;
+			const char * values_ [1];
+			asiopq::promise<int> promise_;
+
+
+		public:
+
+
+			increment_query (int value, timeout_type timeout=timeout_type{})
+				:	asiopq::prepared_query("SELECT $1::int+1;",timeout),
+					value_(std::to_string(value))
+			{
+
+				values_[0]=value_.c_str();
+
+			}
+
+
+			virtual parameters bind () override {
+
+				parameters retr;
+				retr.count=1;
+				retr.values=values_;
+
+				return retr;
+
+			}
+
+
+			virtual void result (native_result_type result) override {
+
+				auto g=asiopq::make_scope_exit([&] () noexcept {	PQclear(result);	});
+				if (PQresultStatus(result)!=PGRES_TUPLES_OK) throw asiopq::result_error(result);
+
+				promise_.set_value(std::stoi(PQgetvalue(result,0,0)));
+
+			}
+
+
+			virtual void complete (std::exception_ptr ex) override {
+
+				if (ex) asiopq::set_exception(promise_,std::move(ex));
+
+			}
+
+
+			asiopq::future<int> get_future () {
+
+				return promise_.get_future();
+
+			}
+
+
+	};
+
+
+	const char * conninfo="hostaddr='" ASIOPQ_HOST_ADDR "' "
+		"port='" ASIOPQ_PORT "' "
+		"dbname='" ASIOPQ_DATABASE_NAME "' "
+		"user='" ASIOPQ_USERNAME "' "
+		"password='" ASIOPQ_PASSWORD "'";
+
+
+	class error_code_query : public command_query {
+
+
+		public:
+
+
+			std::error_code ec;
+			std::size_t errors=0;
+
+
+			using command_query::command_query;
+			using command_query::complete;
+
+
+			virtual void complete (std::error_code ec, const std::string &) override {
+
+				this->ec=ec;
+				++errors;
+
+			}
+
+
+	};
+
+
+	class min_query : public integer_query {
+
+
+		public:
+
+
+			using integer_query::integer_query;
+
+
+			virtual void send (native_handle_type handle) override {
+
+				if (PQsendQuery(
+					handle,
+					"SELECT MIN(\"foo\") FROM \"test\";"
+				)==0) throw asiopq::connection_error(handle);
+
+			}
+
+
+	};
+
+
+}
+
+
+SCENARIO("ASIO PQ features may be used to connect to a PostgreSQL database, reset that connection, and submit queries","[asiopq][integration][connect][connection][query][reset]") {
+
+	GIVEN("An asiopq::connect object representing a connection attempt to a PostgreSQL server") {
+
+		asiopq::asio::io_service ios;
+		const char * keywords []={
+			"hostaddr",
+			"port",
+			"dbname",
+			"user",
+			"password",
+			nullptr
+		};
+		const char * values []={
+			ASIOPQ_HOST_ADDR,
+			ASIOPQ_PORT,
+			ASIOPQ_DATABASE_NAME,
+			ASIOPQ_USERNAME,
+			ASIOPQ_PASSWORD,
+			nullptr
+		};
+		std::chrono::milliseconds timeout(1000);
+		auto connect=std::make_shared<asiopq::connect>(keywords,values,0,timeout);
+		auto connection=connect->connection(ios);
+
+		WHEN("That connection attempt is run on an asiopq::connection") {
+
+			ios.run();
+			
+			THEN("The connection completes successfully") {
+
+				CHECK_NOTHROW(connect->get_future().get());
+
+				GIVEN("An asiopq::reset object") {
+
+					auto reset=std::make_shared<asiopq::reset>(timeout);
+
+					WHEN("That reset attempt is run on the connected asiopq::connection") {
+
+						connection.add(reset);
+						ios.reset();
+						ios.run();
+
+						THEN("The reset completes successfully") {
+
+							CHECK_NOTHROW(reset->get_future().get());
+
+							GIVEN("Several queries represented by objects which derive from asiopq::query") {
+
+								auto create=std::make_shared<create_query>(timeout);
+								auto insert_1=std::make_shared<insert_query>(1,timeout);
+								auto insert_2=std::make_shared<insert_query>(2,timeout);
+								auto count=std::make_shared<count_query>(timeout);
+								auto min=std::make_shared<min_query>(timeout);
+
+								WHEN("They are run on the asiopq::connection") {
+
+									connection.add(create);
+									connection.add(insert_1);
+									connection.add(insert_2);
+									connection.add(count);
+									connection.add(min);
+									ios.reset();
+									ios.run();
+
+									THEN("They all complete successfully") {
+
+										CHECK_NOTHROW(create->get_future().get());
+										CHECK_NOTHROW(insert_1->get_future().get());
+										CHECK_NOTHROW(insert_2->get_future().get());
+										CHECK(count->get_future().get()==2);
+										CHECK(min->get_future().get()==1);
+
+									}
+
+								}
+
+							}
+
+						}
+
+					}
+
+				}
+
+			}
+
+		}
+
+	}
+
+}
+
+SCENARIO("When an ASIO PQ connection fails enqueued operations all fail gracefully","[asiopq][integration][connect][connection]") {
+
+	GIVEN("An asiopq::connection object representing a connection attempt to a PostgreSQL server which will fail") {
+
+		asiopq::asio::io_service ios;
+		const char * keywords []={
+			"hostaddr",
+			"port",
+			"dbname",
+			"user",
+			"password",
+			nullptr
+		};
+		const char * values []={
+			ASIOPQ_BAD_HOST_ADDR,
+			ASIOPQ_BAD_PORT,
+			ASIOPQ_BAD_DATABASE_NAME,
+			ASIOPQ_BAD_USERNAME,
+			ASIOPQ_BAD_PASSWORD,
+			nullptr
+		};
+		std::chrono::milliseconds timeout(1000);
+		auto connect=std::make_shared<asiopq::connect>(keywords,values,0,timeout);
+		auto connection=connect->connection(ios);
+
+		WHEN("That connection attempt is run on an asiopq::connection") {
+
+			ios.run();
+
+			THEN("The connection attempt fails") {
+
+				auto f=connect->get_future();
+				//	Due to the fact boost::future refuses to accept
+				//	std::exception_ptr, and due to the fact
+				//	boost::current_exception doesn't transport exception
+				//	type information perfectly, we can't assert the
+				//	exception type when using boost::future because
+				//	it won't actually be that type
+				#ifdef ASIOPQ_USE_BOOST_FUTURE
+				CHECK_THROWS(f.get());
+				#else
+				CHECK_THROWS_AS(f.get(),asiopq::connection_error);
+				#endif
+
+			}
+
+		}
+
+		WHEN("Several operations are enqueued on the asiopq::connection") {
+
+			//	Same batch of operations as the success integration
+			//	test
+			auto create=std::make_shared<create_query>(timeout);
+			auto insert_1=std::make_shared<insert_query>(1,timeout);
+			auto insert_2=std::make_shared<insert_query>(2,timeout);
+			auto count=std::make_shared<count_query>(timeout);
+			auto min=std::make_shared<min_query>(timeout);
+			connection.add(create);
+			connection.add(insert_1);
+			connection.add(insert_2);
+			connection.add(count);
+			connection.add(min);
+
+			AND_WHEN("The asiopq::connection is run") {
+
+				ios.run();
+
+				THEN("All operations fail") {
+
+					auto co=connect->get_future();
+					auto cr=create->get_future();
+					auto i1=insert_1->get_future();
+					auto i2=insert_2->get_future();
+					auto ct=count->get_future();
+					auto mi=min->get_future();
+					#ifdef ASIOPQ_USE_BOOST_FUTURE
+					CHECK_THROWS(co.get());
+					CHECK_THROWS(cr.get());
+					CHECK_THROWS(i1.get());
+					CHECK_THROWS(i2.get());
+					CHECK_THROWS(ct.get());
+					CHECK_THROWS(mi.get());
 					#else
 					CHECK_THROWS_AS(co.get(),asiopq::connection_error);
 					CHECK_THROWS_AS(cr.get(),asiopq::connection_error);
@@ -417,3 +942,1345 @@ SCENARIO("When an ASIO PQ connection fails enqueued operations all fail graceful
 	}
 
 }
+
+SCENARIO("ASIO PQ connections in pipeline mode send queries back-to-back and isolate their failures","[asiopq][integration][connection][query][pipeline]") {
+
+	GIVEN("An asiopq::connection in pipeline mode") {
+
+		asiopq::asio::io_service ios;
+		std::chrono::milliseconds timeout(1000);
+		auto connect=make_connect(timeout);
+		auto connection=connect->connection(ios);
+		connection.pipeline(true);
+
+		WHEN("Several queries, one of which fails, are run thereupon") {
+
+			auto one=std::make_shared<select_query>("SELECT 1;",timeout);
+			auto fail=std::make_shared<select_query>("SELECT 1/0;",timeout);
+			auto two=std::make_shared<select_query>("SELECT 2;",timeout);
+			connection.add(one);
+			connection.add(fail);
+			connection.add(two);
+			ios.run();
+
+			THEN("Only the query which failed fails") {
+
+				CHECK_NOTHROW(connect->get_future().get());
+				CHECK(one->get_future().get()==1);
+				CHECK_THROWS(fail->get_future().get());
+				CHECK(two->get_future().get()==2);
+
+			}
+
+			AND_WHEN("An operation which is not a query is run after them") {
+
+				auto reset=std::make_shared<asiopq::reset>(timeout);
+				auto three=std::make_shared<select_query>("SELECT 3;",timeout);
+				connection.add(reset);
+				connection.add(three);
+				ios.reset();
+				ios.run();
+
+				THEN("It runs exclusively and pipelining resumes thereafter") {
+
+					CHECK_NOTHROW(reset->get_future().get());
+					CHECK(three->get_future().get()==3);
+
+				}
+
+			}
+
+		}
+
+	}
+
+}
+
+SCENARIO("ASIO PQ pools dispatch operations to their connections and allow connections to be pinned","[asiopq][integration][pool]") {
+
+	GIVEN("An asiopq::pool with two shards of two connections each") {
+
+		asiopq::asio::io_service a;
+		asiopq::asio::io_service b;
+		std::chrono::milliseconds timeout(1000);
+		asiopq::pool pool(conninfo,2,asiopq::pool::io_services_type{std::ref(a),std::ref(b)},timeout);
+
+		THEN("It contains four connections") {
+
+			CHECK(pool.size()==4);
+
+		}
+
+		WHEN("Queries are added thereto") {
+
+			auto one=std::make_shared<select_query>("SELECT 1;",timeout);
+			auto two=std::make_shared<select_query>("SELECT 2;",timeout);
+			pool.add(one);
+			pool.add(two);
+			a.run();
+			b.run();
+
+			THEN("They complete successfully") {
+
+				CHECK(one->get_future().get()==1);
+				CHECK(two->get_future().get()==2);
+
+			}
+
+		}
+
+		WHEN("Every connection is pinned") {
+
+			auto p1=pool.pin();
+			auto p2=pool.pin();
+			auto p3=pool.pin();
+			auto p4=pool.pin();
+
+			THEN("Operations cannot be added to the pool") {
+
+				CHECK_THROWS_AS(pool.add(std::make_shared<select_query>("SELECT 1;",timeout)),std::runtime_error);
+				CHECK_THROWS_AS(pool.pin(),std::runtime_error);
+
+			}
+
+			THEN("Each pinned connection is distinct") {
+
+				CHECK(&p1.connection()!=&p2.connection());
+				CHECK(&p1.connection()!=&p3.connection());
+				CHECK(&p1.connection()!=&p4.connection());
+				CHECK(&p2.connection()!=&p3.connection());
+				CHECK(&p2.connection()!=&p4.connection());
+				CHECK(&p3.connection()!=&p4.connection());
+
+			}
+
+			AND_WHEN("A connection is unpinned") {
+
+				{	auto p=std::move(p1);	}
+
+				THEN("Operations may be added to the pool once more") {
+
+					CHECK_NOTHROW(pool.add(std::make_shared<select_query>("SELECT 1;",timeout)));
+
+				}
+
+			}
+
+		}
+
+	}
+
+}
+
+SCENARIO("ASIO PQ pools dispatch operations from the threads of a shard to that shard and track failed connections","[asiopq][integration][pool]") {
+
+	GIVEN("An asiopq::pool with two shards of one connection each") {
+
+		asiopq::asio::io_service a;
+		asiopq::asio::io_service b;
+		std::chrono::milliseconds timeout(1000);
+		asiopq::pool pool(conninfo,1,asiopq::pool::io_services_type{std::ref(a),std::ref(b)},timeout);
+
+		WHEN("Queries are added from a handler running on the asio::io_service of each shard") {
+
+			a.run();
+			b.run();
+			a.reset();
+			b.reset();
+
+			auto one=std::make_shared<select_query>("SELECT 1;",timeout);
+			auto two=std::make_shared<select_query>("SELECT 2;",timeout);
+			asiopq::asio::io_service * ran_one=nullptr;
+			asiopq::asio::io_service * ran_two=nullptr;
+			std::size_t size_one=0;
+			std::size_t size_two=0;
+			a.post([&] () {
+
+				pool.add(one);
+				auto p=pool.pin();
+				ran_one=&p.connection().get_io_service();
+				size_one=p.connection().size();
+
+			});
+			b.post([&] () {
+
+				pool.add(two);
+				auto p=pool.pin();
+				ran_two=&p.connection().get_io_service();
+				size_two=p.connection().size();
+
+			});
+			a.run();
+			b.run();
+
+			THEN("Each is dispatched to the connection of that shard") {
+
+				CHECK(ran_one==&a);
+				CHECK(ran_two==&b);
+				CHECK(size_one==1);
+				CHECK(size_two==1);
+				CHECK(one->get_future().get()==1);
+				CHECK(two->get_future().get()==2);
+				CHECK(pool.failed()==0);
+
+			}
+
+		}
+
+	}
+
+	GIVEN("An asiopq::pool whose connections cannot be established") {
+
+		asiopq::asio::io_service ios;
+		std::chrono::milliseconds timeout(1000);
+		const char * bad="hostaddr=" ASIOPQ_BAD_HOST_ADDR " port=" ASIOPQ_BAD_PORT " dbname=" ASIOPQ_BAD_DATABASE_NAME " user=" ASIOPQ_BAD_USERNAME " password=" ASIOPQ_BAD_PASSWORD;
+		asiopq::pool pool(bad,2,ios,timeout);
+
+		WHEN("The connection attempts are run") {
+
+			ios.run();
+
+			THEN("The failures are reported") {
+
+				CHECK(pool.failed()==2);
+
+			}
+
+			AND_WHEN("A query is added thereto") {
+
+				auto q=std::make_shared<select_query>("SELECT 1;",timeout);
+				pool.add(q);
+				ios.reset();
+				ios.run();
+
+				THEN("The connection is reset before the query runs and the query fails") {
+
+					CHECK_THROWS(q->get_future().get());
+					CHECK(pool.failed()==2);
+
+				}
+
+			}
+
+		}
+
+	}
+
+}
+
+SCENARIO("ASIO PQ connections recover from operations which time out while the server is executing them","[asiopq][integration][connection][query][timeout]") {
+
+	GIVEN("An asiopq::connection") {
+
+		asiopq::asio::io_service ios;
+		std::chrono::milliseconds timeout(1000);
+		auto connect=make_connect(timeout);
+		auto connection=connect->connection(ios);
+
+		WHEN("A query which times out is run thereupon followed by another query") {
+
+			auto sleep=std::make_shared<select_query>("SELECT pg_sleep(30);",std::chrono::milliseconds(100));
+			auto one=std::make_shared<select_query>("SELECT 1;",timeout);
+			connection.add(sleep);
+			connection.add(one);
+			ios.run();
+
+			THEN("The query which times out fails") {
+
+				#ifdef ASIOPQ_USE_BOOST_FUTURE
+				CHECK_THROWS(sleep->get_future().get());
+				#else
+				CHECK_THROWS_AS(sleep->get_future().get(),asiopq::timed_out);
+				#endif
+
+			}
+
+			THEN("The subsequent query completes successfully") {
+
+				CHECK(one->get_future().get()==1);
+
+			}
+
+			THEN("The recovery is reflected in the connection's statistics") {
+
+				auto stats=connection.statistics();
+				CHECK(stats.recovered==1);
+				CHECK(stats.unrecovered==0);
+				CHECK(stats.max_recovery_time>asiopq::statistics::duration::zero());
+
+			}
+
+		}
+
+	}
+
+}
+
+SCENARIO("ASIO PQ streaming queries deliver rows in batches and may be suspended","[asiopq][integration][connection][streaming_query]") {
+
+	GIVEN("An asiopq::connection and an asiopq::streaming_query which suspends after its first batch") {
+
+		asiopq::asio::io_service ios;
+		std::chrono::milliseconds timeout(1000);
+		auto connect=make_connect(timeout);
+		auto connection=connect->connection(ios);
+		auto series=std::make_shared<series_query>(100);
+
+		WHEN("The query is run on the connection") {
+
+			connection.add(series);
+			ios.run();
+
+			THEN("Only the first batch is delivered") {
+
+				CHECK(series->batches==1);
+				CHECK(series->rows==100);
+
+				AND_WHEN("Resumption is requested for an operation which has finished") {
+
+					auto other=std::make_shared<select_query>("SELECT 1;",timeout);
+					connection.resume(other);
+					ios.reset();
+					ios.run();
+
+					THEN("The query remains suspended") {
+
+						CHECK(series->batches==1);
+						CHECK(series->rows==100);
+
+					}
+
+				}
+
+				AND_WHEN("The connection is resumed") {
+
+					connection.resume(series);
+					ios.reset();
+					ios.run();
+
+					THEN("The remaining rows are delivered and the query completes") {
+
+						CHECK_NOTHROW(series->get_future().get());
+						CHECK(series->rows==1000);
+						CHECK(series->sum==500500);
+
+					}
+
+				}
+
+			}
+
+		}
+
+	}
+
+}
+
+SCENARIO("ASIO PQ copy_in operations copy data to the server","[asiopq][integration][connection][copy_in]") {
+
+	GIVEN("An asiopq::connection with a temporary table") {
+
+		asiopq::asio::io_service ios;
+		std::chrono::milliseconds timeout(1000);
+		auto connect=make_connect(timeout);
+		auto connection=connect->connection(ios);
+		auto create=std::make_shared<command_query>("CREATE TEMPORARY TABLE \"copy_test\" (\"foo\" int);",timeout);
+		connection.add(create);
+
+		WHEN("Rows are copied thereto from several buffers") {
+
+			auto copy=std::make_shared<copy_rows>(std::vector<std::string>{"1\n2\n","3","\n"},timeout);
+			auto count=std::make_shared<select_query>("SELECT COUNT(*) FROM \"copy_test\";",timeout);
+			connection.add(copy);
+			connection.add(count);
+			ios.run();
+
+			THEN("The copy completes successfully") {
+
+				CHECK_NOTHROW(create->get_future().get());
+				CHECK_NOTHROW(copy->get_future().get());
+				CHECK(copy->rows()=="3");
+				CHECK(count->get_future().get()==3);
+
+			}
+
+		}
+
+		WHEN("Rows are copied thereto by a producer which at first has nothing to supply") {
+
+			auto copy=std::make_shared<copy_rows>(std::vector<std::string>{"1\n","","2\n"},timeout,&connection);
+			auto count=std::make_shared<select_query>("SELECT COUNT(*) FROM \"copy_test\";",timeout);
+			connection.add(copy);
+			connection.add(count);
+			ios.run();
+
+			THEN("The copy waits to be resumed rather than asking again and completes successfully") {
+
+				CHECK_NOTHROW(copy->get_future().get());
+				CHECK(copy->produced==3);
+				CHECK(count->get_future().get()==2);
+
+			}
+
+		}
+
+		WHEN("Malformed rows are copied thereto") {
+
+			auto copy=std::make_shared<copy_rows>(std::vector<std::string>{"foo\n"},timeout);
+			auto count=std::make_shared<select_query>("SELECT COUNT(*) FROM \"copy_test\";",timeout);
+			connection.add(copy);
+			connection.add(count);
+			ios.run();
+
+			THEN("The copy fails but the connection remains usable") {
+
+				CHECK_THROWS(copy->get_future().get());
+				CHECK(count->get_future().get()==0);
+
+			}
+
+		}
+
+	}
+
+}
+
+
+SCENARIO("ASIO PQ copy_out operations copy data from the server","[asiopq][integration][connection][copy_out]") {
+
+	GIVEN("An asiopq::connection") {
+
+		asiopq::asio::io_service ios;
+		std::chrono::milliseconds timeout(1000);
+		auto connect=make_connect(timeout);
+		auto connection=connect->connection(ios);
+		std::string expected;
+		for (int i=1;i<=100;++i) expected+=std::to_string(i)+"\n";
+
+		WHEN("Rows are copied therefrom") {
+
+			auto copy=std::make_shared<copy_series>(nullptr,timeout);
+			auto select=std::make_shared<select_query>("SELECT 1;",timeout);
+			connection.add(copy);
+			connection.add(select);
+			ios.run();
+
+			THEN("The copy completes successfully") {
+
+				CHECK_NOTHROW(copy->get_future().get());
+				CHECK(copy->rows()=="100");
+				CHECK(copy->data()==expected);
+				CHECK(select->get_future().get()==1);
+
+			}
+
+		}
+
+		WHEN("Rows are copied therefrom by a sink which suspends after each chunk") {
+
+			auto copy=std::make_shared<copy_series>(&connection,timeout);
+			connection.add(copy);
+			ios.run();
+
+			THEN("The copy completes successfully") {
+
+				CHECK_NOTHROW(copy->get_future().get());
+				CHECK(copy->data()==expected);
+
+			}
+
+		}
+
+	}
+
+}
+
+
+SCENARIO("ASIO PQ prepared queries are prepared once and reused","[asiopq][integration][connection][prepared_query]") {
+
+	GIVEN("An asiopq::connection") {
+
+		asiopq::asio::io_service ios;
+		std::chrono::milliseconds timeout(1000);
+		auto connect=make_connect(timeout);
+		auto connection=connect->connection(ios);
+		auto count=std::make_shared<select_query>("SELECT COUNT(*) FROM pg_prepared_statements;",timeout);
+
+		WHEN("The same query is executed several times") {
+
+			auto a=std::make_shared<increment_query>(1,timeout);
+			auto b=std::make_shared<increment_query>(2,timeout);
+			auto c=std::make_shared<increment_query>(3,timeout);
+			connection.add(a);
+			connection.add(b);
+			connection.add(c);
+			connection.add(count);
+			ios.run();
+
+			THEN("Each execution succeeds and the query is prepared exactly once") {
+
+				CHECK(a->get_future().get()==2);
+				CHECK(b->get_future().get()==3);
+				CHECK(c->get_future().get()==4);
+				CHECK(count->get_future().get()==1);
+
+			}
+
+		}
+
+		WHEN("The connection is reset between executions") {
+
+			auto a=std::make_shared<increment_query>(1,timeout);
+			auto reset=std::make_shared<asiopq::reset>(timeout);
+			auto b=std::make_shared<increment_query>(2,timeout);
+			connection.add(a);
+			connection.add(reset);
+			connection.add(b);
+			connection.add(count);
+			ios.run();
+
+			THEN("The query is prepared again") {
+
+				CHECK(a->get_future().get()==2);
+				CHECK_NOTHROW(reset->get_future().get());
+				CHECK(b->get_future().get()==3);
+				CHECK(count->get_future().get()==1);
+
+			}
+
+		}
+
+		WHEN("Preparation is disabled") {
+
+			connection.cache(0);
+			auto a=std::make_shared<increment_query>(1,timeout);
+			connection.add(a);
+			connection.add(count);
+			ios.run();
+
+			THEN("The query is executed without being prepared") {
+
+				CHECK(a->get_future().get()==2);
+				CHECK(count->get_future().get()==0);
+
+			}
+
+		}
+
+	}
+
+}
+
+
+SCENARIO("ASIO PQ connections may be established and reset using completion tokens","[asiopq][integration][connect][reset][async]") {
+
+	GIVEN("An asio::io_service") {
+
+		asiopq::asio::io_service ios;
+		std::chrono::milliseconds timeout(1000);
+		const char * conninfo="hostaddr=" ASIOPQ_HOST_ADDR " port=" ASIOPQ_PORT " dbname=" ASIOPQ_DATABASE_NAME " user=" ASIOPQ_USERNAME " password=" ASIOPQ_PASSWORD;
+
+		WHEN("A connection is established and reset using callbacks") {
+
+			std::exception_ptr connect_ex;
+			std::exception_ptr reset_ex;
+			bool reset=false;
+			asiopq::async_connect(conninfo,ios,timeout,[&] (std::exception_ptr ex, asiopq::connection conn) {
+
+				connect_ex=ex;
+				if (ex) return;
+
+				auto c=std::make_shared<asiopq::connection>(std::move(conn));
+				asiopq::async_reset(*c,timeout,[&,c] (std::exception_ptr ex) {
+
+					reset_ex=ex;
+					reset=true;
+
+				});
+
+			});
+			ios.run();
+
+			THEN("Both complete successfully") {
+
+				CHECK_FALSE(connect_ex);
+				CHECK(reset);
+				CHECK_FALSE(reset_ex);
+
+			}
+
+		}
+
+		WHEN("A connection is established and reset using futures") {
+
+			auto connect=asiopq::async_connect(conninfo,ios,timeout,asiopq::asio::use_future);
+			ios.run();
+
+			THEN("Both complete successfully") {
+
+				auto conn=connect.get();
+				auto reset=asiopq::async_reset(conn,timeout,asiopq::asio::use_future);
+				ios.reset();
+				ios.run();
+				CHECK_NOTHROW(reset.get());
+
+			}
+
+		}
+
+	}
+
+}
+
+
+SCENARIO("ASIO PQ connections deliver notifications to subscribers","[asiopq][integration][connection][pool][notify]") {
+
+	GIVEN("An asiopq::connection") {
+
+		asiopq::asio::io_service ios;
+		std::chrono::milliseconds timeout(1000);
+		auto connect=make_connect(timeout);
+		auto connection=connect->connection(ios);
+		std::vector<std::string> payloads;
+
+		WHEN("It subscribes to a channel and a notification is sent thereupon") {
+
+			connection.subscribe("asiopq_test",[&] (const PGnotify & notify) {
+
+				payloads.push_back(notify.extra);
+				ios.stop();
+
+			});
+			auto notify=std::make_shared<command_query>("NOTIFY asiopq_test, 'hello';",timeout);
+			connection.add(notify);
+			ios.run();
+
+			THEN("The subscriber receives the notification") {
+
+				CHECK_NOTHROW(notify->get_future().get());
+				REQUIRE(payloads.size()==1);
+				CHECK(payloads[0]=="hello");
+
+			}
+
+		}
+
+		WHEN("A notification is sent while the connection is idle") {
+
+			connection.subscribe("asiopq_test",[&] (const PGnotify & notify) {
+
+				payloads.push_back(notify.extra);
+				ios.stop();
+
+			});
+			//	Ensures LISTEN has been executed before the
+			//	notification is sent
+			auto wait=std::make_shared<command_query>("SET application_name TO 'asiopq';",timeout);
+			connection.add(wait);
+			auto ready=wait->get_future();
+			run_until_ready(ios,ready);
+			auto other=make_connect(timeout);
+			auto sender=other->connection(ios);
+			sender.add(std::make_shared<command_query>("NOTIFY asiopq_test, 'idle';",timeout));
+			ios.run();
+
+			THEN("The subscriber receives the notification") {
+
+				REQUIRE(payloads.size()==1);
+				CHECK(payloads[0]=="idle");
+
+			}
+
+		}
+
+	}
+
+	GIVEN("An asiopq::connection owned by a subscriber") {
+
+		asiopq::asio::io_service ios;
+		std::chrono::milliseconds timeout(1000);
+		auto connect=make_connect(timeout);
+		auto connection=std::make_unique<asiopq::connection>(connect->connection(ios));
+		std::vector<std::string> payloads;
+
+		WHEN("The subscriber destroys the connection upon receiving a notification") {
+
+			connection->subscribe("asiopq_test",[&] (const PGnotify & notify) {
+
+				payloads.push_back(notify.extra);
+				connection.reset();
+
+			});
+			connection->add(std::make_shared<command_query>("NOTIFY asiopq_test, 'destroy';",timeout));
+			ios.run();
+
+			THEN("The connection is destroyed without waiting on itself") {
+
+				CHECK_FALSE(connection);
+				REQUIRE(payloads.size()==1);
+				CHECK(payloads[0]=="destroy");
+
+			}
+
+		}
+
+	}
+
+	GIVEN("An asiopq::pool") {
+
+		asiopq::asio::io_service ios;
+		std::chrono::milliseconds timeout(1000);
+		asiopq::pool pool(
+			"hostaddr=" ASIOPQ_HOST_ADDR " port=" ASIOPQ_PORT " dbname=" ASIOPQ_DATABASE_NAME " user=" ASIOPQ_USERNAME " password=" ASIOPQ_PASSWORD,
+			2,
+			ios,
+			timeout
+		);
+		std::vector<std::string> channels;
+
+		WHEN("Its listener subscribes to many channels and a notification is sent on one") {
+
+			for (int i=0;i<1000;++i) pool.listener().subscribe("asiopq_test_"+std::to_string(i),[&] (const PGnotify & notify) {
+
+				channels.push_back(notify.relname);
+				ios.stop();
+
+			});
+			//	Ensures the LISTEN commands have been executed
+			//	before the notification is sent
+			auto wait=std::make_shared<command_query>("SET application_name TO 'asiopq';",timeout);
+			pool.listener().add(wait);
+			auto ready=wait->get_future();
+			run_until_ready(ios,ready);
+			pool.add(std::make_shared<command_query>("NOTIFY asiopq_test_500;",timeout));
+			ios.run();
+
+			THEN("Only that channel's subscriber receives it") {
+
+				REQUIRE(channels.size()==1);
+				CHECK(channels[0]=="asiopq_test_500");
+
+			}
+
+		}
+
+	}
+
+}
+
+
+SCENARIO("ASIO PQ connections may be established over TCP or Unix domain sockets","[asiopq][integration][connect][connection][unix]") {
+
+	GIVEN("An asio::io_service") {
+
+		asiopq::asio::io_service ios;
+		std::chrono::milliseconds timeout(1000);
+		const char * tcp="hostaddr=" ASIOPQ_HOST_ADDR " port=" ASIOPQ_PORT " dbname=" ASIOPQ_DATABASE_NAME " user=" ASIOPQ_USERNAME " password=" ASIOPQ_PASSWORD;
+		const char * local="host=" ASIOPQ_SOCKET_DIR " port=" ASIOPQ_PORT " dbname=" ASIOPQ_DATABASE_NAME " user=" ASIOPQ_USERNAME " password=" ASIOPQ_PASSWORD;
+
+		//	Runs queries one at a time so that each costs a
+		//	round trip and returns the number which completed
+		//	along with the mean time taken
+		const std::size_t n=1000;
+		auto round_trips=[&] (asiopq::connection & conn) {
+
+			std::size_t completed=0;
+			auto start=std::chrono::steady_clock::now();
+			for (std::size_t i=0;i<n;++i) {
+
+				auto q=std::make_shared<command_query>("SET application_name TO 'asiopq';",timeout);
+				auto f=q->get_future();
+				conn.add(q);
+				run_until_ready(ios,f);
+				f.get();
+				++completed;
+
+			}
+
+			auto mean=std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now()-start)/n;
+			return std::make_pair(completed,mean);
+
+		};
+
+		WHEN("A connection is established over a Unix domain socket") {
+
+			auto connect=std::make_shared<asiopq::connect>(local,timeout);
+			auto f=connect->get_future();
+			auto conn=connect->connection(ios);
+			run_until_ready(ios,f);
+
+			THEN("It succeeds and queries may be run thereupon") {
+
+				REQUIRE_NOTHROW(f.get());
+				auto q=std::make_shared<command_query>("SET application_name TO 'asiopq';",timeout);
+				auto qf=q->get_future();
+				conn.add(q);
+				run_until_ready(ios,qf);
+				CHECK_NOTHROW(qf.get());
+
+			}
+
+			AND_WHEN("It is reset") {
+
+				auto r=std::make_shared<asiopq::reset>(timeout);
+				auto rf=r->get_future();
+				conn.add(r);
+				run_until_ready(ios,rf);
+
+				THEN("The new socket is used") {
+
+					REQUIRE_NOTHROW(rf.get());
+					auto q=std::make_shared<command_query>("SET application_name TO 'asiopq';",timeout);
+					auto qf=q->get_future();
+					conn.add(q);
+					run_until_ready(ios,qf);
+					CHECK_NOTHROW(qf.get());
+
+				}
+
+			}
+
+		}
+
+		WHEN("Round trips are timed over each transport") {
+
+			auto tcp_connect=std::make_shared<asiopq::connect>(tcp,timeout);
+			auto tcp_f=tcp_connect->get_future();
+			auto tcp_conn=tcp_connect->connection(ios);
+			run_until_ready(ios,tcp_f);
+			auto local_connect=std::make_shared<asiopq::connect>(local,timeout);
+			auto local_f=local_connect->get_future();
+			auto local_conn=local_connect->connection(ios);
+			run_until_ready(ios,local_f);
+			tcp_f.get();
+			local_f.get();
+
+			auto tcp_result=round_trips(tcp_conn);
+			auto local_result=round_trips(local_conn);
+
+			THEN("Every round trip completes over both") {
+
+				WARN("Mean round trip over TCP: " << tcp_result.second.count() << "us, over a Unix domain socket: " << local_result.second.count() << "us");
+				CHECK(tcp_result.first==n);
+				CHECK(local_result.first==n);
+
+			}
+
+		}
+
+	}
+
+}
+
+
+SCENARIO("ASIO PQ connections sustain round trips on many connections at once","[asiopq][integration][connection][backend]") {
+
+	GIVEN("Several asiopq::connection objects") {
+
+		asiopq::asio::io_service ios;
+		std::chrono::milliseconds timeout(1000);
+		std::vector<asiopq::connection> connections;
+		for (std::size_t i=0;i<32;++i) {
+
+			auto connect=make_connect(timeout);
+			auto f=connect->get_future();
+			connections.push_back(connect->connection(ios));
+			run_until_ready(ios,f);
+			f.get();
+
+		}
+
+		WHEN("Each runs queries one after another") {
+
+			const std::size_t n=200;
+			std::size_t completed=0;
+			std::exception_ptr ex;
+			//	Each query enqueues the next when it completes so
+			//	that every connection always has one in flight
+			std::function<void (asiopq::connection &, std::size_t)> next=[&] (asiopq::connection & conn, std::size_t remaining) {
+
+				if (remaining==0) return;
+				auto q=std::make_shared<callback_query>("SET application_name TO 'asiopq';",timeout,[&,remaining] (std::exception_ptr e) {
+
+					if (e && !ex) ex=e;
+					++completed;
+					next(conn,remaining-1);
+
+				});
+				conn.add(q);
+
+			};
+			auto start=std::chrono::steady_clock::now();
+			for (auto && conn : connections) next(conn,n);
+			ios.run();
+			auto elapsed=std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now()-start);
+
+			THEN("Every query completes") {
+
+				#ifdef ASIOPQ_USE_IO_URING
+				const char * backend="io_uring";
+				#else
+				const char * backend="the default reactor";
+				#endif
+				WARN("Ran " << completed << " round trips on " << connections.size() << " connections in " << elapsed.count() << "ms using " << backend);
+				CHECK_FALSE(ex);
+				CHECK(completed==(connections.size()*n));
+
+			}
+
+		}
+
+	}
+
+}
+
+
+SCENARIO("ASIO PQ connections begin operations of higher priority first","[asiopq][integration][connection][priority]") {
+
+	GIVEN("An asiopq::connection") {
+
+		asiopq::asio::io_service ios;
+		std::chrono::milliseconds timeout(5000);
+		auto connect=make_connect(timeout);
+		auto f=connect->get_future();
+		auto connection=connect->connection(ios);
+		run_until_ready(ios,f);
+		f.get();
+
+		WHEN("Batch and interactive operations are enqueued behind a slow operation") {
+
+			std::vector<asiopq::priority> order;
+			auto make=[&] (asiopq::priority cls) {
+
+				return std::make_shared<callback_query>("SET application_name TO 'asiopq';",timeout,[&,cls] (std::exception_ptr ex) {
+
+					if (!ex) order.push_back(cls);
+
+				});
+
+			};
+			auto slow=std::make_shared<command_query>("DO $$ BEGIN PERFORM pg_sleep(0.05); END $$;",timeout);
+			auto slow_f=slow->get_future();
+			connection.add(slow);
+			connection.add(make(asiopq::priority::batch),asiopq::priority::batch);
+			connection.add(make(asiopq::priority::interactive),asiopq::priority::interactive);
+			run_until_ready(ios,slow_f);
+			while (order.size()!=2) ios.run_one();
+
+			THEN("The interactive operation completes first and waiting is reported per class") {
+
+				CHECK_NOTHROW(slow_f.get());
+				REQUIRE(order.size()==2);
+				CHECK(order[0]==asiopq::priority::interactive);
+				CHECK(order[1]==asiopq::priority::batch);
+				auto stats=connection.statistics();
+				CHECK(stats.waits[std::size_t(asiopq::priority::interactive)].operations==1);
+				CHECK(stats.waits[std::size_t(asiopq::priority::batch)].operations==1);
+				CHECK(stats.waits[std::size_t(asiopq::priority::batch)].max>=stats.waits[std::size_t(asiopq::priority::interactive)].max);
+
+			}
+
+		}
+
+	}
+
+}
+
+
+SCENARIO("ASIO PQ connections complete operations which time out while waiting without sending them","[asiopq][integration][connection][timeout][deadline]") {
+
+	GIVEN("An asiopq::connection") {
+
+		asiopq::asio::io_service ios;
+		std::chrono::milliseconds timeout(5000);
+		auto connect=make_connect(timeout);
+		auto f=connect->get_future();
+		auto connection=connect->connection(ios);
+		run_until_ready(ios,f);
+		f.get();
+
+		WHEN("An operation with a short timeout is enqueued behind a slow operation") {
+
+			auto slow=std::make_shared<command_query>("DO $$ BEGIN PERFORM pg_sleep(0.1); END $$;",timeout);
+			auto slow_f=slow->get_future();
+			auto impatient=std::make_shared<command_query>("SET application_name TO 'asiopq';",std::chrono::milliseconds(10));
+			auto impatient_f=impatient->get_future();
+			connection.add(slow);
+			connection.add(impatient);
+			run_until_ready(ios,slow_f);
+			run_until_ready(ios,impatient_f);
+
+			THEN("The slow operation succeeds and the other times out without being sent") {
+
+				CHECK_NOTHROW(slow_f.get());
+				CHECK_THROWS_AS(impatient_f.get(),asiopq::timed_out);
+				auto stats=connection.statistics();
+				CHECK(stats.expired==1);
+				CHECK(stats.recovered==0);
+
+			}
+
+		}
+
+	}
+
+}
+
+
+SCENARIO("ASIO PQ connections limit the number of operations waiting to begin","[asiopq][integration][connection][limit]") {
+
+	GIVEN("An asiopq::connection with a limit of two waiting operations") {
+
+		asiopq::asio::io_service ios;
+		std::chrono::milliseconds timeout(5000);
+		auto connect=make_connect(timeout);
+		auto f=connect->get_future();
+		auto connection=connect->connection(ios);
+		run_until_ready(ios,f);
+		f.get();
+		connection.limit(2);
+
+		WHEN("Operations are added until the limit is reached and another waits for admission") {
+
+			auto slow=std::make_shared<command_query>("DO $$ BEGIN PERFORM pg_sleep(0.05); END $$;",timeout);
+			auto slow_f=slow->get_future();
+			auto next=std::make_shared<command_query>("SET application_name TO 'asiopq';",timeout);
+			auto next_f=next->get_future();
+			auto rejected=std::make_shared<command_query>("SET application_name TO 'asiopq';",timeout);
+			auto admitted=std::make_shared<command_query>("SET application_name TO 'asiopq';",timeout);
+			auto admitted_f=admitted->get_future();
+			connection.add(slow);
+			connection.add(next);
+			auto waiting=connection.waiting();
+			bool rejected_thrown=false;
+			try {
+
+				connection.add(rejected);
+
+			} catch (const asiopq::queue_full & ex) {
+
+				rejected_thrown=ex.limit()==2;
+
+			}
+			bool admission=false;
+			std::exception_ptr admission_ex;
+			asiopq::async_add(connection,admitted,[&] (std::exception_ptr ex) {
+
+				admission=true;
+				admission_ex=ex;
+
+			});
+			run_until_ready(ios,slow_f);
+			run_until_ready(ios,next_f);
+			run_until_ready(ios,admitted_f);
+			while (!admission) ios.run_one();
+
+			THEN("The excess operation is rejected, the other is admitted once there is room, and the high-water mark is reported") {
+
+				CHECK(waiting==2);
+				CHECK(rejected_thrown);
+				CHECK_NOTHROW(slow_f.get());
+				CHECK_NOTHROW(next_f.get());
+				CHECK(admission);
+				CHECK_FALSE(admission_ex);
+				CHECK_NOTHROW(admitted_f.get());
+				CHECK(connection.waiting()==0);
+				auto stats=connection.statistics();
+				CHECK(stats.rejected==1);
+				CHECK(stats.max_waiting==2);
+
+			}
+
+		}
+
+		WHEN("An operation which throws as it is enqueued is added") {
+
+			bool called=false;
+			std::exception_ptr ex;
+			auto bad=std::make_shared<throwing_timeout_query>("SELECT 1;",timeout,[&] (std::exception_ptr e) {
+
+				called=true;
+				ex=e;
+
+			});
+			connection.add(bad);
+			while (!called) ios.run_one();
+
+			THEN("It is informed of the failure and does not keep its place") {
+
+				CHECK(ex);
+				CHECK(connection.waiting()==0);
+				CHECK(connection.size()==0);
+				auto one=std::make_shared<command_query>("SET application_name TO 'asiopq';",timeout);
+				auto two=std::make_shared<command_query>("SET application_name TO 'asiopq';",timeout);
+				CHECK_NOTHROW(connection.add(one));
+				CHECK_NOTHROW(connection.add(two));
+
+			}
+
+		}
+
+	}
+
+}
+
+
+SCENARIO("ASIO PQ connections inform operations of their completion in order once they have finished with them","[asiopq][integration][connection][completion]") {
+
+	GIVEN("An asiopq::connection") {
+
+		asiopq::asio::io_service ios;
+		std::chrono::milliseconds timeout(5000);
+		auto connect=make_connect(timeout);
+		auto f=connect->get_future();
+		auto connection=std::make_unique<asiopq::connection>(connect->connection(ios));
+		run_until_ready(ios,f);
+		f.get();
+
+		std::vector<std::size_t> order;
+		auto make=[&] (std::size_t i) {
+
+			return std::make_shared<callback_query>("SET application_name TO 'asiopq';",timeout,[&,i] (std::exception_ptr ex) {
+
+				if (!ex) order.push_back(i);
+
+			});
+
+		};
+
+		WHEN("Operations are enqueued with a completion executor") {
+
+			asiopq::asio::io_service completions;
+			connection->completion_executor(completions.get_executor());
+			const std::size_t n=8;
+			for (std::size_t i=0;i<n;++i) connection->add(make(i));
+			while (connection->size()!=0) ios.run_one();
+			auto before=order.size();
+			completions.run();
+
+			THEN("They are informed only by the executor and in the order in which they were enqueued") {
+
+				CHECK(before==0);
+				REQUIRE(order.size()==n);
+				for (std::size_t i=0;i<n;++i) CHECK(order[i]==i);
+
+			}
+
+		}
+
+		WHEN("An operation destroys the connection when it is informed of its completion") {
+
+			bool destroyed=false;
+			connection->add(std::make_shared<callback_query>("SET application_name TO 'asiopq';",timeout,[&] (std::exception_ptr) {
+
+				connection.reset();
+				destroyed=true;
+
+			}));
+			while (!destroyed) ios.run_one();
+
+			THEN("The connection is destroyed without waiting on itself") {
+
+				CHECK_FALSE(connection);
+
+			}
+
+		}
+
+	}
+
+}
+
+
+SCENARIO("ASIO PQ connections run operations without allocating once running","[asiopq][integration][connection][allocation]") {
+
+	GIVEN("An asiopq::connection which has already run operations") {
+
+		asiopq::asio::io_service ios;
+		std::chrono::milliseconds timeout(5000);
+		auto connect=make_connect(timeout);
+		auto f=connect->get_future();
+		auto connection=connect->connection(ios);
+		run_until_ready(ios,f);
+		f.get();
+
+		//	Every other operation has a timeout so that
+		//	scheduling and cancelling on the shared timer wheel
+		//	is included
+		const std::size_t n=100;
+		std::size_t completed=0;
+		std::exception_ptr ex;
+		std::vector<std::shared_ptr<callback_query>> queries;
+		for (std::size_t i=0;i<(2*n);++i) {
+
+			auto t=((i%2)==0) ? asiopq::operation::timeout_type{} : asiopq::operation::timeout_type(timeout);
+			queries.push_back(std::make_shared<callback_query>("SET application_name TO 'asiopq';",t,[&] (std::exception_ptr e) {
+
+				if (e && !ex) ex=e;
+				++completed;
+
+			}));
+
+		}
+		auto run=[&] (std::size_t begin, std::size_t end) {
+
+			for (auto i=begin;i<end;++i) {
+
+				auto before=completed;
+				connection.add(queries[i]);
+				while (completed==before) ios.run_one();
+
+			}
+
+		};
+		run(0,n);
+
+		WHEN("More operations are run one after another") {
+
+			auto before=allocations();
+			run(n,2*n);
+			auto after=allocations();
+
+			THEN("They succeed and nothing is allocated") {
+
+				CHECK_FALSE(ex);
+				CHECK(completed==(2*n));
+				CHECK(after==before);
+
+			}
+
+		}
+
+	}
+
+}
+
+
+SCENARIO("ASIO PQ statically dispatched queries behave as virtually dispatched queries","[asiopq][integration][connection][static_query]") {
+
+	GIVEN("An asiopq::connection") {
+
+		asiopq::asio::io_service ios;
+		std::chrono::milliseconds timeout(5000);
+		auto connect=make_connect(timeout);
+		auto f=connect->get_future();
+		auto connection=connect->connection(ios);
+		run_until_ready(ios,f);
+		f.get();
+
+		WHEN("The same statement is run repeatedly using each") {
+
+			const std::size_t n=2000;
+			//	Several results per query so that each is handled
+			//	by more than one call
+			const char * sql="SET application_name TO 'a'; SET application_name TO 'b'; SET application_name TO 'asiopq';";
+			std::size_t completed=0;
+			std::exception_ptr ex;
+			auto callback=[&] (std::exception_ptr e) {
+
+				if (e && !ex) ex=e;
+				++completed;
+
+			};
+			auto run=[&] (auto make) {
+
+				auto start=std::chrono::steady_clock::now();
+				for (std::size_t i=0;i<n;++i) {
+
+					auto before=completed;
+					connection.add(make());
+					while (completed==before) ios.run_one();
+
+				}
+
+				return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now()-start);
+
+			};
+			auto dynamic=run([&] () {	return std::make_shared<callback_query>(sql,timeout,callback);	});
+			auto dynamic_ex=ex;
+			ex=nullptr;
+			auto fixed=run([&] () {	return std::make_shared<static_callback_query>(sql,timeout,callback);	});
+
+			THEN("Both succeed") {
+
+				WARN("Ran " << n << " queries in " << dynamic.count() << "us dispatched virtually and " << fixed.count() << "us dispatched statically");
+				CHECK_FALSE(dynamic_ex);
+				CHECK_FALSE(ex);
+				CHECK(completed==(2*n));
+
+			}
+
+		}
+
+	}
+
+}
+
+
+SCENARIO("ASIO PQ connections report failures of operations which handle std::error_code values without exceptions","[asiopq][integration][connection][errc]") {
+
+	GIVEN("An asiopq::connection with a limit of two waiting operations") {
+
+		asiopq::asio::io_service ios;
+		std::chrono::milliseconds timeout(5000);
+		auto connect=make_connect(timeout);
+		auto f=connect->get_future();
+		auto connection=connect->connection(ios);
+		run_until_ready(ios,f);
+		f.get();
+		connection.limit(2);
+
+		WHEN("An operation with a short timeout waits behind a slow operation and another is rejected") {
+
+			auto slow=std::make_shared<command_query>("DO $$ BEGIN PERFORM pg_sleep(0.1); END $$;",timeout);
+			auto slow_f=slow->get_future();
+			auto impatient=std::make_shared<error_code_query>("SET application_name TO 'asiopq';",std::chrono::milliseconds(10));
+			auto rejected=std::make_shared<error_code_query>("SET application_name TO 'asiopq';",timeout);
+			std::error_code added;
+			std::error_code rejected_ec;
+			connection.add(slow,asiopq::priority::normal,added);
+			connection.add(impatient);
+			connection.add(rejected,asiopq::priority::normal,rejected_ec);
+			run_until_ready(ios,slow_f);
+			while (impatient->errors==0) ios.run_one();
+
+			THEN("The timeout and the rejection are reported as std::error_code values") {
+
+				CHECK_FALSE(added);
+				CHECK(rejected_ec==asiopq::errc::queue_full);
+				CHECK_NOTHROW(slow_f.get());
+				CHECK(impatient->errors==1);
+				CHECK(impatient->ec==asiopq::errc::timed_out);
+				CHECK(impatient->ec==std::errc::timed_out);
+				CHECK(rejected->errors==0);
+				CHECK(connection.statistics().rejected==1);
+
+			}
+
+		}
+
+		WHEN("The connection is destroyed while an operation is waiting") {
+
+			auto slow=std::make_shared<command_query>("DO $$ BEGIN PERFORM pg_sleep(0.1); END $$;",timeout);
+			auto waiting=std::make_shared<error_code_query>("SET application_name TO 'asiopq';",timeout);
+			connection.add(slow);
+			connection.add(waiting);
+			ios.poll();
+			{
+
+				auto destroyed=std::move(connection);
+
+			}
+
+			THEN("The operation is aborted without an exception") {
+
+				CHECK(waiting->errors==1);
+				CHECK(waiting->ec==asiopq::errc::aborted);
+
+			}
+
+		}
+
+	}
+
+}
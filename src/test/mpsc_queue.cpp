@@ -0,0 +1,232 @@
+#include <asiopq/mpsc_queue.hpp>
+
+
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <catch.hpp>
+
+
+SCENARIO("asiopq::mpsc_queue objects may be pushed onto by many threads and consumed in order","[asiopq][mpsc_queue]") {
+
+	GIVEN("An asiopq::mpsc_queue") {
+
+		asiopq::mpsc_queue<std::unique_ptr<int>> q;
+
+		THEN("It is empty") {
+
+			CHECK(q.empty());
+			CHECK(q.consume([] (std::unique_ptr<int>) {	})==0);
+
+		}
+
+		WHEN("Elements are pushed onto it") {
+
+			for (int i=0;i<3;++i) q.push(std::make_unique<int>(i));
+
+			THEN("It is not empty") {
+
+				CHECK_FALSE(q.empty());
+
+			}
+
+			AND_WHEN("It is consumed") {
+
+				std::vector<int> v;
+				auto n=q.consume([&] (std::unique_ptr<int> ptr) {	v.push_back(*ptr);	});
+
+				THEN("The elements are consumed in the order they were pushed") {
+
+					CHECK(n==3);
+					REQUIRE(v.size()==3);
+					CHECK(v[0]==0);
+					CHECK(v[1]==1);
+					CHECK(v[2]==2);
+					CHECK(q.empty());
+
+				}
+
+			}
+
+			AND_WHEN("It is consumed by a function which throws") {
+
+				std::size_t n=0;
+				auto func=[&] (std::unique_ptr<int>) {
+
+					if (++n==2) throw std::runtime_error("foo");
+
+				};
+
+				THEN("The exception is propagated and the remaining elements are discarded") {
+
+					CHECK_THROWS_AS(q.consume(func),std::runtime_error);
+					CHECK(n==2);
+					CHECK(q.empty());
+
+				}
+
+			}
+
+		}
+
+		WHEN("Several threads push onto it concurrently") {
+
+			const std::size_t threads=4;
+			const int per=1000;
+			std::vector<std::thread> ts;
+			for (std::size_t i=0;i<threads;++i) ts.emplace_back([&,i] () {
+
+				for (int j=0;j<per;++j) q.push(std::make_unique<int>(int(i)*per+j));
+
+			});
+			for (auto && t : ts) t.join();
+
+			THEN("Every element is consumed and each thread's elements are consumed in the order it pushed them") {
+
+				std::vector<int> last(threads,-1);
+				bool ordered=true;
+				auto n=q.consume([&] (std::unique_ptr<int> ptr) {
+
+					auto & l=last[*ptr/per];
+					if (*ptr<=l) ordered=false;
+					l=*ptr;
+
+				});
+				CHECK(n==threads*per);
+				CHECK(ordered);
+
+			}
+
+		}
+
+	}
+
+}
+
+
+namespace {
+
+
+	class node {
+
+
+		public:
+
+
+			int value;
+			node * next;
+
+
+	};
+
+
+	using intrusive_queue=asiopq::intrusive_mpsc_queue<node,&node::next>;
+
+
+}
+
+
+SCENARIO("asiopq::intrusive_mpsc_queue objects link elements without allocating and consume them in order","[asiopq][mpsc_queue]") {
+
+	GIVEN("An asiopq::intrusive_mpsc_queue") {
+
+		intrusive_queue q;
+		std::vector<node> nodes(3);
+		for (int i=0;i<3;++i) nodes[std::size_t(i)]=node{i,nullptr};
+
+		THEN("It is empty") {
+
+			CHECK(q.empty());
+			CHECK(q.consume([] (node &) {	})==0);
+
+		}
+
+		WHEN("Elements are pushed onto it and it is consumed") {
+
+			for (auto && n : nodes) q.push(n);
+			std::vector<int> v;
+			auto n=q.consume([&] (node & e) {	v.push_back(e.value);	});
+
+			THEN("The elements are consumed in the order they were pushed and unlinked") {
+
+				CHECK(n==3);
+				REQUIRE(v.size()==3);
+				CHECK(v[0]==0);
+				CHECK(v[1]==1);
+				CHECK(v[2]==2);
+				CHECK(q.empty());
+				for (auto && e : nodes) CHECK(e.next==nullptr);
+
+			}
+
+		}
+
+		WHEN("It is consumed by a function which throws and more elements are pushed") {
+
+			q.push(nodes[0]);
+			q.push(nodes[1]);
+			std::size_t calls=0;
+			auto func=[&] (node &) {
+
+				if (++calls==1) throw std::runtime_error("foo");
+
+			};
+			CHECK_THROWS_AS(q.consume(func),std::runtime_error);
+			q.push(nodes[2]);
+
+			THEN("The elements which were not consumed precede those pushed since") {
+
+				CHECK_FALSE(q.empty());
+				std::vector<int> v;
+				CHECK(q.consume([&] (node & e) {	v.push_back(e.value);	})==2);
+				REQUIRE(v.size()==2);
+				CHECK(v[0]==1);
+				CHECK(v[1]==2);
+				CHECK(q.empty());
+
+			}
+
+		}
+
+		WHEN("Several threads push onto it concurrently") {
+
+			const std::size_t threads=4;
+			const int per=1000;
+			std::vector<node> many(threads*std::size_t(per));
+			std::vector<std::thread> ts;
+			for (std::size_t i=0;i<threads;++i) ts.emplace_back([&,i] () {
+
+				for (int j=0;j<per;++j) {
+
+					auto & e=many[i*std::size_t(per)+std::size_t(j)];
+					e.value=int(i)*per+j;
+					q.push(e);
+
+				}
+
+			});
+			for (auto && t : ts) t.join();
+
+			THEN("Every element is consumed and each thread's elements are consumed in the order it pushed them") {
+
+				std::vector<int> last(threads,-1);
+				bool ordered=true;
+				auto n=q.consume([&] (node & e) {
+
+					auto & l=last[std::size_t(e.value/per)];
+					if (e.value<=l) ordered=false;
+					l=e.value;
+
+				});
+				CHECK(n==threads*std::size_t(per));
+				CHECK(ordered);
+
+			}
+
+		}
+
+	}
+
+}
@@ -0,0 +1,139 @@
+#include <asiopq/notifier.hpp>
+
+
+#include <libpq-fe.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <catch.hpp>
+
+
+namespace {
+
+
+	PGnotify make_notify (const char * channel, const char * payload) {
+
+		PGnotify retr{};
+		retr.relname=const_cast<char *>(channel);
+		retr.extra=const_cast<char *>(payload);
+
+		return retr;
+
+	}
+
+
+}
+
+
+SCENARIO("asiopq::notifier objects fan notifications out to the subscribers of each channel","[asiopq][notifier]") {
+
+	GIVEN("An asiopq::notifier") {
+
+		asiopq::notifier n;
+		std::vector<std::string> a;
+		std::vector<std::string> b;
+
+		THEN("It has no subscribers") {
+
+			CHECK(n.empty());
+			CHECK(n.size()==0);
+			CHECK_FALSE(n.listening("foo"));
+
+		}
+
+		WHEN("Two handlers subscribe to one channel and a third to another") {
+
+			asiopq::notifier::subscription_type a_id=0;
+			asiopq::notifier::subscription_type b_id=1;
+			n.subscribe(a_id,"foo",[&] (const PGnotify & notify) {	a.push_back(notify.extra);	});
+			n.subscribe(b_id,"foo",[&] (const PGnotify & notify) {	b.push_back(notify.extra);	});
+			n.subscribe(2,"bar",[&] (const PGnotify & notify) {	b.push_back(std::string("bar:")+notify.extra);	});
+
+			THEN("Both channels are listened to") {
+
+				CHECK(n.size()==2);
+				CHECK(n.listening("foo"));
+				CHECK(n.listening("bar"));
+				CHECK(n.channels().size()==2);
+
+			}
+
+			AND_WHEN("A notification is received on each channel and on an unknown channel") {
+
+				n.dispatch(make_notify("foo","1"));
+				n.dispatch(make_notify("bar","2"));
+				n.dispatch(make_notify("baz","3"));
+
+				THEN("Each subscriber receives the notifications on its channel") {
+
+					REQUIRE(a.size()==1);
+					CHECK(a[0]=="1");
+					REQUIRE(b.size()==2);
+					CHECK(b[0]=="1");
+					CHECK(b[1]=="bar:2");
+
+				}
+
+			}
+
+			AND_WHEN("One subscription to the shared channel ends") {
+
+				auto channel=n.unsubscribe(a_id);
+				n.dispatch(make_notify("foo","1"));
+
+				THEN("The channel is still listened to and only the other subscriber receives notifications") {
+
+					CHECK_FALSE(channel);
+					CHECK(n.listening("foo"));
+					CHECK(a.empty());
+					CHECK(b.size()==1);
+
+				}
+
+				AND_WHEN("The other ends") {
+
+					auto last=n.unsubscribe(b_id);
+
+					THEN("The channel is no longer listened to") {
+
+						REQUIRE(last);
+						CHECK(*last=="foo");
+						CHECK_FALSE(n.listening("foo"));
+						CHECK(n.size()==1);
+
+					}
+
+					AND_WHEN("It is ended again") {
+
+						THEN("Nothing happens") {
+
+							CHECK_FALSE(n.unsubscribe(b_id));
+							CHECK(n.size()==1);
+
+						}
+
+					}
+
+				}
+
+			}
+
+		}
+
+		WHEN("A handler throws") {
+
+			n.subscribe(0,"foo",[] (const PGnotify &) {	throw std::runtime_error("foo");	});
+			n.subscribe(1,"foo",[&] (const PGnotify & notify) {	a.push_back(notify.extra);	});
+
+			THEN("The other handlers are still invoked and the exception is rethrown") {
+
+				CHECK_THROWS_AS(n.dispatch(make_notify("foo","1")),std::runtime_error);
+				CHECK(a.size()==1);
+
+			}
+
+		}
+
+	}
+
+}
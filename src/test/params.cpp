@@ -0,0 +1,145 @@
+#include <asiopq/params.hpp>
+
+
+#include <asiopq/optional.hpp>
+#include <libpq-fe.h>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <catch.hpp>
+
+
+namespace {
+
+
+	std::vector<unsigned char> bytes (const char * ptr, int length) {
+
+		return std::vector<unsigned char>(ptr,ptr+length);
+
+	}
+
+
+	template <typename T>
+	std::vector<unsigned char> value (const T & p, std::size_t i) {
+
+		return bytes(p.values()[i],p.lengths()[i]);
+
+	}
+
+
+}
+
+
+SCENARIO("asiopq::params objects encode parameters in binary format","[asiopq][params]") {
+
+	GIVEN("An asiopq::params object containing integers, floating point numbers, and a boolean") {
+
+		asiopq::params<std::int16_t,std::int32_t,std::int64_t,float,double,bool> p(
+			std::int16_t(-2),
+			std::int32_t(0x01020304),
+			std::int64_t(1),
+			1.0f,
+			-2.0,
+			true
+		);
+
+		THEN("The types are determined at compile time") {
+
+			static_assert(p.count()==6,"");
+			CHECK(p.types()[0]==21);
+			CHECK(p.types()[1]==23);
+			CHECK(p.types()[2]==20);
+			CHECK(p.types()[3]==700);
+			CHECK(p.types()[4]==701);
+			CHECK(p.types()[5]==16);
+			for (int i=0;i<p.count();++i) CHECK(p.formats()[i]==1);
+
+		}
+
+		THEN("The values are encoded in network byte order") {
+
+			CHECK((value(p,0)==std::vector<unsigned char>{0xFF,0xFE}));
+			CHECK((value(p,1)==std::vector<unsigned char>{1,2,3,4}));
+			CHECK((value(p,2)==std::vector<unsigned char>{0,0,0,0,0,0,0,1}));
+			CHECK((value(p,3)==std::vector<unsigned char>{0x3F,0x80,0,0}));
+			CHECK((value(p,4)==std::vector<unsigned char>{0xC0,0,0,0,0,0,0,0}));
+			CHECK((value(p,5)==std::vector<unsigned char>{1}));
+
+		}
+
+		THEN("The values are stored contiguously") {
+
+			for (int i=1;i<p.count();++i) CHECK(p.values()[i]==(p.values()[i-1]+p.lengths()[i-1]));
+
+		}
+
+	}
+
+	GIVEN("An asiopq::params object containing text, bytea, a UUID, a timestamp, and NULLs") {
+
+		std::vector<unsigned char> data{0,1,2};
+		asiopq::uuid u{{{0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15}}};
+		std::chrono::system_clock::time_point t(std::chrono::seconds(946684800+1));
+		asiopq::params p(
+			"foo",
+			std::string("bar"),
+			asiopq::bytea(data),
+			u,
+			t,
+			asiopq::optional<int>{},
+			static_cast<const char *>(nullptr)
+		);
+
+		THEN("The types are determined at compile time") {
+
+			CHECK(p.types()[0]==25);
+			CHECK(p.types()[1]==25);
+			CHECK(p.types()[2]==17);
+			CHECK(p.types()[3]==2950);
+			CHECK(p.types()[4]==1184);
+			CHECK(p.types()[5]==23);
+			CHECK(p.types()[6]==25);
+
+		}
+
+		THEN("The values are encoded correctly") {
+
+			CHECK((value(p,0)==std::vector<unsigned char>{'f','o','o'}));
+			CHECK((value(p,1)==std::vector<unsigned char>{'b','a','r'}));
+			CHECK(value(p,2)==data);
+			CHECK((value(p,3)==std::vector<unsigned char>(u.bytes.begin(),u.bytes.end())));
+			CHECK((value(p,4)==std::vector<unsigned char>{0,0,0,0,0,0x0F,0x42,0x40}));
+			CHECK(p.values()[5]==nullptr);
+			CHECK(p.values()[6]==nullptr);
+
+		}
+
+		THEN("They may be described to an asiopq::prepared_query") {
+
+			asiopq::prepared_query::parameters d=p;
+			CHECK(d.count==7);
+			CHECK(d.types==p.types());
+			CHECK(d.values==p.values());
+			CHECK(d.lengths==p.lengths());
+			CHECK(d.formats==p.formats());
+
+		}
+
+	}
+
+	GIVEN("An asiopq::params object containing a large value") {
+
+		std::string s(asiopq::params<std::string>::small_size*2,'a');
+		asiopq::params<std::string> p(s);
+
+		THEN("The value is encoded correctly") {
+
+			REQUIRE(p.lengths()[0]==static_cast<int>(s.size()));
+			CHECK(std::string(p.values()[0],s.size())==s);
+
+		}
+
+	}
+
+}
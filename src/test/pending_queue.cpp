@@ -0,0 +1,253 @@
+#include <asiopq/pending_queue.hpp>
+
+
+#include <asiopq/operation.hpp>
+#include <asiopq/priority.hpp>
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <catch.hpp>
+
+
+namespace {
+
+
+	class dummy : public asiopq::operation {
+
+
+		public:
+
+
+			virtual operation_status begin (native_handle_type) override {
+
+				return operation_status::done;
+
+			}
+
+
+			virtual operation_status perform (native_handle_type, socket_status) override {
+
+				return operation_status::done;
+
+			}
+
+
+			virtual void complete (std::exception_ptr) override {	}
+
+
+			virtual timeout_type timeout () override {
+
+				return timeout_type{};
+
+			}
+
+
+	};
+
+
+}
+
+
+SCENARIO("asiopq::pending_queue objects serve higher classes first without starving lower classes","[asiopq][pending_queue]") {
+
+	GIVEN("An asiopq::pending_queue which ages operations every 100ms") {
+
+		asiopq::pending_queue q(std::chrono::milliseconds(100));
+		asiopq::pending_queue::time_point now;
+		auto batch=std::make_shared<dummy>();
+		auto normal=std::make_shared<dummy>();
+		auto interactive=std::make_shared<dummy>();
+		auto internal=std::make_shared<dummy>();
+
+		THEN("It is empty") {
+
+			CHECK(q.empty());
+			CHECK(q.size()==0);
+
+		}
+
+		WHEN("Operations of each class are enqueued at the same time, lowest class first") {
+
+			q.push_back(batch,asiopq::priority::batch,now);
+			q.push_back(normal,asiopq::priority::normal,now);
+			q.push_back(interactive,asiopq::priority::interactive,now);
+
+			THEN("They are removed highest class first") {
+
+				REQUIRE(q.size()==3);
+				CHECK(q.front(now)==interactive);
+				auto e=q.pop_front(now);
+				CHECK(e.op==interactive);
+				REQUIRE(e.cls);
+				CHECK(*e.cls==asiopq::priority::interactive);
+				CHECK(q.pop_front(now).op==normal);
+				CHECK(q.pop_front(now).op==batch);
+				CHECK(q.empty());
+
+			}
+
+			AND_WHEN("An operation is pushed onto the front") {
+
+				q.push_front(internal);
+
+				THEN("It is removed first and has no class") {
+
+					CHECK(q.size()==4);
+					auto e=q.pop_front(now);
+					CHECK(e.op==internal);
+					CHECK_FALSE(e.cls);
+					CHECK(q.front(now)==interactive);
+
+				}
+
+			}
+
+		}
+
+		WHEN("A batch operation has waited two aging intervals when an interactive operation is enqueued") {
+
+			q.push_back(batch,asiopq::priority::batch,now);
+			auto later=now+std::chrono::milliseconds(200);
+			q.push_back(interactive,asiopq::priority::interactive,later);
+
+			THEN("The batch operation, promoted to the interactive class and having waited longer, is removed first") {
+
+				CHECK(q.pop_front(later).op==batch);
+				CHECK(q.pop_front(later).op==interactive);
+
+			}
+
+		}
+
+		WHEN("A batch operation has waited one aging interval when a normal and an interactive operation are enqueued") {
+
+			q.push_back(batch,asiopq::priority::batch,now);
+			auto later=now+std::chrono::milliseconds(150);
+			q.push_back(normal,asiopq::priority::normal,later);
+			q.push_back(interactive,asiopq::priority::interactive,later);
+
+			THEN("The interactive operation is removed first and the batch operation before the normal operation") {
+
+				CHECK(q.pop_front(later).op==interactive);
+				CHECK(q.pop_front(later).op==batch);
+				CHECK(q.pop_front(later).op==normal);
+
+			}
+
+		}
+
+		WHEN("Aging is disabled and a batch operation has waited a long time") {
+
+			q.aging(asiopq::pending_queue::duration::zero());
+			q.push_back(batch,asiopq::priority::batch,now);
+			auto later=now+std::chrono::seconds(60);
+			q.push_back(normal,asiopq::priority::normal,later);
+
+			THEN("The higher class is still removed first") {
+
+				CHECK(q.pop_front(later).op==normal);
+				CHECK(q.pop_front(later).op==batch);
+
+			}
+
+		}
+
+		WHEN("Earliest deadline first ordering is enabled and operations of one class are enqueued with and without deadlines") {
+
+			auto early=std::make_shared<dummy>();
+			auto late=std::make_shared<dummy>();
+			auto never=std::make_shared<dummy>();
+			q.push_back(never,asiopq::priority::normal,now);
+			q.push_back(late,asiopq::priority::normal,now,now+std::chrono::seconds(2));
+			q.earliest_deadline_first(true);
+			q.push_back(early,asiopq::priority::normal,now,now+std::chrono::seconds(1));
+
+			THEN("They are removed in order of deadline, those without a deadline last") {
+
+				auto e=q.pop_front(now);
+				CHECK(e.op==early);
+				REQUIRE(e.deadline);
+				CHECK(*e.deadline==(now+std::chrono::seconds(1)));
+				CHECK(q.pop_front(now).op==late);
+				CHECK(q.pop_front(now).op==never);
+
+			}
+
+			AND_WHEN("It is disabled again") {
+
+				q.earliest_deadline_first(false);
+
+				THEN("They are removed in the order they were enqueued") {
+
+					CHECK(q.pop_front(now).op==never);
+					CHECK(q.pop_front(now).op==late);
+					CHECK(q.pop_front(now).op==early);
+
+				}
+
+			}
+
+		}
+
+		WHEN("Operations are enqueued and the queue is cleared") {
+
+			q.push_back(batch,asiopq::priority::batch,now);
+			q.push_front(internal);
+			std::size_t n=0;
+			q.for_each([&] (const asiopq::pending_queue::value_type &) {	++n;	});
+			q.clear();
+
+			THEN("Each was visited and none remain") {
+
+				CHECK(n==2);
+				CHECK(q.empty());
+
+			}
+
+			THEN("The queue no longer holds a reference to either") {
+
+				CHECK(batch.use_count()==1);
+				CHECK(internal.use_count()==1);
+
+			}
+
+		}
+
+		WHEN("Operations are enqueued and removed") {
+
+			q.push_back(batch,asiopq::priority::batch,now);
+			q.push_back(normal,asiopq::priority::normal,now);
+			q.push_front(internal);
+			auto before=normal.use_count();
+			auto e=q.pop_front(now);
+
+			THEN("The queue holds a reference to each until it is removed") {
+
+				CHECK(before==2);
+				CHECK(e.op==internal);
+				CHECK(internal.use_count()==2);
+				CHECK(batch.use_count()==2);
+
+			}
+
+			THEN("Destroying the queue releases the operations it holds") {
+
+				auto o=std::make_shared<dummy>();
+				{
+
+					asiopq::pending_queue other(std::chrono::milliseconds(100));
+					other.push_back(std::make_shared<dummy>(),asiopq::priority::normal,now);
+					other.push_back(o,asiopq::priority::normal,now);
+					REQUIRE(o.use_count()==2);
+
+				}
+				CHECK(o.use_count()==1);
+
+			}
+
+		}
+
+	}
+
+}
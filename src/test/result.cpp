@@ -0,0 +1,180 @@
+#include <asiopq/result.hpp>
+
+
+#include <asiopq/exception.hpp>
+#include <asiopq/optional.hpp>
+#include <libpq-fe.h>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <catch.hpp>
+
+
+namespace {
+
+
+	asiopq::result make_result (int format) {
+
+		auto res=PQmakeEmptyPGresult(nullptr,PGRES_TUPLES_OK);
+		if (!res) throw std::bad_alloc{};
+		asiopq::result retr(res);
+
+		char names [][4]={"a","b","c","d","e"};
+		PGresAttDesc attrs []={
+			{names[0],0,0,1,23,4,-1},
+			{names[1],0,0,1,25,-1,-1},
+			{names[2],0,0,1,701,8,-1},
+			{names[3],0,0,1,1184,8,-1},
+			{names[4],0,0,1,16,1,-1}
+		};
+		for (auto && attr : attrs) attr.format=format;
+		if (PQsetResultAttrs(res,5,attrs)==0) throw std::runtime_error("PQsetResultAttrs failed");
+
+		char row_0 [][8]={
+			{0,0,0,42},
+			{'f','o','o'},
+			{static_cast<char>(0xC0),0,0,0,0,0,0,0},
+			{0,0,0,0,0,0x0F,0x42,0x40},
+			{1}
+		};
+		int lengths []={4,3,8,8,1};
+		for (int i=0;i<5;++i) PQsetvalue(res,0,i,row_0[i],lengths[i]);
+
+		char minus_one []={
+			static_cast<char>(0xFF),
+			static_cast<char>(0xFF),
+			static_cast<char>(0xFF),
+			static_cast<char>(0xFF)
+		};
+		PQsetvalue(res,1,0,minus_one,4);
+		for (int i=1;i<5;++i) PQsetvalue(res,1,i,nullptr,-1);
+
+		return retr;
+
+	}
+
+
+}
+
+
+SCENARIO("asiopq::result objects decode fields in binary format","[asiopq][result]") {
+
+	GIVEN("An asiopq::result in binary format") {
+
+		auto r=make_result(1);
+
+		THEN("Fields may be decoded as the corresponding types") {
+
+			CHECK(r.rows()==2);
+			CHECK(r.columns()==5);
+			CHECK(r.get<std::int32_t>(0,0)==42);
+			CHECK(r.get<std::int64_t>(1,0)==-1);
+			CHECK(r.get<std::string>(0,1)=="foo");
+			CHECK(std::string(r.get<const char *>(0,1))=="foo");
+			CHECK(r.get<double>(0,2)==-2.0);
+			CHECK(r.get<std::chrono::system_clock::time_point>(0,3)==std::chrono::system_clock::time_point(std::chrono::seconds(946684800+1)));
+			CHECK(r.get<bool>(0,4));
+
+		}
+
+		THEN("NULL may only be decoded as an optional") {
+
+			CHECK(r.null(1,1));
+			CHECK_FALSE(r.get<asiopq::optional<std::string>>(1,1));
+			CHECK(*r.get<asiopq::optional<std::string>>(0,1)=="foo");
+			CHECK_THROWS_AS(r.get<std::string>(1,1),asiopq::decode_error);
+
+		}
+
+		THEN("Fields may not be decoded as other types") {
+
+			CHECK_THROWS_AS(r.get<std::int16_t>(0,0),asiopq::decode_error);
+			CHECK_THROWS_AS(r.get<std::string>(0,0),asiopq::decode_error);
+			CHECK_THROWS_AS(r.get<float>(0,2),asiopq::decode_error);
+
+		}
+
+		THEN("Bounds are checked") {
+
+			CHECK_THROWS_AS(r.get<std::int32_t>(2,0),std::out_of_range);
+			CHECK_THROWS_AS(r.get<std::int32_t>(0,5),std::out_of_range);
+			CHECK_THROWS_AS(r.null(-1,0),std::out_of_range);
+
+		}
+
+		WHEN("It is decoded as an asiopq::typed_result") {
+
+			using time_point=std::chrono::system_clock::time_point;
+			using optional_time_point=asiopq::optional<time_point>;
+			asiopq::typed_result<int,asiopq::optional<std::string>,asiopq::optional<double>,optional_time_point,asiopq::optional<bool>> t(std::move(r));
+
+			THEN("Every row is decoded") {
+
+				REQUIRE(t.size()==2);
+				CHECK(std::get<0>(t[0])==42);
+				CHECK(*std::get<1>(t[0])=="foo");
+				CHECK(*std::get<2>(t[0])==-2.0);
+				CHECK(*std::get<4>(t[0]));
+				CHECK(std::get<0>(t[1])==-1);
+				CHECK_FALSE(std::get<1>(t[1]));
+				CHECK_FALSE(std::get<3>(t[1]));
+				CHECK_THROWS_AS(t.at(2),std::out_of_range);
+
+			}
+
+		}
+
+		THEN("It may not be decoded as an asiopq::typed_result with the wrong columns") {
+
+			using wrong_count=asiopq::typed_result<int>;
+			using wrong_null=asiopq::typed_result<int,std::string,double,std::chrono::system_clock::time_point,bool>;
+			CHECK_THROWS_AS(wrong_count(std::move(r)),asiopq::decode_error);
+			CHECK_THROWS_AS(wrong_null(make_result(1)),asiopq::decode_error);
+
+		}
+
+	}
+
+	GIVEN("An asiopq::result which reports an error") {
+
+		auto res=PQmakeEmptyPGresult(nullptr,PGRES_FATAL_ERROR);
+		if (!res) throw std::bad_alloc{};
+		asiopq::result r(res);
+
+		THEN("It may not be decoded as an asiopq::typed_result") {
+
+			CHECK_THROWS_AS(asiopq::typed_result<int>(std::move(r)),asiopq::result_error);
+
+		}
+
+	}
+
+	GIVEN("An asiopq::result which does not contain rows") {
+
+		auto res=PQmakeEmptyPGresult(nullptr,PGRES_COMMAND_OK);
+		if (!res) throw std::bad_alloc{};
+		asiopq::result r(res);
+
+		THEN("It may not be decoded as an asiopq::typed_result") {
+
+			CHECK_THROWS_AS(asiopq::typed_result<int>(std::move(r)),asiopq::decode_error);
+
+		}
+
+	}
+
+	GIVEN("An asiopq::result in text format") {
+
+		auto r=make_result(0);
+
+		THEN("Fields may not be decoded") {
+
+			CHECK_THROWS_AS(r.get<std::int32_t>(0,0),asiopq::decode_error);
+
+		}
+
+	}
+
+}
@@ -0,0 +1,278 @@
+#pragma once
+
+
+#ifndef _WIN32
+
+
+#include <asiopq/asio.hpp>
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <system_error>
+
+
+/**
+ *	Impersonates a server on a Unix domain socket without
+ *	authentication.  Completes startup, answers every simple
+ *	query as if it were a SET command, and ignores the
+ *	extended query protocol (so that prepared queries time
+ *	out).
+ *
+ *	Once a connection has started the server does not
+ *	allocate, so that it may run on the same
+ *	asio::io_service as a connection whose allocations are
+ *	counted.
+ */
+class fake_server {
+
+
+	private:
+
+
+		using protocol=asiopq::asio::local::stream_protocol;
+
+
+		class session {
+
+
+			public:
+
+
+				protocol::socket socket;
+				std::array<char,512> buffer;
+				//	Received bytes which are yet to form a whole
+				//	message
+				std::string pending;
+
+
+				explicit session (asiopq::asio::io_service & ios) : socket(ios) {
+
+					pending.reserve(4096);
+
+				}
+
+
+		};
+
+
+		static bool cancel_request (const session & s, std::size_t bytes) noexcept {
+
+			//	CancelRequest is a length of 16 followed by the
+			//	code 80877102
+			const unsigned char code []={0,0,0,16,0x04,0xD2,0x16,0x2E};
+
+			return (bytes>=sizeof(code)) && (std::memcmp(s.buffer.data(),code,sizeof(code))==0);
+
+		}
+
+
+		std::string startup () const {
+
+			std::string retr;
+			auto message=[&] (char type, const std::string & body) {
+
+				retr.push_back(type);
+				auto len=body.size()+4;
+				for (int i=3;i>=0;--i) retr.push_back(char((len>>(i*8))&0xFF));
+				retr+=body;
+
+			};
+			auto parameter=[&] (const char * name, const char * value) {
+
+				std::string body(name);
+				body.push_back('\0');
+				body+=value;
+				body.push_back('\0');
+				message('S',body);
+
+			};
+
+			//	AuthenticationOk
+			message('R',std::string(4,'\0'));
+			parameter("server_version","15.0");
+			parameter("default_transaction_read_only",read_only_ ? "on" : "off");
+			parameter("in_hot_standby",read_only_ ? "on" : "off");
+			//	BackendKeyData
+			message('K',std::string(8,'\1'));
+			//	ReadyForQuery
+			message('Z',"I");
+
+			return retr;
+
+		}
+
+
+		//	Handles those messages which have been received in
+		//	full, returning false if the client terminated and
+		//	throwing if the client hung up
+		static bool handle (session & s) {
+
+			//	CommandComplete and ReadyForQuery
+			static const char reply []={'C',0,0,0,8,'S','E','T','\0','Z',0,0,0,5,'I'};
+
+			while (s.pending.size()>=5) {
+
+				std::size_t len=0;
+				for (std::size_t i=1;i<5;++i) len=(len<<8)|static_cast<unsigned char>(s.pending[i]);
+				if (s.pending.size()<(len+1)) break;
+
+				auto type=s.pending[0];
+				s.pending.erase(0,len+1);
+				if (type=='X') return false;
+
+				//	Writing synchronously avoids allocating a handler
+				if (type=='Q') asiopq::asio::write(s.socket,asiopq::asio::buffer(reply));
+
+			}
+
+			return true;
+
+		}
+
+
+		static void serve (std::shared_ptr<session> s) {
+
+			auto & self=*s;
+			self.socket.async_read_some(asiopq::asio::buffer(self.buffer),[s=std::move(s)] (const auto & ec, std::size_t bytes) mutable {
+
+				if (!ec) try {
+
+					s->pending.append(s->buffer.data(),bytes);
+					if (handle(*s)) {
+
+						serve(std::move(s));
+						return;
+
+					}
+
+				} catch (...) {	}
+
+				s->socket.close();
+
+			});
+
+		}
+
+
+		asiopq::asio::io_service & ios_;
+		std::string dir_;
+		protocol::acceptor acceptor_;
+		std::size_t accepted_;
+		bool read_only_;
+
+
+		void accept () {
+
+			auto s=std::make_shared<session>(ios_);
+			acceptor_.async_accept(s->socket,[this,s] (const auto & ec) {
+
+				if (ec) return;
+
+				++accepted_;
+
+				//	The startup packet is small enough to arrive
+				//	in one piece
+				s->socket.async_read_some(asiopq::asio::buffer(s->buffer),[this,s] (const auto & ec, std::size_t bytes) {
+
+					if (ec) return;
+
+					//	Cancellation is acknowledged by hanging up
+					if (cancel_request(*s,bytes)) {
+
+						s->socket.close();
+						return;
+
+					}
+
+					auto response=std::make_shared<std::string>(startup());
+					asiopq::asio::async_write(s->socket,asiopq::asio::buffer(*response),[s,response] (const auto & ec, std::size_t) {
+
+						if (!ec) serve(s);
+
+					});
+
+				});
+				accept();
+
+			});
+
+		}
+
+
+		static std::string make_dir () {
+
+			char tmpl []="/tmp/asiopq_XXXXXX";
+			if (!mkdtemp(tmpl)) throw std::system_error(std::error_code(errno,std::system_category()));
+
+			return tmpl;
+
+		}
+
+
+	public:
+
+
+		static constexpr const char * port="5999";
+
+
+		/**
+		 *	\param [in] ios
+		 *		The asio::io_service on which to accept and serve
+		 *		connections.
+		 *	\param [in] read_only
+		 *		Whether to claim to be a read only server, which
+		 *		libpq rejects if asked for a read-write session
+		 *		and moves on to the next host.
+		 */
+		fake_server (asiopq::asio::io_service & ios, bool read_only)
+			:	ios_(ios),
+				dir_(make_dir()),
+				acceptor_(ios,protocol::endpoint(dir_+"/.s.PGSQL."+port)),
+				accepted_(0),
+				read_only_(read_only)
+		{
+
+			accept();
+
+		}
+
+
+		~fake_server () noexcept {
+
+			acceptor_.close();
+			std::remove((dir_+"/.s.PGSQL."+port).c_str());
+			std::remove(dir_.c_str());
+
+		}
+
+
+		const std::string & dir () const noexcept {
+
+			return dir_;
+
+		}
+
+
+		std::size_t accepted () const noexcept {
+
+			return accepted_;
+
+		}
+
+
+		std::string conninfo () const {
+
+			return "host="+dir_+" port="+port+" sslmode=disable gssencmode=disable";
+
+		}
+
+
+};
+
+
+#endif
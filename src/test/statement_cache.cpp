@@ -0,0 +1,176 @@
+#include <asiopq/statement_cache.hpp>
+
+
+#include <string>
+#include <catch.hpp>
+
+
+SCENARIO("asiopq::statement_cache objects track prepared statements in least recently used order","[asiopq][statement_cache]") {
+
+	GIVEN("An asiopq::statement_cache with capacity for two statements") {
+
+		asiopq::statement_cache cache(2);
+
+		WHEN("A statement is used for the first time") {
+
+			REQUIRE_FALSE(cache.ready("SELECT 1"));
+			auto u=cache.use("SELECT 1");
+
+			THEN("It must be prepared") {
+
+				REQUIRE(u.name);
+				CHECK(u.prepare);
+
+			}
+
+			AND_WHEN("It is prepared and used again") {
+
+				std::string name=*u.name;
+				cache.prepared("SELECT 1");
+				auto u2=cache.use("SELECT 1");
+
+				THEN("It is executed under the same name without being prepared again") {
+
+					CHECK(cache.ready("SELECT 1"));
+					REQUIRE(u2.name);
+					CHECK_FALSE(u2.prepare);
+					CHECK(*u2.name==name);
+					CHECK(cache.size()==1);
+
+				}
+
+			}
+
+			AND_WHEN("Its preparation is abandoned and it is used again") {
+
+				std::string name=*u.name;
+				auto u2=cache.use("SELECT 1");
+
+				THEN("It is prepared under a new name and the old name must be deallocated") {
+
+					REQUIRE(u2.name);
+					CHECK(u2.prepare);
+					CHECK(*u2.name!=name);
+					auto garbage=cache.collect();
+					REQUIRE(garbage.size()==1);
+					CHECK(garbage[0]==name);
+
+				}
+
+			}
+
+			AND_WHEN("Its preparation is abandoned and it is evicted") {
+
+				std::string name=*u.name;
+				cache.use("SELECT 2");
+				cache.use("SELECT 3");
+
+				THEN("Its name must be deallocated") {
+
+					CHECK_FALSE(cache.ready("SELECT 1"));
+					auto garbage=cache.collect();
+					REQUIRE(garbage.size()==1);
+					CHECK(garbage[0]==name);
+
+				}
+
+			}
+
+			AND_WHEN("Preparing it fails") {
+
+				cache.erase("SELECT 1");
+
+				THEN("It must be prepared again on next use and nothing need be deallocated") {
+
+					CHECK(cache.size()==0);
+					CHECK(cache.use("SELECT 1").prepare);
+					CHECK(cache.collect().empty());
+
+				}
+
+			}
+
+		}
+
+		WHEN("More statements are prepared than fit") {
+
+			cache.use("SELECT 1");
+			cache.prepared("SELECT 1");
+			std::string name=*cache.use("SELECT 2").name;
+			cache.prepared("SELECT 2");
+			//	Makes SELECT 2 the least recently used
+			cache.use("SELECT 1");
+			cache.use("SELECT 3");
+			cache.prepared("SELECT 3");
+
+			THEN("The least recently used is evicted and must be deallocated") {
+
+				CHECK(cache.size()==2);
+				CHECK(cache.ready("SELECT 1"));
+				CHECK_FALSE(cache.ready("SELECT 2"));
+				CHECK(cache.ready("SELECT 3"));
+				auto garbage=cache.collect();
+				REQUIRE(garbage.size()==1);
+				CHECK(garbage[0]==name);
+				CHECK(cache.collect().empty());
+
+			}
+
+		}
+
+		WHEN("The cache is cleared") {
+
+			cache.use("SELECT 1");
+			cache.prepared("SELECT 1");
+			cache.clear();
+
+			THEN("Every statement must be prepared again and nothing need be deallocated") {
+
+				CHECK(cache.size()==0);
+				CHECK_FALSE(cache.ready("SELECT 1"));
+				CHECK(cache.collect().empty());
+
+			}
+
+		}
+
+	}
+
+	GIVEN("An asiopq::statement_cache which prepares statements on their third use") {
+
+		asiopq::statement_cache cache(2,3);
+
+		WHEN("A statement is used three times") {
+
+			auto u1=cache.use("SELECT 1");
+			auto u2=cache.use("SELECT 1");
+			REQUIRE_FALSE(cache.ready("SELECT 1"));
+			auto u3=cache.use("SELECT 1");
+
+			THEN("It is only prepared on the third use") {
+
+				CHECK_FALSE(u1.name);
+				CHECK_FALSE(u2.name);
+				REQUIRE(u3.name);
+				CHECK(u3.prepare);
+
+			}
+
+		}
+
+	}
+
+	GIVEN("An asiopq::statement_cache with no capacity") {
+
+		asiopq::statement_cache cache(0);
+
+		THEN("Statements are never prepared") {
+
+			CHECK(cache.ready("SELECT 1"));
+			CHECK_FALSE(cache.use("SELECT 1").name);
+
+		}
+
+	}
+
+}
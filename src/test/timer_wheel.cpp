@@ -0,0 +1,226 @@
+#include <asiopq/timer_wheel.hpp>
+
+
+#include "allocations.hpp"
+#include <asiopq/asio.hpp>
+#include <asiopq/scope.hpp>
+#include <chrono>
+#include <cstddef>
+#include <vector>
+#include <catch.hpp>
+
+
+SCENARIO("asiopq::timer_wheel objects expire entries in order and never early","[asiopq][timer_wheel]") {
+
+	GIVEN("An asiopq::timer_wheel") {
+
+		asiopq::asio::io_service ios;
+		auto & wheel=asiopq::asio::use_service<asiopq::timer_wheel>(ios);
+		using clock_type=asiopq::timer_wheel::clock_type;
+
+		std::vector<std::size_t> order;
+		std::vector<clock_type::duration> late;
+		auto start=clock_type::now();
+		auto make=[&] (asiopq::timer_wheel::entry & e, std::chrono::milliseconds after) {
+
+			e.function=[&,after] (std::size_t cookie) {
+
+				order.push_back(cookie);
+				late.push_back((clock_type::now()-start)-after);
+
+			};
+
+		};
+
+		THEN("It is empty") {
+
+			CHECK(wheel.size()==0);
+
+		}
+
+		WHEN("Entries are scheduled within and beyond the range of the lowest level") {
+
+			asiopq::timer_wheel::entry a;
+			asiopq::timer_wheel::entry b;
+			asiopq::timer_wheel::entry c;
+			make(a,std::chrono::milliseconds(150));
+			make(b,std::chrono::milliseconds(5));
+			make(c,std::chrono::milliseconds(40));
+			wheel.schedule(a,start+std::chrono::milliseconds(150),0);
+			wheel.schedule(b,start+std::chrono::milliseconds(5),1);
+			wheel.schedule(c,start+std::chrono::milliseconds(40),2);
+			auto g=asiopq::make_scope_exit([&] () noexcept {
+
+				wheel.cancel(a);
+				wheel.cancel(b);
+				wheel.cancel(c);
+
+			});
+
+			THEN("They are counted") {
+
+				CHECK(wheel.size()==3);
+
+			}
+
+			AND_WHEN("The asio::io_service is run") {
+
+				ios.run();
+
+				THEN("They expire in order of expiry and none expires early") {
+
+					REQUIRE(order.size()==3);
+					CHECK(order[0]==1);
+					CHECK(order[1]==2);
+					CHECK(order[2]==0);
+					for (auto && l : late) CHECK(l>=clock_type::duration::zero());
+					CHECK(wheel.size()==0);
+
+				}
+
+			}
+
+			AND_WHEN("One is cancelled and another rescheduled before the asio::io_service is run") {
+
+				wheel.cancel(c);
+				make(b,std::chrono::milliseconds(60));
+				wheel.schedule(b,start+std::chrono::milliseconds(60),3);
+				ios.run();
+
+				THEN("The cancelled entry does not expire and the other expires once with its new cookie") {
+
+					REQUIRE(order.size()==2);
+					CHECK(order[0]==3);
+					CHECK(order[1]==0);
+					for (auto && l : late) CHECK(l>=clock_type::duration::zero());
+
+				}
+
+			}
+
+		}
+
+		WHEN("Two entries expire together and whichever is invoked first cancels the other") {
+
+			asiopq::timer_wheel::entry a;
+			asiopq::timer_wheel::entry b;
+			a.function=[&] (std::size_t cookie) {
+
+				order.push_back(cookie);
+				wheel.cancel(b);
+
+			};
+			b.function=[&] (std::size_t cookie) {
+
+				order.push_back(cookie);
+				wheel.cancel(a);
+
+			};
+			wheel.schedule(a,start-std::chrono::milliseconds(10),8);
+			wheel.schedule(b,start-std::chrono::milliseconds(10),9);
+			auto g=asiopq::make_scope_exit([&] () noexcept {
+
+				wheel.cancel(a);
+				wheel.cancel(b);
+
+			});
+			ios.run();
+
+			THEN("The other is not invoked even though it had expired") {
+
+				CHECK(order.size()==1);
+
+			}
+
+		}
+
+		WHEN("An entry expires") {
+
+			class counter {
+
+
+				public:
+
+
+					std::size_t & copies;
+					std::vector<std::size_t> & order;
+
+
+					counter (std::size_t & copies, std::vector<std::size_t> & order) noexcept : copies(copies), order(order) {	}
+
+
+					counter (const counter & other) noexcept : copies(other.copies), order(other.order) {
+
+						++copies;
+
+					}
+
+
+					counter (counter &&) = default;
+
+
+					void operator () (std::size_t cookie) const {
+
+						order.push_back(cookie);
+
+					}
+
+
+			};
+
+			std::size_t copies=0;
+			asiopq::timer_wheel::entry e;
+			e.function=counter(copies,order);
+			copies=0;
+			wheel.schedule(e,start,10);
+			auto g=asiopq::make_scope_exit([&] () noexcept {	wheel.cancel(e);	});
+			ios.run();
+
+			THEN("Its function is invoked without being copied") {
+
+				REQUIRE(order.size()==1);
+				CHECK(order[0]==10);
+				CHECK(copies==0);
+
+			}
+
+			AND_WHEN("It is scheduled to expire again") {
+
+				order.reserve(2);
+				wheel.schedule(e,clock_type::now(),11);
+				ios.restart();
+				auto before=allocations();
+				ios.run();
+				auto after=allocations();
+
+				THEN("Nothing is allocated") {
+
+					REQUIRE(order.size()==2);
+					CHECK(order[1]==11);
+					CHECK(after==before);
+
+				}
+
+			}
+
+		}
+
+		WHEN("An entry is scheduled in the past") {
+
+			asiopq::timer_wheel::entry e;
+			make(e,std::chrono::milliseconds(0));
+			wheel.schedule(e,start-std::chrono::milliseconds(10),7);
+			ios.run();
+
+			THEN("It expires as soon as possible") {
+
+				REQUIRE(order.size()==1);
+				CHECK(order[0]==7);
+
+			}
+
+		}
+
+	}
+
+}
@@ -0,0 +1,311 @@
+#include <asiopq/asio.hpp>
+#include <asiopq/scope.hpp>
+#include <asiopq/timer_wheel.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+
+namespace asiopq {
+
+
+	asio::io_service::id timer_wheel::id;
+
+
+	timer_wheel::entry::entry () noexcept : prev_(nullptr), next_(nullptr), slot_(nullptr), expiry_(0), cookie_(0) {	}
+
+
+	std::uint64_t timer_wheel::tick (time_point when) const noexcept {
+
+		if (when<=start_) return 0;
+
+		return std::uint64_t(std::chrono::duration_cast<std::chrono::milliseconds>(when-start_).count())/std::uint64_t(resolution.count());
+
+	}
+
+
+	void timer_wheel::link (entry & e) noexcept {
+
+		//	Entries are placed according to how far in the
+		//	future they expire, each level spanning slots
+		//	times the range of the level below it
+		auto delta=(e.expiry_>now_) ? (e.expiry_-now_) : 0;
+		std::size_t level=0;
+		while ((level<(levels-1)) && (delta>=(std::uint64_t(1)<<(bits*(level+1))))) ++level;
+		//	Entries beyond the range of the top level wait in
+		//	its furthest slot and are placed again when that
+		//	slot is cascaded
+		auto max=(std::uint64_t(1)<<(bits*levels))-1;
+		auto at=(delta>max) ? (now_+max) : e.expiry_;
+		auto & head=slots_[level][(at>>(bits*level))&(slots-1)];
+
+		e.prev_=nullptr;
+		e.next_=head;
+		e.slot_=&head;
+		if (head) head->prev_=&e;
+		head=&e;
+
+	}
+
+
+	void timer_wheel::unlink (entry & e) noexcept {
+
+		if (&e==last_) last_=e.prev_;
+		if (e.prev_) e.prev_->next_=e.next_;
+		else *e.slot_=e.next_;
+		if (e.next_) e.next_->prev_=e.prev_;
+
+		e.prev_=nullptr;
+		e.next_=nullptr;
+		e.slot_=nullptr;
+
+	}
+
+
+	void timer_wheel::cascade (std::size_t level) noexcept {
+
+		auto & head=slots_[level][(now_>>(bits*level))&(slots-1)];
+		auto e=head;
+		head=nullptr;
+		while (e) {
+
+			auto next=e->next_;
+			link(*e);
+			e=next;
+
+		}
+
+	}
+
+
+	void timer_wheel::advance (std::uint64_t to) {
+
+		while (now_<to) {
+
+			++now_;
+
+			//	When a level wraps the next slot of the level
+			//	above is distributed into the levels below
+			for (std::size_t level=1;level<levels;++level) {
+
+				if ((now_&((std::uint64_t(1)<<(bits*level))-1))!=0) break;
+				cascade(level);
+
+			}
+
+			auto & head=slots_[0][now_&(slots-1)];
+			while (head) {
+
+				auto & e=*head;
+				unlink(e);
+				--size_;
+				if (!e.function) continue;
+
+				//	Appended so that functions are invoked in order
+				//	of expiry
+				e.prev_=last_;
+				e.next_=nullptr;
+				e.slot_=&fired_;
+				if (last_) last_->next_=&e;
+				else fired_=&e;
+				last_=&e;
+
+			}
+
+		}
+
+	}
+
+
+	void timer_wheel::arm () {
+
+		if ((size_==0) || shutdown_) {
+
+			armed_=false;
+			return;
+
+		}
+
+		//	Sleep until the next occupied slot of the lowest
+		//	level or until the lowest level wraps, whichever
+		//	is sooner
+		auto wake=now_+1;
+		for (;(wake&(slots-1))!=0;++wake) if (slots_[0][wake&(slots-1)]) break;
+
+		if (armed_ && (wake_<=wake)) return;
+
+		armed_=true;
+		wake_=wake;
+		auto generation=++generation_;
+		timer_.expires_at(start_+(resolution*wake));
+		timer_.async_wait([this,generation] (const auto &) {	expire(generation);	});
+
+	}
+
+
+	void timer_wheel::expire (std::size_t generation) {
+
+		std::unique_lock<std::mutex> l(mutex_);
+
+		//	Superseded by an earlier wake up
+		if (generation!=generation_) return;
+
+		armed_=false;
+		advance(tick(clock_type::now()));
+		arm();
+
+		//	Each entry is taken from the list separately so that
+		//	one cancelled in the meantime is not invoked, and
+		//	while its function is invoked the record on the stack
+		//	makes cancel wait rather than let the entry be
+		//	destroyed
+		std::exception_ptr ex;
+		invocation i;
+		i.thread=std::this_thread::get_id();
+		while (fired_) {
+
+			auto & e=*fired_;
+			unlink(e);
+			auto cookie=e.cookie_;
+			i.e=&e;
+			i.next=invocations_;
+			invocations_=&i;
+			l.unlock();
+
+			try {
+
+				e.function(cookie);
+
+			} catch (...) {
+
+				if (!ex) ex=std::current_exception();
+
+			}
+
+			l.lock();
+			auto curr=&invocations_;
+			while (*curr!=&i) curr=&(*curr)->next;
+			*curr=i.next;
+			invoked_.notify_all();
+
+		}
+
+		l.unlock();
+
+		if (ex) std::rethrow_exception(ex);
+
+	}
+
+
+	void timer_wheel::shutdown () {
+
+		std::lock_guard<std::mutex> l(mutex_);
+
+		shutdown_=true;
+		for (auto && level : slots_) for (auto && head : level) {
+
+			while (head) unlink(*head);
+
+		}
+		size_=0;
+		while (fired_) unlink(*fired_);
+
+		try {
+
+			timer_.cancel();
+
+		} catch (...) {	}
+
+	}
+
+
+	timer_wheel::timer_wheel (asio::io_service & ios)
+		:	asio::io_service::service(ios),
+			timer_(ios),
+			start_(clock_type::now()),
+			now_(0),
+			wake_(0),
+			generation_(0),
+			armed_(false),
+			shutdown_(false),
+			size_(0),
+			slots_{},
+			fired_(nullptr),
+			last_(nullptr),
+			invocations_(nullptr)
+	{	}
+
+
+	void timer_wheel::schedule (entry & e, time_point when, std::size_t cookie) {
+
+		std::lock_guard<std::mutex> l(mutex_);
+
+		if (shutdown_) return;
+
+		//	An entry which expired but has not been invoked is
+		//	superseded
+		if (e.slot_) {
+
+			if (e.slot_!=&fired_) --size_;
+			unlink(e);
+
+		}
+
+		//	If there's nothing on the wheel it may not have
+		//	been advanced for some time
+		if (size_==0) now_=tick(clock_type::now());
+
+		//	Rounding up guarantees that entries do not expire
+		//	early
+		auto t=tick(when);
+		if ((start_+(resolution*t))<when) ++t;
+		e.expiry_=(t>now_) ? t : (now_+1);
+		e.cookie_=cookie;
+		link(e);
+		++size_;
+
+		arm();
+
+	}
+
+
+	void timer_wheel::cancel (entry & e) noexcept {
+
+		std::unique_lock<std::mutex> l(mutex_);
+
+		if (e.slot_) {
+
+			if (e.slot_!=&fired_) --size_;
+			unlink(e);
+
+		}
+
+		//	Entries are usually cancelled by their owners prior to
+		//	destruction so they must not be in use, unless this is
+		//	the thread using them
+		auto id=std::this_thread::get_id();
+		for (;;) {
+
+			auto i=invocations_;
+			while (i && ((i->e!=&e) || (i->thread==id))) i=i->next;
+			if (!i) break;
+			invoked_.wait(l);
+
+		}
+
+	}
+
+
+	std::size_t timer_wheel::size () const noexcept {
+
+		std::lock_guard<std::mutex> l(mutex_);
+
+		return size_;
+
+	}
+
+
+}